@@ -25,6 +25,7 @@ int main(int, char* argv[])
 	cgp_test::test_grid_stack_2D();
 	cgp_test::test_grid_2D();
 	cgp_test::test_grid_3D();
+	cgp_test::test_grid_layout();
 	cgp_test::test_numarray();
 	cgp_test::test_numarray_stack();
 	cgp_test::test_camera_controller();
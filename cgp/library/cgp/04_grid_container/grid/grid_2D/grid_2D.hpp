@@ -3,6 +3,7 @@
 #include "cgp/01_base/base.hpp"
 #include "cgp/02_numarray/numarray.hpp"
 #include "../../offset_grid/offset_grid.hpp"
+#include "../grid_layout/grid_layout.hpp"
 
 
 
@@ -18,8 +19,10 @@ namespace cgp
  * The grid_2D structure provide convenient access for 2D-grid organization where an element can be queried as grid_2D(i,j).
  * The indexing is obtained as grid_2D(k1,k2) = k1 + N1*k2
  * Elements of grid_2D are stored contiguously in heap memory and remain fully compatible with std::vector and pointers.
+ * The optional layout parameter changes the order of the elements in data (padded rows, tiles, Morton order - see grid_layout.hpp).
+ *   With a non-linear layout, data may hold more than size() elements and should be accessed through grid_2D(k1,k2) or index_to_offset.
  **/
-template <typename T>
+template <typename T, typename layout = grid_layout_linear>
 struct grid_2D
 {
     /** 2D dimension (Nx,Ny) of the container */
@@ -34,8 +37,8 @@ struct grid_2D
     grid_2D(int size_1, int size_2);  // Build a grid_2D with specified dimension
 
     /** Direct build a grid_2D from a given 1D-buffer and its 2D-dimension
-    * \note: the size of the 1D-buffer must satisfy arg.size = size_1 * size_2 */
-    static grid_2D<T> from_buffer(numarray<T> const& arg, int size_1, int size_2);
+    * \note: the size of the 1D-buffer must satisfy arg.size = size_1 * size_2, its elements are in the linear order k1 + N1*k2 */
+    static grid_2D<T, layout> from_buffer(numarray<T> const& arg, int size_1, int size_2);
 
 
     /** Remove all elements from the grid_2D */
@@ -65,8 +68,13 @@ struct grid_2D
     int index_to_offset(int k1, int k2) const;
     int2 offset_to_index(int offset) const;
 
+    /** Tiles covering the grid, to walk it block by block (see grid_tiles_2D)
+     * The default tile size is the one of the layout: tiles of contiguous elements in memory (rows for the linear layout). */
+    grid_tiles_2D tiles() const;
+    grid_tiles_2D tiles(int2 const& tile_size) const;
+
     /** Iterators
-     * 1D-type iterators on grid_2D are compatible with STL syntax
+     * 1D-type iterators on grid_2D are compatible with STL syntax (in the storage order of the layout, including its padding elements)
      * allows "forall" loops (for(auto& e : buffer) {...}) */
     typename std::vector<T>::iterator begin();
     typename std::vector<T>::iterator end();
@@ -83,46 +91,46 @@ struct grid_2D
 };
 
 
-template <typename T> std::string type_str(grid_2D<T> const&);
+template <typename T, typename layout> std::string type_str(grid_2D<T, layout> const&);
 
 /** Display all elements of the buffer.*/
-template <typename T> std::ostream& operator<<(std::ostream& s, grid_2D<T> const& v);
+template <typename T, typename layout> std::ostream& operator<<(std::ostream& s, grid_2D<T, layout> const& v);
 
 /** Convert all elements of the buffer to a string.
  * \param buffer: the input buffer
  * \param separator: the separator between each element
  */
-template <typename T> std::string str(grid_2D<T> const& v, std::string const& separator=" ", std::string const& begin = "", std::string const& end = "");
+template <typename T, typename layout> std::string str(grid_2D<T, layout> const& v, std::string const& separator=" ", std::string const& begin = "", std::string const& end = "");
 
 
 /** Equality test between grid_2D */
-template <typename T1, typename T2> bool is_equal(grid_2D<T1> const& a, grid_2D<T2> const& b);
+template <typename T1, typename T2, typename layout> bool is_equal(grid_2D<T1, layout> const& a, grid_2D<T2, layout> const& b);
 
 /** Math operators
  * Common mathematical operations between buffers, and scalar or element values. */
-template <typename T> grid_2D<T>& operator+=(grid_2D<T>& a, grid_2D<T> const& b);
+template <typename T, typename layout> grid_2D<T, layout>& operator+=(grid_2D<T, layout>& a, grid_2D<T, layout> const& b);
 
-template <typename T> grid_2D<T>& operator+=(grid_2D<T>& a, T const& b);
-template <typename T> grid_2D<T>  operator+(grid_2D<T> const& a, grid_2D<T> const& b);
-template <typename T> grid_2D<T>  operator+(grid_2D<T> const& a, T const& b);
-template <typename T> grid_2D<T>  operator+(T const& a, grid_2D<T> const& b);
+template <typename T, typename layout> grid_2D<T, layout>& operator+=(grid_2D<T, layout>& a, T const& b);
+template <typename T, typename layout> grid_2D<T, layout>  operator+(grid_2D<T, layout> const& a, grid_2D<T, layout> const& b);
+template <typename T, typename layout> grid_2D<T, layout>  operator+(grid_2D<T, layout> const& a, T const& b);
+template <typename T, typename layout> grid_2D<T, layout>  operator+(T const& a, grid_2D<T, layout> const& b);
 
-template <typename T> grid_2D<T>& operator-=(grid_2D<T>& a, grid_2D<T> const& b);
-template <typename T> grid_2D<T>& operator-=(grid_2D<T>& a, T const& b);
-template <typename T> grid_2D<T>  operator-(grid_2D<T> const& a, grid_2D<T> const& b);
-template <typename T> grid_2D<T>  operator-(grid_2D<T> const& a, T const& b);
-template <typename T> grid_2D<T>  operator-(T const& a, grid_2D<T> const& b);
+template <typename T, typename layout> grid_2D<T, layout>& operator-=(grid_2D<T, layout>& a, grid_2D<T, layout> const& b);
+template <typename T, typename layout> grid_2D<T, layout>& operator-=(grid_2D<T, layout>& a, T const& b);
+template <typename T, typename layout> grid_2D<T, layout>  operator-(grid_2D<T, layout> const& a, grid_2D<T, layout> const& b);
+template <typename T, typename layout> grid_2D<T, layout>  operator-(grid_2D<T, layout> const& a, T const& b);
+template <typename T, typename layout> grid_2D<T, layout>  operator-(T const& a, grid_2D<T, layout> const& b);
 
-template <typename T> grid_2D<T>& operator*=(grid_2D<T>& a, grid_2D<T> const& b);
-template <typename T> grid_2D<T>& operator*=(grid_2D<T>& a, float b);
-template <typename T> grid_2D<T>  operator*(grid_2D<T> const& a, grid_2D<T> const& b);
-template <typename T> grid_2D<T>  operator*(grid_2D<T> const& a, float b);
-template <typename T> grid_2D<T>  operator*(float a, grid_2D<T> const& b);
+template <typename T, typename layout> grid_2D<T, layout>& operator*=(grid_2D<T, layout>& a, grid_2D<T, layout> const& b);
+template <typename T, typename layout> grid_2D<T, layout>& operator*=(grid_2D<T, layout>& a, float b);
+template <typename T, typename layout> grid_2D<T, layout>  operator*(grid_2D<T, layout> const& a, grid_2D<T, layout> const& b);
+template <typename T, typename layout> grid_2D<T, layout>  operator*(grid_2D<T, layout> const& a, float b);
+template <typename T, typename layout> grid_2D<T, layout>  operator*(float a, grid_2D<T, layout> const& b);
 
-template <typename T> grid_2D<T>& operator/=(grid_2D<T>& a, grid_2D<T> const& b);
-template <typename T> grid_2D<T>& operator/=(grid_2D<T>& a, float b);
-template <typename T> grid_2D<T>  operator/(grid_2D<T> const& a, grid_2D<T> const& b);
-template <typename T> grid_2D<T>  operator/(grid_2D<T> const& a, float b);
+template <typename T, typename layout> grid_2D<T, layout>& operator/=(grid_2D<T, layout>& a, grid_2D<T, layout> const& b);
+template <typename T, typename layout> grid_2D<T, layout>& operator/=(grid_2D<T, layout>& a, float b);
+template <typename T, typename layout> grid_2D<T, layout>  operator/(grid_2D<T, layout> const& a, grid_2D<T, layout> const& b);
+template <typename T, typename layout> grid_2D<T, layout>  operator/(grid_2D<T, layout> const& a, float b);
 
 
 
@@ -139,79 +147,79 @@ namespace cgp
 
 
 
-template <typename T>
-grid_2D<T>::grid_2D()
+template <typename T, typename layout>
+grid_2D<T, layout>::grid_2D()
     :dimension(int2{0,0}),data()
 {}
 
-template <typename T>
-grid_2D<T>::grid_2D(int size)
-    :dimension({size,size}),data(size*size)
+template <typename T, typename layout>
+grid_2D<T, layout>::grid_2D(int size)
+    :dimension({size,size}),data(layout::storage_size(int2{size,size}))
 {
     assert_cgp_no_msg(size>0);
 }
 
-template <typename T>
-grid_2D<T>::grid_2D(int2 const& size)
-    :dimension(size),data(size[0]*size[1])
+template <typename T, typename layout>
+grid_2D<T, layout>::grid_2D(int2 const& size)
+    :dimension(size),data(layout::storage_size(size))
 {
     assert_cgp_no_msg(size[0]>=0 && size[1]>=0);
 }
 
-template <typename T>
-grid_2D<T>::grid_2D(int size_1, int size_2)
-    :dimension({size_1,size_2}),data(size_1*size_2)
+template <typename T, typename layout>
+grid_2D<T, layout>::grid_2D(int size_1, int size_2)
+    :dimension({size_1,size_2}),data(layout::storage_size(int2{size_1,size_2}))
 {
     assert_cgp_no_msg(size_1>=0 && size_2>=0);
 }
 
 
 
-template <typename T>
-int grid_2D<T>::size() const
+template <typename T, typename layout>
+int grid_2D<T, layout>::size() const
 {
     return dimension[0]*dimension[1];
 }
 
-template <typename T>
-void grid_2D<T>::clear()
+template <typename T, typename layout>
+void grid_2D<T, layout>::clear()
 {
     resize(0, 0);
 }
 
-template <typename T>
-void grid_2D<T>::resize(int size)
+template <typename T, typename layout>
+void grid_2D<T, layout>::resize(int size)
 {
     assert_cgp_no_msg(size>=0);
     resize(size,size);
 }
 
-template <typename T>
-void grid_2D<T>::resize(int2 const& size)
+template <typename T, typename layout>
+void grid_2D<T, layout>::resize(int2 const& size)
 {
     assert_cgp_no_msg(size[0]>=0 && size[1]>=0);
     dimension = size;
-    data.resize(size[0]*size[1]);
+    data.resize(layout::storage_size(size));
 }
 
-template <typename T>
-void grid_2D<T>::resize(int size_1, int size_2)
+template <typename T, typename layout>
+void grid_2D<T, layout>::resize(int size_1, int size_2)
 {
     assert_cgp_no_msg(size_1>=0 && size_2>=0);
     dimension = {size_1,size_2};
     resize({size_1,size_2});
 }
 
-template <typename T>
-void grid_2D<T>::fill(T const& value)
+template <typename T, typename layout>
+void grid_2D<T, layout>::fill(T const& value)
 {
     data.fill(value);
 }
 
 
 #ifndef CGP_NO_DEBUG
-template <typename T>
-void check_index_bounds(int index1, int index2, grid_2D<T> const& data)
+template <typename T, typename layout>
+void check_index_bounds(int index1, int index2, grid_2D<T, layout> const& data)
 {
     size_t const N1 = data.dimension.x;
     size_t const N2 = data.dimension.y;
@@ -249,56 +257,56 @@ void check_index_bounds(int index1, int index2, grid_2D<T> const& data)
     }
 }
 #else
-template <typename T>
-void check_index_bounds(int , int , grid_2D<T> const& ) {}
+template <typename T, typename layout>
+void check_index_bounds(int , int , grid_2D<T, layout> const& ) {}
 #endif
 
 
 
-template <typename T>
-T const& grid_2D<T>::operator[](int2 const& index) const
+template <typename T, typename layout>
+T const& grid_2D<T, layout>::operator[](int2 const& index) const
 {
     check_index_bounds(index.x, index.y, *this);
-    int const idx = offset_grid(index.x, index.y, dimension.x);
+    int const idx = layout::offset(index.x, index.y, dimension);
     return data[idx];
 }
 
-template <typename T>
-T& grid_2D<T>::operator[](int2 const& index)
+template <typename T, typename layout>
+T& grid_2D<T, layout>::operator[](int2 const& index)
 {
     check_index_bounds(index.x, index.y, *this);
-    int const idx = offset_grid(index.x, index.y, dimension.x);
+    int const idx = layout::offset(index.x, index.y, dimension);
 
     return data[idx];
 }
 
-template <typename T>
-T const& grid_2D<T>::operator()(int2 const& index) const
+template <typename T, typename layout>
+T const& grid_2D<T, layout>::operator()(int2 const& index) const
 {
     return (*this)[index];
 }
 
-template <typename T>
-T& grid_2D<T>::operator()(int2 const& index)
+template <typename T, typename layout>
+T& grid_2D<T, layout>::operator()(int2 const& index)
 {
     return (*this)[index];
 }
 
 
-template <typename T>
-T const& grid_2D<T>::operator()(int k1, int k2) const
+template <typename T, typename layout>
+T const& grid_2D<T, layout>::operator()(int k1, int k2) const
 {
     check_index_bounds(k1, k2, *this);
-    int const idx = offset_grid(k1, k2, dimension.x);
+    int const idx = layout::offset(k1, k2, dimension);
 
     return data[idx];
 }
 
-template <typename T>
-T& grid_2D<T>::operator()(int k1, int k2)
+template <typename T, typename layout>
+T& grid_2D<T, layout>::operator()(int k1, int k2)
 {
     check_index_bounds(k1, k2, *this);
-    int const idx = offset_grid(k1, k2, dimension.x);
+    int const idx = layout::offset(k1, k2, dimension);
 
     return data[idx];
 }
@@ -306,38 +314,38 @@ T& grid_2D<T>::operator()(int k1, int k2)
 
 
 
-template <typename T>
-typename std::vector<T>::iterator grid_2D<T>::begin()
+template <typename T, typename layout>
+typename std::vector<T>::iterator grid_2D<T, layout>::begin()
 {
     return data.begin();
 }
 
-template <typename T>
-typename std::vector<T>::iterator grid_2D<T>::end()
+template <typename T, typename layout>
+typename std::vector<T>::iterator grid_2D<T, layout>::end()
 {
     return data.end();
 }
 
-template <typename T>
-typename std::vector<T>::const_iterator grid_2D<T>::begin() const
+template <typename T, typename layout>
+typename std::vector<T>::const_iterator grid_2D<T, layout>::begin() const
 {
     return data.begin();
 }
 
-template <typename T>
-typename std::vector<T>::const_iterator grid_2D<T>::end() const
+template <typename T, typename layout>
+typename std::vector<T>::const_iterator grid_2D<T, layout>::end() const
 {
     return data.end();
 }
 
-template <typename T>
-typename std::vector<T>::const_iterator grid_2D<T>::cbegin() const
+template <typename T, typename layout>
+typename std::vector<T>::const_iterator grid_2D<T, layout>::cbegin() const
 {
     return data.cbegin();
 }
 
-template <typename T>
-typename std::vector<T>::const_iterator grid_2D<T>::cend() const
+template <typename T, typename layout>
+typename std::vector<T>::const_iterator grid_2D<T, layout>::cend() const
 {
     return data.cend();
 }
@@ -351,13 +359,13 @@ typename std::vector<T>::const_iterator grid_2D<T>::cend() const
 
 
 
-template <typename T> std::string type_str(grid_2D<T> const&)
+template <typename T, typename layout> std::string type_str(grid_2D<T, layout> const&)
 {
-    return "grid_2D<" + type_str(T()) + ">";
+    return "grid_2D<" + type_str(T()) + (layout::is_linear ? "" : "," + layout::name()) + ">";
 }
 
 
-template <typename T1, typename T2> bool is_equal(grid_2D<T1> const& a, grid_2D<T2> const& b)
+template <typename T1, typename T2, typename layout> bool is_equal(grid_2D<T1, layout> const& a, grid_2D<T2, layout> const& b)
 {
     if (is_equal(a.dimension, b.dimension)==false)
         return false;
@@ -367,155 +375,172 @@ template <typename T1, typename T2> bool is_equal(grid_2D<T1> const& a, grid_2D<
 
 
 
-template <typename T> std::ostream& operator<<(std::ostream& s, grid_2D<T> const& v)
+template <typename T, typename layout> std::ostream& operator<<(std::ostream& s, grid_2D<T, layout> const& v)
 {
     return s << v.data;
 }
-template <typename T> std::string str(grid_2D<T> const& v, std::string const& separator, std::string const& begin, std::string const& end)
+template <typename T, typename layout> std::string str(grid_2D<T, layout> const& v, std::string const& separator, std::string const& begin, std::string const& end)
 {
     return to_string(v.data, separator, begin, end);
 }
 
 
-template <typename T> grid_2D<T>& operator+=(grid_2D<T>& a, grid_2D<T> const& b)
+template <typename T, typename layout> grid_2D<T, layout>& operator+=(grid_2D<T, layout>& a, grid_2D<T, layout> const& b)
 {
     assert_cgp( is_equal(a.dimension,b.dimension), "Dimension do not agree: a:"+str(a.dimension)+", b:"+str(b.dimension) );
     a.data += b.data;
 }
-template <typename T> grid_2D<T>& operator+=(grid_2D<T>& a, T const& b)
+template <typename T, typename layout> grid_2D<T, layout>& operator+=(grid_2D<T, layout>& a, T const& b)
 {
     a.data += b;
     return a;
 }
-template <typename T> grid_2D<T>  operator+(grid_2D<T> const& a, grid_2D<T> const& b)
+template <typename T, typename layout> grid_2D<T, layout>  operator+(grid_2D<T, layout> const& a, grid_2D<T, layout> const& b)
 {
     assert_cgp( is_equal(a.dimension,b.dimension), "Dimension do not agree: a:"+str(a.dimension)+", b:"+str(b.dimension) );
-    grid_2D<T> res(a.dimension);
+    grid_2D<T, layout> res(a.dimension);
     res.data = a.data+b.data;
     return res;
 
 }
-template <typename T> grid_2D<T>  operator+(grid_2D<T> const& a, T const& b)
+template <typename T, typename layout> grid_2D<T, layout>  operator+(grid_2D<T, layout> const& a, T const& b)
 {
-    grid_2D<T> res(a.dimension);
+    grid_2D<T, layout> res(a.dimension);
     res.data = a.data+b;
     return res;
 }
-template <typename T> grid_2D<T>  operator+(T const& a, grid_2D<T> const& b)
+template <typename T, typename layout> grid_2D<T, layout>  operator+(T const& a, grid_2D<T, layout> const& b)
 {
-    grid_2D<T> res(b.dimension);
+    grid_2D<T, layout> res(b.dimension);
     res.data = a + b.data;
     return res;
 }
 
-template <typename T> grid_2D<T>& operator-=(grid_2D<T>& a, grid_2D<T> const& b)
+template <typename T, typename layout> grid_2D<T, layout>& operator-=(grid_2D<T, layout>& a, grid_2D<T, layout> const& b)
 {
     assert_cgp( is_equal(a.dimension,b.dimension), "Dimension do not agree: a:"+str(a.dimension)+", b:"+str(b.dimension) );
     a.data -= b.data;
 }
-template <typename T> grid_2D<T>& operator-=(grid_2D<T>& a, T const& b)
+template <typename T, typename layout> grid_2D<T, layout>& operator-=(grid_2D<T, layout>& a, T const& b)
 {
     a.data -= b;
     return a;
 }
-template <typename T> grid_2D<T>  operator-(grid_2D<T> const& a, grid_2D<T> const& b)
+template <typename T, typename layout> grid_2D<T, layout>  operator-(grid_2D<T, layout> const& a, grid_2D<T, layout> const& b)
 {
     assert_cgp( is_equal(a.dimension,b.dimension), "Dimension do not agree: a:"+str(a.dimension)+", b:"+str(b.dimension) );
-    grid_2D<T> res(a.dimension);
+    grid_2D<T, layout> res(a.dimension);
     res.data = a.data-b.data;
     return res;
 }
-template <typename T> grid_2D<T>  operator-(grid_2D<T> const& a, T const& b)
+template <typename T, typename layout> grid_2D<T, layout>  operator-(grid_2D<T, layout> const& a, T const& b)
 {
-    grid_2D<T> res(a.dimension);
+    grid_2D<T, layout> res(a.dimension);
     res.data = a.data-b;
     return res;
 }
-template <typename T> grid_2D<T>  operator-(T const& a, grid_2D<T> const& b)
+template <typename T, typename layout> grid_2D<T, layout>  operator-(T const& a, grid_2D<T, layout> const& b)
 {
-    grid_2D<T> res(a.dimension);
+    grid_2D<T, layout> res(a.dimension);
     res.data = a-b.data;
     return res;
 }
 
-template <typename T> grid_2D<T>& operator*=(grid_2D<T>& a, grid_2D<T> const& b)
+template <typename T, typename layout> grid_2D<T, layout>& operator*=(grid_2D<T, layout>& a, grid_2D<T, layout> const& b)
 {
     assert_cgp( is_equal(a.dimension,b.dimension), "Dimension do not agree: a:"+str(a.dimension)+", b:"+str(b.dimension) );
     a.data *= b.data;
 }
-template <typename T> grid_2D<T>& operator*=(grid_2D<T>& a, float b)
+template <typename T, typename layout> grid_2D<T, layout>& operator*=(grid_2D<T, layout>& a, float b)
 {
     a.data *= b;
     return a;
 }
-template <typename T> grid_2D<T>  operator*(grid_2D<T> const& a, grid_2D<T> const& b)
+template <typename T, typename layout> grid_2D<T, layout>  operator*(grid_2D<T, layout> const& a, grid_2D<T, layout> const& b)
 {
     assert_cgp( is_equal(a.dimension,b.dimension), "Dimension do not agree: a:"+str(a.dimension)+", b:"+str(b.dimension) );
-    grid_2D<T> res(a.dimension);
+    grid_2D<T, layout> res(a.dimension);
     res.data = a.data*b.data;
     return res;
 }
-template <typename T> grid_2D<T>  operator*(grid_2D<T> const& a, float b)
+template <typename T, typename layout> grid_2D<T, layout>  operator*(grid_2D<T, layout> const& a, float b)
 {
-    grid_2D<T> res(a.dimension);
+    grid_2D<T, layout> res(a.dimension);
     res.data = a.data*b;
     return res;
 }
-template <typename T> grid_2D<T>  operator*(float a, grid_2D<T> const& b)
+template <typename T, typename layout> grid_2D<T, layout>  operator*(float a, grid_2D<T, layout> const& b)
 {
-    grid_2D<T> res(b.dimension);
+    grid_2D<T, layout> res(b.dimension);
     res.data = a*b.data;
     return res;
 }
 
-template <typename T> grid_2D<T>& operator/=(grid_2D<T>& a, grid_2D<T> const& b)
+template <typename T, typename layout> grid_2D<T, layout>& operator/=(grid_2D<T, layout>& a, grid_2D<T, layout> const& b)
 {
     assert_cgp( is_equal(a.dimension,b.dimension), "Dimension do not agree: a:"+str(a.dimension)+", b:"+str(b.dimension) );
     a.data /= b.data;
     return a;
 }
-template <typename T> grid_2D<T>& operator/=(grid_2D<T>& a, float b)
+template <typename T, typename layout> grid_2D<T, layout>& operator/=(grid_2D<T, layout>& a, float b)
 {
     a.data /= b;
     return a;
 }
-template <typename T> grid_2D<T>  operator/(grid_2D<T> const& a, grid_2D<T> const& b)
+template <typename T, typename layout> grid_2D<T, layout>  operator/(grid_2D<T, layout> const& a, grid_2D<T, layout> const& b)
 {
     assert_cgp( is_equal(a.dimension,b.dimension), "Dimension do not agree: a:"+str(a.dimension)+", b:"+str(b.dimension) );
-    grid_2D<T> res(a.dimension);
+    grid_2D<T, layout> res(a.dimension);
     res.data = a.data/b.data;
     return res;
 }
-template <typename T> grid_2D<T>  operator/(grid_2D<T> const& a, float b)
+template <typename T, typename layout> grid_2D<T, layout>  operator/(grid_2D<T, layout> const& a, float b)
 {
-    grid_2D<T> res(a.dimension);
+    grid_2D<T, layout> res(a.dimension);
     res.data = a.data/b;
     return res;
 }
 
 
-template <typename T>
-grid_2D<T> grid_2D<T>::from_buffer(numarray<T> const& arg, int size_1, int size_2)
+template <typename T, typename layout>
+grid_2D<T, layout> grid_2D<T, layout>::from_buffer(numarray<T> const& arg, int size_1, int size_2)
 {
     assert_cgp(arg.size()==size_1*size_2, "Incoherent size to generate grid_2D");
 
-    grid_2D<T> b(size_1, size_2);
-    b.data = arg;
+    grid_2D<T, layout> b(size_1, size_2);
+    if (layout::is_linear)
+        b.data = arg;
+    else
+        for (int k2 = 0; k2 < size_2; ++k2)
+            for (int k1 = 0; k1 < size_1; ++k1)
+                b(k1, k2) = arg[k1 + size_1 * k2];
 
     return b;
 }
 
-template <typename T>
-int grid_2D<T>::index_to_offset(int k1, int k2) const
+template <typename T, typename layout>
+int grid_2D<T, layout>::index_to_offset(int k1, int k2) const
 {
-    return offset_grid(k1,k2,dimension.x);
+    return layout::offset(k1, k2, dimension);
 }
-template <typename T>
-int2 grid_2D<T>::offset_to_index(int offset) const
+template <typename T, typename layout>
+int2 grid_2D<T, layout>::offset_to_index(int offset) const
 {
-    int2 idx = index_grid_from_offset(offset,dimension.x);
-    return {idx.x, idx.y};
+    return layout::index(offset, dimension);
 }
 
 
+template <typename T, typename layout>
+grid_tiles_2D grid_2D<T, layout>::tiles() const
+{
+    return { dimension, layout::tile_size(dimension) };
+}
+template <typename T, typename layout>
+grid_tiles_2D grid_2D<T, layout>::tiles(int2 const& tile_size) const
+{
+    assert_cgp(tile_size.x > 0 && tile_size.y > 0, "Tile size must be strictly positive: " + str(tile_size));
+    return { dimension, tile_size };
 }
+
+
+}
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "cgp/01_base/base.hpp"
 #include "cgp/02_numarray/numarray.hpp"
 #include "../../offset_grid/offset_grid.hpp"
+#include "../grid_layout/grid_layout.hpp"
 
 
 /* ************************************************** */
@@ -16,8 +17,10 @@ namespace cgp
 *
 * The grid_3D structure provide convenient access for 3D-grid organization where an element can be queried as grid_3D(i,j).
 * Elements of grid_3D are stored contiguously in heap memory and remain fully compatible with std::vector and pointers.
+* The optional layout parameter changes the order of the elements in data (padded rows, tiles, Morton order - see grid_layout.hpp).
+*   With a non-linear layout, data may hold more than size() elements and should be accessed through grid_3D(k1,k2,k3) or index_to_offset.
 **/
-template <typename T>
+template <typename T, typename layout = grid_layout_linear>
 struct grid_3D
 {
     /** 3D dimension (Nx,Ny,Nz) of the container */
@@ -32,8 +35,8 @@ struct grid_3D
     grid_3D(int size_1, int size_2, int size_3); // Generate a grid of dimension size_1 x size_2 x size_3
 
     /** Direct build a grid_3D from a given 1D-buffer and its 3D-dimension
-    * \note: the size of the 3D-buffer must satisfy arg.size = size_1 * size_2 * size_3 */
-    static grid_3D<T> from_array(numarray<T> const& arg, int size_1, int size_2, int size_3);
+    * \note: the size of the 3D-buffer must satisfy arg.size = size_1 * size_2 * size_3, its elements are in the linear order k1 + N1*(k2 + N2*k3) */
+    static grid_3D<T, layout> from_array(numarray<T> const& arg, int size_1, int size_2, int size_3);
 
     /** Remove all elements from the grid_2D */
     void clear();
@@ -61,6 +64,11 @@ struct grid_3D
     int index_to_offset(int3 const& index) const;
     int3 offset_to_index(int offset) const;
 
+    /** Tiles covering the grid, to walk it block by block (see grid_tiles_3D)
+     * The default tile size is the one of the layout: tiles of contiguous elements in memory (rows for the linear layout). */
+    grid_tiles_3D tiles() const;
+    grid_tiles_3D tiles(int3 const& tile_size) const;
+
     typename std::vector<T>::iterator begin();
     typename std::vector<T>::iterator end();
     typename std::vector<T>::const_iterator begin() const;
@@ -75,35 +83,35 @@ struct grid_3D
 
 };
 
-template <typename T> std::string type_str(grid_3D<T> const&);
-template <typename T1, typename T2> bool is_equal(grid_3D<T1> const& a, grid_3D<T2> const& b);
+template <typename T, typename layout> std::string type_str(grid_3D<T, layout> const&);
+template <typename T1, typename T2, typename layout> bool is_equal(grid_3D<T1, layout> const& a, grid_3D<T2, layout> const& b);
 
-template <typename T> std::ostream& operator<<(std::ostream& s, grid_3D<T> const& v);
-template <typename T> std::string str(grid_3D<T> const& v, std::string const& separator=" ", std::string const& begin="", std::string const& end="");
+template <typename T, typename layout> std::ostream& operator<<(std::ostream& s, grid_3D<T, layout> const& v);
+template <typename T, typename layout> std::string str(grid_3D<T, layout> const& v, std::string const& separator=" ", std::string const& begin="", std::string const& end="");
 
-template <typename T> grid_3D<T>& operator+=(grid_3D<T>& a, grid_3D<T> const& b);
-template <typename T> grid_3D<T>& operator+=(grid_3D<T>& a, T const& b);
-template <typename T> grid_3D<T>  operator+(grid_3D<T> const& a, grid_3D<T> const& b);
-template <typename T> grid_3D<T>  operator+(grid_3D<T> const& a, T const& b);
-template <typename T> grid_3D<T>  operator+(T const& a, grid_3D<T> const& b);
+template <typename T, typename layout> grid_3D<T, layout>& operator+=(grid_3D<T, layout>& a, grid_3D<T, layout> const& b);
+template <typename T, typename layout> grid_3D<T, layout>& operator+=(grid_3D<T, layout>& a, T const& b);
+template <typename T, typename layout> grid_3D<T, layout>  operator+(grid_3D<T, layout> const& a, grid_3D<T, layout> const& b);
+template <typename T, typename layout> grid_3D<T, layout>  operator+(grid_3D<T, layout> const& a, T const& b);
+template <typename T, typename layout> grid_3D<T, layout>  operator+(T const& a, grid_3D<T, layout> const& b);
 
-template <typename T> grid_3D<T>& operator-=(grid_3D<T>& a, grid_3D<T> const& b);
-template <typename T> grid_3D<T>& operator-=(grid_3D<T>& a, T const& b);
-template <typename T> grid_3D<T>  operator-(grid_3D<T> const& a, grid_3D<T> const& b);
-template <typename T> grid_3D<T>  operator-(grid_3D<T> const& a, T const& b);
-template <typename T> grid_3D<T>  operator-(T const& a, grid_3D<T> const& b);
+template <typename T, typename layout> grid_3D<T, layout>& operator-=(grid_3D<T, layout>& a, grid_3D<T, layout> const& b);
+template <typename T, typename layout> grid_3D<T, layout>& operator-=(grid_3D<T, layout>& a, T const& b);
+template <typename T, typename layout> grid_3D<T, layout>  operator-(grid_3D<T, layout> const& a, grid_3D<T, layout> const& b);
+template <typename T, typename layout> grid_3D<T, layout>  operator-(grid_3D<T, layout> const& a, T const& b);
+template <typename T, typename layout> grid_3D<T, layout>  operator-(T const& a, grid_3D<T, layout> const& b);
 
-template <typename T> grid_3D<T>& operator*=(grid_3D<T>& a, grid_3D<T> const& b);
-template <typename T> grid_3D<T>& operator*=(grid_3D<T>& a, float b);
-template <typename T> grid_3D<T>  operator*(grid_3D<T> const& a, grid_3D<T> const& b);
-template <typename T> grid_3D<T>  operator*(grid_3D<T> const& a, float b);
-template <typename T> grid_3D<T>  operator*(float a, grid_3D<T> const& b);
+template <typename T, typename layout> grid_3D<T, layout>& operator*=(grid_3D<T, layout>& a, grid_3D<T, layout> const& b);
+template <typename T, typename layout> grid_3D<T, layout>& operator*=(grid_3D<T, layout>& a, float b);
+template <typename T, typename layout> grid_3D<T, layout>  operator*(grid_3D<T, layout> const& a, grid_3D<T, layout> const& b);
+template <typename T, typename layout> grid_3D<T, layout>  operator*(grid_3D<T, layout> const& a, float b);
+template <typename T, typename layout> grid_3D<T, layout>  operator*(float a, grid_3D<T, layout> const& b);
 
-template <typename T> grid_3D<T>& operator/=(grid_3D<T>& a, grid_3D<T> const& b);
-template <typename T> grid_3D<T>& operator/=(grid_3D<T>& a, float b);
-template <typename T> grid_3D<T>  operator/(grid_3D<T> const& a, grid_3D<T> const& b);
-template <typename T> grid_3D<T>  operator/(grid_3D<T> const& a, float b);
-template <typename T> grid_3D<T>  operator/(float a, grid_3D<T> const& b);
+template <typename T, typename layout> grid_3D<T, layout>& operator/=(grid_3D<T, layout>& a, grid_3D<T, layout> const& b);
+template <typename T, typename layout> grid_3D<T, layout>& operator/=(grid_3D<T, layout>& a, float b);
+template <typename T, typename layout> grid_3D<T, layout>  operator/(grid_3D<T, layout> const& a, grid_3D<T, layout> const& b);
+template <typename T, typename layout> grid_3D<T, layout>  operator/(grid_3D<T, layout> const& a, float b);
+template <typename T, typename layout> grid_3D<T, layout>  operator/(float a, grid_3D<T, layout> const& b);
 
 }
 
@@ -117,88 +125,94 @@ namespace cgp
 {
 
 
-template <typename T>
-grid_3D<T>::grid_3D()
+template <typename T, typename layout>
+grid_3D<T, layout>::grid_3D()
     :dimension(int3{0,0,0}),data()
 {}
 
-template <typename T>
-grid_3D<T>::grid_3D(int size)
-    :dimension({size,size,size}),data(size*size*size)
+template <typename T, typename layout>
+grid_3D<T, layout>::grid_3D(int size)
+    :dimension({size,size,size}),data(layout::storage_size(int3{size,size,size}))
 {
     assert_cgp_no_msg(size>=0);
 }
 
-template <typename T>
-grid_3D<T>::grid_3D(int3 const& size)
-    :dimension(size),data(size[0]*size[1]*size[2])
+template <typename T, typename layout>
+grid_3D<T, layout>::grid_3D(int3 const& size)
+    :dimension(size),data(layout::storage_size(size))
 {
     assert_cgp_no_msg(size[0]>=0 && size[1]>=0 && size[2]>=0);
 }
 
-template <typename T>
-grid_3D<T>::grid_3D(int size_1, int size_2, int size_3)
-    :dimension({size_1,size_2, size_3}),data(size_1*size_2*size_3)
+template <typename T, typename layout>
+grid_3D<T, layout>::grid_3D(int size_1, int size_2, int size_3)
+    :dimension({size_1,size_2, size_3}),data(layout::storage_size(int3{size_1,size_2,size_3}))
 {
     assert_cgp_no_msg(size_1>=0 && size_2>=0 && size_3>=0);
 }
 
-template <typename T>
-int grid_3D<T>::size() const
+template <typename T, typename layout>
+int grid_3D<T, layout>::size() const
 {
     return dimension[0]*dimension[1]*dimension[2];
 }
 
-template <typename T>
-void grid_3D<T>::resize(int size)
+template <typename T, typename layout>
+void grid_3D<T, layout>::resize(int size)
 {
     assert_cgp_no_msg(size>=0);
     resize(size,size,size);
 }
 
-template <typename T>
-void grid_3D<T>::resize(int3 const& size)
+template <typename T, typename layout>
+void grid_3D<T, layout>::resize(int3 const& size)
 {
     assert_cgp_no_msg(size[0]>=0 && size[1]>=0 && size[2]>=0);
     dimension = size;
-    data.resize(size[0]*size[1]*size[2]);
+    data.resize(layout::storage_size(size));
 }
 
-template <typename T>
-void grid_3D<T>::resize(int size_1, int size_2, int size_3)
+template <typename T, typename layout>
+void grid_3D<T, layout>::resize(int size_1, int size_2, int size_3)
 {
     assert_cgp_no_msg(size_1>=0 && size_2>=0 && size_3>=0);
     dimension = {size_1, size_2, size_3};
     resize({size_1, size_2, size_3});
 }
 
-template <typename T>
-void grid_3D<T>::fill(T const& value)
+template <typename T, typename layout>
+void grid_3D<T, layout>::fill(T const& value)
 {
     data.fill(value);
 }
 
 
-template <typename T>
-grid_3D<T> grid_3D<T>::from_array(numarray<T> const& arg, int size_1, int size_2, int size_3)
+template <typename T, typename layout>
+grid_3D<T, layout> grid_3D<T, layout>::from_array(numarray<T> const& arg, int size_1, int size_2, int size_3)
 {
     assert_cgp(arg.size()==size_1*size_2*size_3, "Incoherent size to generate grid_2D");
 
-    grid_3D<T> b(size_1, size_2, size_3);
-    b.data = arg;
+    grid_3D<T, layout> b(size_1, size_2, size_3);
+    if (layout::is_linear)
+        b.data = arg;
+    else
+        for (int k3 = 0; k3 < size_3; ++k3)
+            for (int k2 = 0; k2 < size_2; ++k2)
+                for (int k1 = 0; k1 < size_1; ++k1)
+                    b(k1, k2, k3) = arg[k1 + size_1 * (k2 + size_2 * k3)];
 
     return b;
 }
 
-template <typename T>
-void grid_3D<T>::clear()
+template <typename T, typename layout>
+void grid_3D<T, layout>::clear()
 {
     data.clear();
 }
 
 
-template <typename T>
-static void check_index_bounds(int index1, int index2, int index3, grid_3D<T> const& data)
+template <typename T, typename layout>
+static void check_index_bounds(int index1, int index2, int index3, grid_3D<T, layout> const& data)
 {
 #ifndef cgp_NO_DEBUG
     int const N1 = data.dimension.x;
@@ -240,95 +254,95 @@ static void check_index_bounds(int index1, int index2, int index3, grid_3D<T> co
 }
 
 
-template <typename T> T const& grid_3D<T>::operator[](int3 const& index) const
+template <typename T, typename layout> T const& grid_3D<T, layout>::operator[](int3 const& index) const
 {
     check_index_bounds(index.x, index.y, index.z, *this);
-    int const  idx = offset_grid(index.x, index.y, index.z, dimension.x, dimension.y);
+    int const  idx = layout::offset(index.x, index.y, index.z, dimension);
     return data[idx];
 }
-template <typename T> T& grid_3D<T>::operator[](int3 const& index)
+template <typename T, typename layout> T& grid_3D<T, layout>::operator[](int3 const& index)
 {
     check_index_bounds(index.x, index.y, index.z, *this);
-    int const  idx = offset_grid(index.x, index.y, index.z, dimension.x, dimension.y);
+    int const  idx = layout::offset(index.x, index.y, index.z, dimension);
     return data[idx];
 }
-template <typename T> T const& grid_3D<T>::operator()(int3 const& index) const
+template <typename T, typename layout> T const& grid_3D<T, layout>::operator()(int3 const& index) const
 {
     check_index_bounds(index.x, index.y, index.z, *this);
-    int const  idx = offset_grid(index.x, index.y, index.z, dimension.x, dimension.y);
+    int const  idx = layout::offset(index.x, index.y, index.z, dimension);
     return data[idx];
 }
-template <typename T> T& grid_3D<T>::operator()(int3 const& index)
+template <typename T, typename layout> T& grid_3D<T, layout>::operator()(int3 const& index)
 {
     check_index_bounds(index.x, index.y, index.z, *this);
-    int const  idx = offset_grid(index.x, index.y, index.z, dimension.x, dimension.y);
+    int const  idx = layout::offset(index.x, index.y, index.z, dimension);
     return data[idx];
 }
-template <typename T> T const& grid_3D<T>::operator()(int k1, int k2, int k3) const
+template <typename T, typename layout> T const& grid_3D<T, layout>::operator()(int k1, int k2, int k3) const
 {
     check_index_bounds(k1, k2, k3, *this);
-    int const  idx = offset_grid(k1, k2, k3, dimension.x, dimension.y);
+    int const  idx = layout::offset(k1, k2, k3, dimension);
     return data[idx];
 }
-template <typename T> T& grid_3D<T>::operator()(int k1, int k2, int k3)
+template <typename T, typename layout> T& grid_3D<T, layout>::operator()(int k1, int k2, int k3)
 {
     check_index_bounds(k1, k2, k3, *this);
-    int const  idx = offset_grid(k1, k2, k3, dimension.x, dimension.y);
+    int const  idx = layout::offset(k1, k2, k3, dimension);
     return data[idx];
 }
 
 
 
-template <typename T>
-typename std::vector<T>::iterator grid_3D<T>::begin()
+template <typename T, typename layout>
+typename std::vector<T>::iterator grid_3D<T, layout>::begin()
 {
     return data.begin();
 }
 
-template <typename T>
-typename std::vector<T>::iterator grid_3D<T>::end()
+template <typename T, typename layout>
+typename std::vector<T>::iterator grid_3D<T, layout>::end()
 {
     return data.end();
 }
 
-template <typename T>
-typename std::vector<T>::const_iterator grid_3D<T>::begin() const
+template <typename T, typename layout>
+typename std::vector<T>::const_iterator grid_3D<T, layout>::begin() const
 {
     return data.begin();
 }
 
-template <typename T>
-typename std::vector<T>::const_iterator grid_3D<T>::end() const
+template <typename T, typename layout>
+typename std::vector<T>::const_iterator grid_3D<T, layout>::end() const
 {
     return data.end();
 }
 
-template <typename T>
-typename std::vector<T>::const_iterator grid_3D<T>::cbegin() const
+template <typename T, typename layout>
+typename std::vector<T>::const_iterator grid_3D<T, layout>::cbegin() const
 {
     return data.cbegin();
 }
 
-template <typename T>
-typename std::vector<T>::const_iterator grid_3D<T>::cend() const
+template <typename T, typename layout>
+typename std::vector<T>::const_iterator grid_3D<T, layout>::cend() const
 {
     return data.cend();
 }
 
-template <typename T>
-int grid_3D<T>::index_to_offset(int k1, int k2, int k3) const
+template <typename T, typename layout>
+int grid_3D<T, layout>::index_to_offset(int k1, int k2, int k3) const
 {
-    return offset_grid(k1, k2, k3, dimension.x, dimension.y);
+    return layout::offset(k1, k2, k3, dimension);
 }
-template <typename T>
-int grid_3D<T>::index_to_offset(int3 const& index) const
+template <typename T, typename layout>
+int grid_3D<T, layout>::index_to_offset(int3 const& index) const
 {
-    return offset_grid(index, dimension.x, dimension.y);
+    return layout::offset(index.x, index.y, index.z, dimension);
 }
-template <typename T>
-int3 grid_3D<T>::offset_to_index(int offset) const
+template <typename T, typename layout>
+int3 grid_3D<T, layout>::offset_to_index(int offset) const
 {
-    return index_grid_from_offset(offset, dimension.x, dimension.y);
+    return layout::index(offset, dimension);
 }
 
 
@@ -338,12 +352,12 @@ int3 grid_3D<T>::offset_to_index(int offset) const
 
 
 
-template <typename T> std::string type_str(grid_3D<T> const&)
+template <typename T, typename layout> std::string type_str(grid_3D<T, layout> const&)
 {
-    return "grid_3D<" + type_str(T()) + ">";
+    return "grid_3D<" + type_str(T()) + (layout::is_linear ? "" : "," + layout::name()) + ">";
 }
 
-template <typename T1, typename T2> bool is_equal(grid_3D<T1> const& a, grid_3D<T2> const& b)
+template <typename T1, typename T2, typename layout> bool is_equal(grid_3D<T1, layout> const& a, grid_3D<T2, layout> const& b)
 {
     if (is_equal(a.dimension, b.dimension) == false)
         return false;
@@ -351,136 +365,136 @@ template <typename T1, typename T2> bool is_equal(grid_3D<T1> const& a, grid_3D<
 }
 
 
-template <typename T> std::ostream& operator<<(std::ostream& s, grid_3D<T> const& v)
+template <typename T, typename layout> std::ostream& operator<<(std::ostream& s, grid_3D<T, layout> const& v)
 {
     return s << v.data;
 }
-template <typename T> std::string str(grid_3D<T> const& v, std::string const& separator, std::string const& begin, std::string const& end)
+template <typename T, typename layout> std::string str(grid_3D<T, layout> const& v, std::string const& separator, std::string const& begin, std::string const& end)
 {
     return str(v.data, separator, begin, end);
 }
 
 
-template <typename T> grid_3D<T>& operator+=(grid_3D<T>& a, grid_3D<T> const& b)
+template <typename T, typename layout> grid_3D<T, layout>& operator+=(grid_3D<T, layout>& a, grid_3D<T, layout> const& b)
 {
     assert_cgp( is_equal(a.dimension,b.dimension), "Dimension do not agree: a:"+str(a.dimension)+", b:"+str(b.dimension) );
     a.data += b.data;
 }
-template <typename T> grid_3D<T>& operator+=(grid_3D<T>& a, T const& b)
+template <typename T, typename layout> grid_3D<T, layout>& operator+=(grid_3D<T, layout>& a, T const& b)
 {
     a.data += b;
     return a;
 }
-template <typename T> grid_3D<T>  operator+(grid_3D<T> const& a, grid_3D<T> const& b)
+template <typename T, typename layout> grid_3D<T, layout>  operator+(grid_3D<T, layout> const& a, grid_3D<T, layout> const& b)
 {
     assert_cgp( is_equal(a.dimension,b.dimension), "Dimension do not agree: a:"+str(a.dimension)+", b:"+str(b.dimension) );
-    grid_3D<T> res(a.dimension);
+    grid_3D<T, layout> res(a.dimension);
     res.data = a.data+b.data;
     return res;
 
 }
-template <typename T> grid_3D<T>  operator+(grid_3D<T> const& a, T const& b)
+template <typename T, typename layout> grid_3D<T, layout>  operator+(grid_3D<T, layout> const& a, T const& b)
 {
-    grid_3D<T> res(a.dimension);
+    grid_3D<T, layout> res(a.dimension);
     res.data = a.data+b;
     return res;
 }
-template <typename T> grid_3D<T>  operator+(T const& a, grid_3D<T> const& b)
+template <typename T, typename layout> grid_3D<T, layout>  operator+(T const& a, grid_3D<T, layout> const& b)
 {
-    grid_3D<T> res(b.dimension);
+    grid_3D<T, layout> res(b.dimension);
     res.data = a + b.data;
     return res;
 }
 
-template <typename T> grid_3D<T>& operator-=(grid_3D<T>& a, grid_3D<T> const& b)
+template <typename T, typename layout> grid_3D<T, layout>& operator-=(grid_3D<T, layout>& a, grid_3D<T, layout> const& b)
 {
     assert_cgp( is_equal(a.dimension,b.dimension), "Dimension do not agree: a:"+str(a.dimension)+", b:"+str(b.dimension) );
     a.data -= b.data;
     return a;
 }
-template <typename T> grid_3D<T>& operator-=(grid_3D<T>& a, T const& b)
+template <typename T, typename layout> grid_3D<T, layout>& operator-=(grid_3D<T, layout>& a, T const& b)
 {
     a.data -= b;
     return a;
 }
-template <typename T> grid_3D<T>  operator-(grid_3D<T> const& a, grid_3D<T> const& b)
+template <typename T, typename layout> grid_3D<T, layout>  operator-(grid_3D<T, layout> const& a, grid_3D<T, layout> const& b)
 {
     assert_cgp( is_equal(a.dimension,b.dimension), "Dimension do not agree: a:"+str(a.dimension)+", b:"+str(b.dimension) );
-    grid_3D<T> res(a.dimension);
+    grid_3D<T, layout> res(a.dimension);
     res.data = a.data-b.data;
     return res;
 }
-template <typename T> grid_3D<T>  operator-(grid_3D<T> const& a, T const& b)
+template <typename T, typename layout> grid_3D<T, layout>  operator-(grid_3D<T, layout> const& a, T const& b)
 {
-    grid_3D<T> res(a.dimension);
+    grid_3D<T, layout> res(a.dimension);
     res.data = a.data-b;
     return res;
 }
-template <typename T> grid_3D<T>  operator-(T const& a, grid_3D<T> const& b)
+template <typename T, typename layout> grid_3D<T, layout>  operator-(T const& a, grid_3D<T, layout> const& b)
 {
-    grid_3D<T> res(a.dimension);
+    grid_3D<T, layout> res(a.dimension);
     res.data = a-b.data;
     return res;
 }
 
-template <typename T> grid_3D<T>& operator*=(grid_3D<T>& a, grid_3D<T> const& b)
+template <typename T, typename layout> grid_3D<T, layout>& operator*=(grid_3D<T, layout>& a, grid_3D<T, layout> const& b)
 {
     assert_cgp( is_equal(a.dimension,b.dimension), "Dimension do not agree: a:"+str(a.dimension)+", b:"+str(b.dimension) );
     a.data *= b.data;
     return a;
 }
-template <typename T> grid_3D<T>& operator*=(grid_3D<T>& a, float b)
+template <typename T, typename layout> grid_3D<T, layout>& operator*=(grid_3D<T, layout>& a, float b)
 {
     a.data *= b;
     return a;
 }
-template <typename T> grid_3D<T>  operator*(grid_3D<T> const& a, grid_3D<T> const& b)
+template <typename T, typename layout> grid_3D<T, layout>  operator*(grid_3D<T, layout> const& a, grid_3D<T, layout> const& b)
 {
     assert_cgp( is_equal(a.dimension,b.dimension), "Dimension do not agree: a:"+str(a.dimension)+", b:"+str(b.dimension) );
-    grid_3D<T> res(a.dimension);
+    grid_3D<T, layout> res(a.dimension);
     res.data = a.data*b.data;
     return res;
 }
-template <typename T> grid_3D<T>  operator*(grid_3D<T> const& a, float b)
+template <typename T, typename layout> grid_3D<T, layout>  operator*(grid_3D<T, layout> const& a, float b)
 {
-    grid_3D<T> res(a.dimension);
+    grid_3D<T, layout> res(a.dimension);
     res.data = a.data*b;
     return res;
 }
-template <typename T> grid_3D<T>  operator*(float a, grid_3D<T> const& b)
+template <typename T, typename layout> grid_3D<T, layout>  operator*(float a, grid_3D<T, layout> const& b)
 {
-    grid_3D<T> res(b.dimension);
+    grid_3D<T, layout> res(b.dimension);
     res.data = a*b.data;
     return res;
 }
 
-template <typename T> grid_3D<T>& operator/=(grid_3D<T>& a, grid_3D<T> const& b)
+template <typename T, typename layout> grid_3D<T, layout>& operator/=(grid_3D<T, layout>& a, grid_3D<T, layout> const& b)
 {
     assert_cgp( is_equal(a.dimension,b.dimension), "Dimension do not agree: a:"+str(a.dimension)+", b:"+str(b.dimension) );
     a.data /= b.data;
     return a;
 }
-template <typename T> grid_3D<T>& operator/=(grid_3D<T>& a, float b)
+template <typename T, typename layout> grid_3D<T, layout>& operator/=(grid_3D<T, layout>& a, float b)
 {
     a.data /= b;
     return a;
 }
-template <typename T> grid_3D<T>  operator/(grid_3D<T> const& a, grid_3D<T> const& b)
+template <typename T, typename layout> grid_3D<T, layout>  operator/(grid_3D<T, layout> const& a, grid_3D<T, layout> const& b)
 {
     assert_cgp( is_equal(a.dimension,b.dimension), "Dimension do not agree: a:"+str(a.dimension)+", b:"+str(b.dimension) );
-    grid_3D<T> res(a.dimension);
+    grid_3D<T, layout> res(a.dimension);
     res.data = a.data/b.data;
     return res;
 }
-template <typename T> grid_3D<T>  operator/(grid_3D<T> const& a, float b)
+template <typename T, typename layout> grid_3D<T, layout>  operator/(grid_3D<T, layout> const& a, float b)
 {
-    grid_3D<T> res(a.dimension);
+    grid_3D<T, layout> res(a.dimension);
     res.data = a.data/b;
     return res;
 }
-template <typename T> grid_3D<T>  operator/(float a, grid_3D<T> const& b)
+template <typename T, typename layout> grid_3D<T, layout>  operator/(float a, grid_3D<T, layout> const& b)
 {
-    grid_3D<T> res(b.dimension);
+    grid_3D<T, layout> res(b.dimension);
     res.data = a/b.data;
     return res;
 }
@@ -489,29 +503,41 @@ template <typename T> grid_3D<T>  operator/(float a, grid_3D<T> const& b)
 
 
 
-template <typename T>
-T const& grid_3D<T>::at_unsafe(int index) const
+template <typename T, typename layout>
+T const& grid_3D<T, layout>::at_unsafe(int index) const
 {
     return data.at_unsafe(index);
 }
 
 
-template <typename T>
-T & grid_3D<T>::at_unsafe(int index)
+template <typename T, typename layout>
+T & grid_3D<T, layout>::at_unsafe(int index)
 {
     return data.at_unsafe(index);
 }
 
-template <typename T>
-T const& grid_3D<T>::at_unsafe(int index1, int index2, int index3) const
+template <typename T, typename layout>
+T const& grid_3D<T, layout>::at_unsafe(int index1, int index2, int index3) const
+{
+    return data.at_unsafe(layout::offset(index1, index2, index3, dimension));
+}
+
+template <typename T, typename layout>
+T & grid_3D<T, layout>::at_unsafe(int index1, int index2, int index3)
 {
-    return data.at_unsafe(offset_grid(index1, index2, index3, dimension.x, dimension.y));
+    return data.at_unsafe(layout::offset(index1, index2, index3, dimension));
 }
 
-template <typename T>
-T & grid_3D<T>::at_unsafe(int index1, int index2, int index3)
+template <typename T, typename layout>
+grid_tiles_3D grid_3D<T, layout>::tiles() const
+{
+    return { dimension, layout::tile_size(dimension) };
+}
+template <typename T, typename layout>
+grid_tiles_3D grid_3D<T, layout>::tiles(int3 const& tile_size) const
 {
-    return data.at_unsafe(offset_grid(index1, index2, index3, dimension.x, dimension.y));
+    assert_cgp(tile_size.x > 0 && tile_size.y > 0 && tile_size.z > 0, "Tile size must be strictly positive: " + str(tile_size));
+    return { dimension, tile_size };
 }
 
 }
@@ -0,0 +1,233 @@
+#pragma once
+
+#include "cgp/01_base/base.hpp"
+#include "cgp/02_numarray/numarray.hpp"
+
+#include <string>
+
+
+/* ************************************************** */
+/*           Header                                   */
+/* ************************************************** */
+
+namespace cgp
+{
+
+/** Storage layouts of grid_2D and grid_3D
+ *
+ * A layout maps the index (k1,k2) [or (k1,k2,k3)] of an element to its offset in the 1D buffer grid.data.
+ * grid(k1,k2) has the same meaning for every layout: only the order of the elements in memory (and the size of the buffer) changes.
+ *  - grid_layout_linear: offset k1 + N1*k2 (+ N1*N2*k3). Default layout, the buffer holds exactly the elements.
+ *  - grid_layout_padded<A>: linear with rows of N1 elements rounded up to a multiple of A elements (every row starts with the alignment of the first one).
+ *  - grid_layout_tiled<S>: blocks of SxS (SxSxS) elements stored contiguously, the blocks being in linear order.
+ *      The neighbors of an element along all the directions are close in memory: stencils do not stride over whole rows.
+ *  - grid_layout_morton: Z-order curve over the power of two square (cube) enclosing the grid. Every aligned block of 2^n x 2^n elements is contiguous.
+ * The padded, tiled and Morton buffers have extra elements that are never accessed through grid(k1,k2): they are only seen by the iterators on grid.data.
+ *
+ * Each layout also gives the default tile size of grid.tiles() (see grid_tiles_2D): blocks of elements that are contiguous in memory.
+ **/
+
+struct grid_layout_linear
+{
+    static bool constexpr is_linear = true;
+    static std::string name() { return ""; }
+
+    static int storage_size(int2 const& N) { return N.x * N.y; }
+    static int offset(int k1, int k2, int2 const& N) { return k1 + N.x * k2; }
+    static int2 index(int offset, int2 const& N) { return { offset % N.x, offset / N.x }; }
+    static int2 tile_size(int2 const& N) { return { std::max(N.x, 1), 1 }; } // rows (at least 1 element wide for an empty grid)
+
+    static int storage_size(int3 const& N) { return N.x * N.y * N.z; }
+    static int offset(int k1, int k2, int k3, int3 const& N) { return k1 + N.x * (k2 + N.y * k3); }
+    static int3 index(int offset, int3 const& N) { return { offset % N.x, (offset / N.x) % N.y, offset / (N.x * N.y) }; }
+    static int3 tile_size(int3 const& N) { return { std::max(N.x, 1), 1, 1 }; }
+};
+
+template <int alignment = 16>
+struct grid_layout_padded
+{
+    static bool constexpr is_linear = false;
+    static std::string name() { return "padded" + str(alignment); }
+    static int stride(int N1) { return (N1 + alignment - 1) / alignment * alignment; }
+
+    static int storage_size(int2 const& N) { return stride(N.x) * N.y; }
+    static int offset(int k1, int k2, int2 const& N) { return k1 + stride(N.x) * k2; }
+    static int2 index(int offset, int2 const& N) { return { offset % stride(N.x), offset / stride(N.x) }; }
+    static int2 tile_size(int2 const& N) { return { std::max(N.x, 1), 1 }; }
+
+    static int storage_size(int3 const& N) { return stride(N.x) * N.y * N.z; }
+    static int offset(int k1, int k2, int k3, int3 const& N) { return k1 + stride(N.x) * (k2 + N.y * k3); }
+    static int3 index(int offset, int3 const& N) { return { offset % stride(N.x), (offset / stride(N.x)) % N.y, offset / (stride(N.x) * N.y) }; }
+    static int3 tile_size(int3 const& N) { return { std::max(N.x, 1), 1, 1 }; }
+};
+
+template <int S = 8>
+struct grid_layout_tiled
+{
+    static bool constexpr is_linear = false;
+    static std::string name() { return "tiled" + str(S); }
+    static int N_tile(int N) { return (N + S - 1) / S; }
+
+    static int storage_size(int2 const& N) { return N_tile(N.x) * N_tile(N.y) * S * S; }
+    static int offset(int k1, int k2, int2 const& N) { return ((k2 / S) * N_tile(N.x) + k1 / S) * (S * S) + (k2 % S) * S + k1 % S; }
+    static int2 index(int offset, int2 const& N)
+    {
+        int const tile = offset / (S * S);
+        int const r = offset % (S * S);
+        return { (tile % N_tile(N.x)) * S + r % S, (tile / N_tile(N.x)) * S + r / S };
+    }
+    static int2 tile_size(int2 const&) { return { S, S }; }
+
+    static int storage_size(int3 const& N) { return N_tile(N.x) * N_tile(N.y) * N_tile(N.z) * S * S * S; }
+    static int offset(int k1, int k2, int k3, int3 const& N)
+    {
+        int const tile = k1 / S + N_tile(N.x) * (k2 / S + N_tile(N.y) * (k3 / S));
+        return tile * (S * S * S) + k1 % S + S * (k2 % S + S * (k3 % S));
+    }
+    static int3 index(int offset, int3 const& N)
+    {
+        int const tile = offset / (S * S * S);
+        int const r = offset % (S * S * S);
+        int const t1 = tile % N_tile(N.x);
+        int const t2 = (tile / N_tile(N.x)) % N_tile(N.y);
+        int const t3 = tile / (N_tile(N.x) * N_tile(N.y));
+        return { t1 * S + r % S, t2 * S + (r / S) % S, t3 * S + r / (S * S) };
+    }
+    static int3 tile_size(int3 const&) { return { S, S, S }; }
+};
+
+struct grid_layout_morton
+{
+    static bool constexpr is_linear = false;
+    static std::string name() { return "morton"; }
+
+    // Side of the power of two square (cube) enclosing the grid
+    static int side(int N) { int s = 1; while (s < N) s *= 2; return s; }
+
+    // Spread the bits of k: bit i goes to bit 2i (resp. 3i)
+    static unsigned int spread_2(unsigned int k)
+    {
+        k = (k | (k << 8)) & 0x00FF00FFu;
+        k = (k | (k << 4)) & 0x0F0F0F0Fu;
+        k = (k | (k << 2)) & 0x33333333u;
+        k = (k | (k << 1)) & 0x55555555u;
+        return k;
+    }
+    static unsigned int compact_2(unsigned int k)
+    {
+        k &= 0x55555555u;
+        k = (k | (k >> 1)) & 0x33333333u;
+        k = (k | (k >> 2)) & 0x0F0F0F0Fu;
+        k = (k | (k >> 4)) & 0x00FF00FFu;
+        k = (k | (k >> 8)) & 0x0000FFFFu;
+        return k;
+    }
+    static unsigned int spread_3(unsigned int k)
+    {
+        k = (k | (k << 16)) & 0x030000FFu;
+        k = (k | (k << 8)) & 0x0300F00Fu;
+        k = (k | (k << 4)) & 0x030C30C3u;
+        k = (k | (k << 2)) & 0x09249249u;
+        return k;
+    }
+    static unsigned int compact_3(unsigned int k)
+    {
+        k &= 0x09249249u;
+        k = (k | (k >> 2)) & 0x030C30C3u;
+        k = (k | (k >> 4)) & 0x0300F00Fu;
+        k = (k | (k >> 8)) & 0x030000FFu;
+        k = (k | (k >> 16)) & 0x000003FFu;
+        return k;
+    }
+
+    static int storage_size(int2 const& N) { int const s = side(std::max(N.x, N.y)); return s * s; }
+    static int offset(int k1, int k2, int2 const&) { return static_cast<int>(spread_2(k1) | (spread_2(k2) << 1)); }
+    static int2 index(int offset, int2 const&) { return { static_cast<int>(compact_2(offset)), static_cast<int>(compact_2(offset >> 1)) }; }
+    static int2 tile_size(int2 const&) { return { 8, 8 }; }
+
+    static int storage_size(int3 const& N) { int const s = side(std::max(std::max(N.x, N.y), N.z)); return s * s * s; }
+    static int offset(int k1, int k2, int k3, int3 const&) { return static_cast<int>(spread_3(k1) | (spread_3(k2) << 1) | (spread_3(k3) << 2)); }
+    static int3 index(int offset, int3 const&) { return { static_cast<int>(compact_3(offset)), static_cast<int>(compact_3(offset >> 1)), static_cast<int>(compact_3(offset >> 2)) }; }
+    static int3 tile_size(int3 const&) { return { 8, 8, 8 }; }
+};
+
+
+
+/** Tiles of a grid: blocks [index_min, index_max[ covering the grid (the tiles on the last rows/columns are cropped to the grid)
+ *  An empty grid, or a tile size that is not strictly positive, has no tile.
+ *  The tiles are ordered row of tiles after row of tiles. They can be walked with a range-for loop, or by index (ex. in a parallel loop):
+ *    for (grid_tile_2D const& tile : grid.tiles())
+ *      for (int k2 = tile.index_min.y; k2 < tile.index_max.y; ++k2)
+ *        for (int k1 = tile.index_min.x; k1 < tile.index_max.x; ++k1)
+ *          ... grid(k1,k2) ...
+ **/
+struct grid_tile_2D
+{
+    int2 index_min;
+    int2 index_max;
+};
+
+struct grid_tiles_2D
+{
+    int2 dimension;
+    int2 tile_size;
+
+    struct iterator
+    {
+        grid_tiles_2D const* tiles;
+        int k;
+        grid_tile_2D operator*() const { return (*tiles)[k]; }
+        iterator& operator++() { ++k; return *this; }
+        bool operator!=(iterator const& other) const { return k != other.k; }
+    };
+
+    // Number of tiles of size S covering N elements
+    static int count(int N, int S) { return N > 0 && S > 0 ? (N + S - 1) / S : 0; }
+
+    int2 N_tile() const { return { count(dimension.x, tile_size.x), count(dimension.y, tile_size.y) }; }
+    int size() const { int2 const n = N_tile(); return n.x * n.y; } // Number of tiles
+    grid_tile_2D operator[](int k) const
+    {
+        int const n1 = N_tile().x;
+        int2 const index_min = { (k % n1) * tile_size.x, (k / n1) * tile_size.y };
+        int2 const index_max = { std::min(index_min.x + tile_size.x, dimension.x), std::min(index_min.y + tile_size.y, dimension.y) };
+        return { index_min, index_max };
+    }
+    iterator begin() const { return { this, 0 }; }
+    iterator end() const { return { this, size() }; }
+};
+
+struct grid_tile_3D
+{
+    int3 index_min;
+    int3 index_max;
+};
+
+struct grid_tiles_3D
+{
+    int3 dimension;
+    int3 tile_size;
+
+    struct iterator
+    {
+        grid_tiles_3D const* tiles;
+        int k;
+        grid_tile_3D operator*() const { return (*tiles)[k]; }
+        iterator& operator++() { ++k; return *this; }
+        bool operator!=(iterator const& other) const { return k != other.k; }
+    };
+
+    int3 N_tile() const { return { grid_tiles_2D::count(dimension.x, tile_size.x), grid_tiles_2D::count(dimension.y, tile_size.y), grid_tiles_2D::count(dimension.z, tile_size.z) }; }
+    int size() const { int3 const n = N_tile(); return n.x * n.y * n.z; }
+    grid_tile_3D operator[](int k) const
+    {
+        int3 const n = N_tile();
+        int3 const index_min = { (k % n.x) * tile_size.x, ((k / n.x) % n.y) * tile_size.y, (k / (n.x * n.y)) * tile_size.z };
+        int3 const index_max = { std::min(index_min.x + tile_size.x, dimension.x), std::min(index_min.y + tile_size.y, dimension.y), std::min(index_min.z + tile_size.z, dimension.z) };
+        return { index_min, index_max };
+    }
+    iterator begin() const { return { this, 0 }; }
+    iterator end() const { return { this, size() }; }
+};
+
+}
@@ -92,5 +92,110 @@ namespace cgp_test {
 
 	}
 
+
+	// Every element (k1,k2) has its own offset in data, and offset_to_index is the inverse of index_to_offset
+	// The tiles cover each element exactly once
+	template <typename layout>
+	static void test_grid_layout_2D(int N1, int N2)
+	{
+		cgp::grid_2D<int, layout> a(N1, N2);
+		a.fill(-1);
+		for (int k2 = 0; k2 < N2; ++k2) {
+			for (int k1 = 0; k1 < N1; ++k1) {
+				int const offset = a.index_to_offset(k1, k2);
+				assert_cgp_no_msg(offset >= 0 && offset < int(a.data.size()));
+				assert_cgp_no_msg(a.data[offset] == -1);
+				assert_cgp_no_msg(is_equal(a.offset_to_index(offset), cgp::int2{ k1,k2 }));
+				a(k1, k2) = k1 + N1 * k2;
+			}
+		}
+
+		cgp::grid_2D<int> counter(N1, N2);
+		for (cgp::grid_tile_2D const& tile : a.tiles()) {
+			for (int k2 = tile.index_min.y; k2 < tile.index_max.y; ++k2)
+				for (int k1 = tile.index_min.x; k1 < tile.index_max.x; ++k1)
+					counter(k1, k2) += 1;
+		}
+		for (int k2 = 0; k2 < N2; ++k2)
+			for (int k1 = 0; k1 < N1; ++k1)
+				assert_cgp_no_msg(counter(k1, k2) == 1 && a(k1, k2) == k1 + N1 * k2);
+	}
+
+	template <typename layout>
+	static void test_grid_layout_3D(int N1, int N2, int N3)
+	{
+		cgp::grid_3D<int, layout> a(N1, N2, N3);
+		a.fill(-1);
+		for (int k3 = 0; k3 < N3; ++k3) {
+			for (int k2 = 0; k2 < N2; ++k2) {
+				for (int k1 = 0; k1 < N1; ++k1) {
+					int const offset = a.index_to_offset(k1, k2, k3);
+					assert_cgp_no_msg(offset >= 0 && offset < int(a.data.size()));
+					assert_cgp_no_msg(a.data[offset] == -1);
+					assert_cgp_no_msg(is_equal(a.offset_to_index(offset), cgp::int3{ k1,k2,k3 }));
+					a(k1, k2, k3) = k1 + N1 * (k2 + N2 * k3);
+				}
+			}
+		}
+
+		cgp::grid_3D<int> counter(N1, N2, N3);
+		for (cgp::grid_tile_3D const& tile : a.tiles({ 4,3,2 })) {
+			for (int k3 = tile.index_min.z; k3 < tile.index_max.z; ++k3)
+				for (int k2 = tile.index_min.y; k2 < tile.index_max.y; ++k2)
+					for (int k1 = tile.index_min.x; k1 < tile.index_max.x; ++k1)
+						counter(k1, k2, k3) += 1;
+		}
+		for (int k3 = 0; k3 < N3; ++k3)
+			for (int k2 = 0; k2 < N2; ++k2)
+				for (int k1 = 0; k1 < N1; ++k1)
+					assert_cgp_no_msg(counter(k1, k2, k3) == 1 && a(k1, k2, k3) == k1 + N1 * (k2 + N2 * k3));
+	}
+
+	void test_grid_layout()
+	{
+		test_grid_layout_2D<cgp::grid_layout_linear>(13, 7);
+		test_grid_layout_2D<cgp::grid_layout_padded<16> >(13, 7);
+		test_grid_layout_2D<cgp::grid_layout_tiled<8> >(13, 7);
+		test_grid_layout_2D<cgp::grid_layout_morton>(13, 7);
+		test_grid_layout_2D<cgp::grid_layout_tiled<4> >(16, 16);
+
+		// Empty grids have no tile
+		test_grid_layout_2D<cgp::grid_layout_linear>(0, 0);
+		test_grid_layout_2D<cgp::grid_layout_linear>(0, 7);
+		test_grid_layout_2D<cgp::grid_layout_padded<16> >(0, 7);
+		test_grid_layout_2D<cgp::grid_layout_tiled<8> >(13, 0);
+		assert_cgp_no_msg(cgp::grid_2D<int>().tiles().size() == 0);
+
+		test_grid_layout_3D<cgp::grid_layout_linear>(5, 7, 3);
+		test_grid_layout_3D<cgp::grid_layout_padded<8> >(5, 7, 3);
+		test_grid_layout_3D<cgp::grid_layout_tiled<4> >(5, 7, 3);
+		test_grid_layout_3D<cgp::grid_layout_morton>(5, 7, 3);
+		test_grid_layout_3D<cgp::grid_layout_linear>(0, 7, 3);
+		assert_cgp_no_msg(cgp::grid_3D<int>().tiles().size() == 0);
+
+		{
+			// Linear order of the elements given to from_buffer, whatever the layout
+			cgp::numarray<int> buffer = { 1,2,3,4,5,6 };
+			cgp::grid_2D<int, cgp::grid_layout_padded<4> > a = cgp::grid_2D<int, cgp::grid_layout_padded<4> >::from_buffer(buffer, 3, 2);
+			assert_cgp_no_msg(type_str(a) == "grid_2D<int,padded4>");
+			assert_cgp_no_msg(a.data.size() == 8);
+			assert_cgp_no_msg(a(2, 0) == 3 && a(0, 1) == 4);
+			assert_cgp_no_msg(a.data[4] == 4);
+		}
+
+		{
+			// The elements of a tile of the tiled layout are contiguous in memory
+			cgp::grid_2D<int, cgp::grid_layout_tiled<8> > a(20, 12);
+			assert_cgp_no_msg(type_str(a) == "grid_2D<int,tiled8>");
+			assert_cgp_no_msg(a.tiles().size() == 6);
+			for (cgp::grid_tile_2D const& tile : a.tiles()) {
+				int const offset_min = a.index_to_offset(tile.index_min.x, tile.index_min.y);
+				for (int k2 = tile.index_min.y; k2 < tile.index_max.y; ++k2)
+					for (int k1 = tile.index_min.x; k1 < tile.index_max.x; ++k1)
+						assert_cgp_no_msg(a.index_to_offset(k1, k2) - offset_min == (k1 - tile.index_min.x) + 8 * (k2 - tile.index_min.y));
+			}
+		}
+	}
+
 }
 
@@ -4,4 +4,5 @@ namespace cgp_test
 {
 	void test_grid_2D();
 	void test_grid_3D();
+	void test_grid_layout();
 }
@@ -9,9 +9,11 @@ void character_structure::load_and_initialize(filename_loader_structure const& p
 		std::string name = entry.first;
 		drawable[name].initialize_data_on_gpu(entry.second.mesh_deformed);
 		drawable[name].texture.load_and_initialize_texture_2d_on_gpu(param_loader.loader_rigged_mesh.at(name).texture);
+		drawable_revision[name] = entry.second.deformed_revision;
 	}
 	
 	sk_drawable = skeleton_drawable(animated_model.skeleton);
+	sk_drawable_pose_version = animated_model.pose_version;
 	set_current_animation(animated_model.animation.begin()->first);
 }
 
@@ -20,3 +22,24 @@ void character_structure::set_current_animation(std::string const& animation_nam
 	timer.event_period = animated_model.animation[current_animation_name].time_max;
 }
 
+
+void character_structure::update_drawable(std::string const& mesh_name)
+{
+	rigged_mesh_structure const& rigged_mesh = animated_model.rigged_mesh.at(mesh_name);
+	int& revision = drawable_revision[mesh_name];
+	if(revision == rigged_mesh.deformed_revision)
+		return;
+
+	mesh_drawable& d = drawable[mesh_name];
+	d.vbo_position.update(rigged_mesh.mesh_deformed.position);
+	d.vbo_normal.update(rigged_mesh.mesh_deformed.normal);
+	revision = rigged_mesh.deformed_revision;
+}
+
+void character_structure::update_sk_drawable()
+{
+	if(sk_drawable_pose_version == animated_model.pose_version)
+		return;
+	sk_drawable.update(animated_model.skeleton);
+	sk_drawable_pose_version = animated_model.pose_version;
+}
@@ -20,11 +20,23 @@ struct character_structure {
 	// The name of the current active animation
 	std::string current_animation_name;
 
+	// Memory option for crowds and background characters: the skinning data is compressed once loaded (see animated_model_structure::compress_skinning)
+	//  The compression can't be undone, and is slower than the uncompressed skinning of a single character.
+	bool compressed_skinning = false;
+
 	// Stores a mesh_drawable for each mesh of the rigged_character
 	std::map<std::string, cgp::mesh_drawable> drawable;
 	// The drawable structure to display a skeleton
 	skeleton_drawable sk_drawable;
 
+	// deformed_revision of each rigged mesh, and pose_version of the skeleton, last sent to the GPU
+	std::map<std::string, int> drawable_revision;
+	int sk_drawable_pose_version = -1;
+
+	// Update the buffers of the drawable of a mesh (resp. of the skeleton) only if the deformed mesh (resp. the pose) changed since the last update
+	void update_drawable(std::string const& mesh_name);
+	void update_sk_drawable();
+
 
 	// Use this method to set a new animation 
 	//  - Change the name of the current animation
@@ -2,56 +2,354 @@
 
 using namespace cgp;
 
-void animated_model_structure::skinning_lbs(std::string const& mesh_name)
+// Readers of the packed skinning data of a block, decoding the compressed format (see skinning_packed_structure)
+//  compressed is a template parameter: the kernels are instantiated for each format, without test in their loops.
+
+// Bind normal of the vertices of a block (decoded from the octahedral encoding and normalized if compressed)
+template <bool compressed>
+static void skinning_block_normal(skinning_packed_structure const& packed, int k_block, float* n0x, float* n0y, float* n0z)
+{
+    int const B = skinning_block_size;
+    if (compressed) {
+        int16_t const* ou = packed.normal_octahedral.data.data() + (2 * k_block + 0) * B;
+        int16_t const* ov = packed.normal_octahedral.data.data() + (2 * k_block + 1) * B;
+#pragma omp simd
+        for (int l = 0; l < B; ++l) {
+            float const x = ou[l] * (1.0f / 32767.0f), y = ov[l] * (1.0f / 32767.0f);
+            float const z = 1.0f - std::abs(x) - std::abs(y);
+            float const t = std::max(-z, 0.0f);
+            float const ux = x - std::copysign(t, x), uy = y - std::copysign(t, y);
+            float const inv = 1.0f / std::sqrt(ux * ux + uy * uy + z * z);
+            n0x[l] = ux * inv; n0y[l] = uy * inv; n0z[l] = z * inv;
+        }
+    }
+    else {
+        float const* nx = packed.normal_bind.data.data() + (3 * k_block + 0) * B;
+        float const* ny = packed.normal_bind.data.data() + (3 * k_block + 1) * B;
+        float const* nz = packed.normal_bind.data.data() + (3 * k_block + 2) * B;
+#pragma omp simd
+        for (int l = 0; l < B; ++l) {
+            n0x[l] = nx[l]; n0y[l] = ny[l]; n0z[l] = nz[l];
+        }
+    }
+}
+
+// Offset m=stride*joint of the transformation and weight w of the influence k of the vertices of a block
+//  The offsets are widened to 32 bits: the gathers of the blend loops then use 8 lanes.
+template <bool compressed>
+static void skinning_block_influence(skinning_packed_structure const& packed, int k_block, int k, int stride, int* m, float* w)
+{
+    int const B = skinning_block_size;
+    int const offset = (k_block * packed.N_influence + k) * B;
+    if (compressed) {
+        uint8_t const* j = packed.joint_quantized.data.data() + offset;
+        uint8_t const* wq = packed.weight_quantized.data.data() + offset;
+#pragma omp simd
+        for (int l = 0; l < B; ++l) {
+            m[l] = stride * j[l];
+            w[l] = wq[l] * (1.0f / 255.0f);
+        }
+    }
+    else {
+        uint16_t const* j = packed.joint.data.data() + offset;
+        float const* wf = packed.weight.data.data() + offset;
+#pragma omp simd
+        for (int l = 0; l < B; ++l) {
+            m[l] = stride * j[l];
+            w[l] = wf[l];
+        }
+    }
+}
+
+// Linear blend skinning of the packed vertices, by blocks of skinning_block_size vertices
+//  T: transformation of each local joint as a 3x4 matrix (12 floats, row major)
+//  The innermost loops run over the vertices of a block with a fixed trip count: they are compiled as SIMD operations,
+//  the rows of the matrices of the 8 vertices being gathered with their joint indices.
+template <int N_influence, bool compressed>
+static void skinning_lbs_packed(skinning_packed_structure const& packed, float const* T, vec3* position, vec3* normal, int block_min, int block_max)
 {
-    cgp::mesh const& mesh_bind_pose = rigged_mesh[mesh_name].mesh_bind_pose;
-    cgp::mesh& mesh_deformed = rigged_mesh[mesh_name].mesh_deformed;
-    controller_skinning_structure const& controller_skinning = rigged_mesh[mesh_name].controller_skinning;
+    int const B = skinning_block_size;
+
+    for (int k_block = block_min; k_block < block_max; ++k_block) {
+        float const* p0x = packed.position_bind.data.data() + (3 * k_block + 0) * B;
+        float const* p0y = packed.position_bind.data.data() + (3 * k_block + 1) * B;
+        float const* p0z = packed.position_bind.data.data() + (3 * k_block + 2) * B;
+        float n0x[B], n0y[B], n0z[B];
+        skinning_block_normal<compressed>(packed, k_block, n0x, n0y, n0z);
+
+        float px[B], py[B], pz[B], nx[B], ny[B], nz[B];
+#pragma omp simd
+        for (int l = 0; l < B; ++l) {
+            px[l] = 0.0f; py[l] = 0.0f; pz[l] = 0.0f;
+            nx[l] = 0.0f; ny[l] = 0.0f; nz[l] = 0.0f;
+        }
+
+        for (int k = 0; k < N_influence; ++k) {
+            int m[B];
+            float w[B];
+            skinning_block_influence<compressed>(packed, k_block, k, 12, m, w);
+
+#pragma omp simd
+            for (int l = 0; l < B; ++l) {
+                px[l] += w[l] * (T[m[l] + 0] * p0x[l] + T[m[l] + 1] * p0y[l] + T[m[l] + 2] * p0z[l] + T[m[l] + 3]);
+                py[l] += w[l] * (T[m[l] + 4] * p0x[l] + T[m[l] + 5] * p0y[l] + T[m[l] + 6] * p0z[l] + T[m[l] + 7]);
+                pz[l] += w[l] * (T[m[l] + 8] * p0x[l] + T[m[l] + 9] * p0y[l] + T[m[l] + 10] * p0z[l] + T[m[l] + 11]);
+                nx[l] += w[l] * (T[m[l] + 0] * n0x[l] + T[m[l] + 1] * n0y[l] + T[m[l] + 2] * n0z[l]);
+                ny[l] += w[l] * (T[m[l] + 4] * n0x[l] + T[m[l] + 5] * n0y[l] + T[m[l] + 6] * n0z[l]);
+                nz[l] += w[l] * (T[m[l] + 8] * n0x[l] + T[m[l] + 9] * n0y[l] + T[m[l] + 10] * n0z[l]);
+            }
+        }
+
+        int const N_lane = std::min(B, packed.N_vertex - k_block * B);
+        for (int l = 0; l < N_lane; ++l) {
+            position[k_block * B + l] = { px[l], py[l], pz[l] };
+            normal[k_block * B + l] = { nx[l], ny[l], nz[l] };
+        }
+    }
+}
+
+// Dual quaternion skinning of the packed vertices, by blocks of skinning_block_size vertices
+//  Q: dual quaternion and uniform scaling of each local joint (9 floats: real part xyzw, dual part xyzw, scaling)
+//  For each vertex, the dual quaternions are blended in the hemisphere of its strongest influence (the first one in skinning_packed),
+//  normalized, and applied to the bind position scaled by the blended scaling. The normal is rotated and scaled as with linear blend skinning.
+template <int N_influence, bool compressed>
+static void skinning_dqs_packed(skinning_packed_structure const& packed, float const* Q, vec3* position, vec3* normal, int block_min, int block_max)
+{
+    int const B = skinning_block_size;
+
+    for (int k_block = block_min; k_block < block_max; ++k_block) {
+        float const* p0x = packed.position_bind.data.data() + (3 * k_block + 0) * B;
+        float const* p0y = packed.position_bind.data.data() + (3 * k_block + 1) * B;
+        float const* p0z = packed.position_bind.data.data() + (3 * k_block + 2) * B;
+        float n0x[B], n0y[B], n0z[B];
+        skinning_block_normal<compressed>(packed, k_block, n0x, n0y, n0z);
+
+        // Blended real part (qx,qy,qz,qw), dual part (dx,dy,dz,dw) and scaling
+        float qx[B], qy[B], qz[B], qw[B], dx[B], dy[B], dz[B], dw[B], sc[B];
+#pragma omp simd
+        for (int l = 0; l < B; ++l) {
+            qx[l] = 0.0f; qy[l] = 0.0f; qz[l] = 0.0f; qw[l] = 0.0f;
+            dx[l] = 0.0f; dy[l] = 0.0f; dz[l] = 0.0f; dw[l] = 0.0f;
+            sc[l] = 0.0f;
+        }
+
+        // Real part of the strongest influence, defining the hemisphere of the blend
+        float rx[B], ry[B], rz[B], rw[B];
+        for (int k = 0; k < N_influence; ++k) {
+            int m[B];
+            float w[B];
+            skinning_block_influence<compressed>(packed, k_block, k, 9, m, w);
+            if (k == 0) {
+#pragma omp simd
+                for (int l = 0; l < B; ++l) {
+                    rx[l] = Q[m[l] + 0]; ry[l] = Q[m[l] + 1]; rz[l] = Q[m[l] + 2]; rw[l] = Q[m[l] + 3];
+                }
+            }
+
+#pragma omp simd
+            for (int l = 0; l < B; ++l) {
+                float const ax = Q[m[l] + 0], ay = Q[m[l] + 1], az = Q[m[l] + 2], aw = Q[m[l] + 3];
+                bool const same_hemisphere = ax * rx[l] + ay * ry[l] + az * rz[l] + aw * rw[l] >= 0.0f;
+                float const wk = same_hemisphere ? w[l] : -w[l];
+                qx[l] += wk * ax; qy[l] += wk * ay; qz[l] += wk * az; qw[l] += wk * aw;
+                dx[l] += wk * Q[m[l] + 4]; dy[l] += wk * Q[m[l] + 5]; dz[l] += wk * Q[m[l] + 6]; dw[l] += wk * Q[m[l] + 7];
+                sc[l] += w[l] * Q[m[l] + 8];
+            }
+        }
+
+        float px[B], py[B], pz[B], nx[B], ny[B], nz[B];
+#pragma omp simd
+        for (int l = 0; l < B; ++l) {
+            // Normalization (the lanes after the last vertex have a zero blend: kept finite by the small offset)
+            float const n2 = qx[l] * qx[l] + qy[l] * qy[l] + qz[l] * qz[l] + qw[l] * qw[l];
+            float const inv = 1.0f / std::sqrt(n2 + 1e-30f);
+            float const x = qx[l] * inv, y = qy[l] * inv, z = qz[l] * inv, w = qw[l] * inv;
+            float const ex = dx[l] * inv, ey = dy[l] * inv, ez = dz[l] * inv, ew = dw[l] * inv;
+
+            // Translation t = 2 (w e - ew q + q x e)
+            float const tx = 2.0f * (w * ex - ew * x + y * ez - z * ey);
+            float const ty = 2.0f * (w * ey - ew * y + z * ex - x * ez);
+            float const tz = 2.0f * (w * ez - ew * z + x * ey - y * ex);
+
+            // Rotation v + 2 q x (q x v + w v) of the scaled bind position and normal
+            float const vx = sc[l] * p0x[l], vy = sc[l] * p0y[l], vz = sc[l] * p0z[l];
+            float const cx = y * vz - z * vy + w * vx;
+            float const cy = z * vx - x * vz + w * vy;
+            float const cz = x * vy - y * vx + w * vz;
+            px[l] = vx + 2.0f * (y * cz - z * cy) + tx;
+            py[l] = vy + 2.0f * (z * cx - x * cz) + ty;
+            pz[l] = vz + 2.0f * (x * cy - y * cx) + tz;
+
+            float const ux = sc[l] * n0x[l], uy = sc[l] * n0y[l], uz = sc[l] * n0z[l];
+            float const bx = y * uz - z * uy + w * ux;
+            float const by = z * ux - x * uz + w * uy;
+            float const bz = x * uy - y * ux + w * uz;
+            nx[l] = ux + 2.0f * (y * bz - z * by);
+            ny[l] = uy + 2.0f * (z * bx - x * bz);
+            nz[l] = uz + 2.0f * (x * by - y * bx);
+        }
+
+        int const N_lane = std::min(B, packed.N_vertex - k_block * B);
+        for (int l = 0; l < N_lane; ++l) {
+            position[k_block * B + l] = { px[l], py[l], pz[l] };
+            normal[k_block * B + l] = { nx[l], ny[l], nz[l] };
+        }
+    }
+}
 
+void rigged_mesh_structure::skinning_update_transformation(skeleton_structure const& skeleton)
+{
+    assert_cgp(skinning_packed.N_vertex == mesh_deformed.position.size(), "The packed skinning weights of the mesh are not initialized");
 
-    // Prepare the transformation matrix for all the joints that impact the current mesh
+    // Prepare the transformation (3x4 block, or dual quaternion and scaling) for all the joints that impact the current mesh
     int N_impacting_joints = controller_skinning.inverse_bind_matrices.size(); // only a subset of the skeleton joints may impact the current mesh
-    cgp::numarray<cgp::mat4> transformation_matrix;
-    transformation_matrix.resize(N_impacting_joints);
+    int const stride = method==skinning_method::linear_blend ? 12 : 9;
+    skinning_transformation.resize(stride * N_impacting_joints);
     for(int k=0; k<N_impacting_joints; ++k) {
         mat4 const& inv_bind_pose = controller_skinning.inverse_bind_matrices.at(k); // the inverse of the bind pose (precomputed)
         int joint_index_in_skeleton = controller_skinning.rig_index_to_skeleton_index.at(k); // need to find the corresponding index of this joint into the global skeleton
         mat4 const& joint_current = skeleton.joint_matrix_global.at(joint_index_in_skeleton); // retrieve the current joint pose in the global position
 
-        transformation_matrix.at(k) = joint_current * inv_bind_pose;
+        mat4 const T = joint_current * inv_bind_pose;
+        if(method==skinning_method::linear_blend) {
+            for(int i=0; i<3; ++i)
+                for(int j=0; j<4; ++j)
+                    skinning_transformation[12*k + 4*i + j] = T(i,j);
+        }
+        else {
+            // T = [s R | t]: unit dual quaternion q + e (t q)/2 of the rigid part, and the uniform scaling s
+            mat3 const linear = T.get_block_linear();
+            float const s = std::cbrt(det(linear));
+            quaternion const q = normalize(rotation_transform::convert_matrix_to_quaternion(linear / s));
+            vec3 const t = T.get_block_translation();
+            quaternion const d = 0.5f * (quaternion(t.x, t.y, t.z, 0.0f) * q);
+            for(int i=0; i<4; ++i) {
+                skinning_transformation[9*k + i] = q[i];
+                skinning_transformation[9*k + 4 + i] = d[i];
+            }
+            skinning_transformation[9*k + 8] = s;
+        }
     }
+}
 
-    // Compute skinning deformation
-    int N_vertex = mesh_bind_pose.position.size();
-    for(int k_vertex=0; k_vertex<N_vertex; ++k_vertex) {
-        int N_dependence = controller_skinning.vertex_to_joint_dependence.at(k_vertex).size();
-        auto const& vertex_to_joint_dependence = controller_skinning.vertex_to_joint_dependence.at(k_vertex);
-        vec3 const& p0 = mesh_bind_pose.position.at(k_vertex);
-        vec3 const& n0 = mesh_bind_pose.normal.at(k_vertex);
-
-        vec3 p_accumulated;
-        vec3 n_accumulated;
-        for(int k=0; k<N_dependence; ++k) {
-            auto const& dependence = vertex_to_joint_dependence.at(k);
-            int joint_index = dependence.joint_index;
-            float weight = dependence.weight;
-
-            mat4 const& T = transformation_matrix.at(joint_index);
-
-            vec3 p_tmp = T.transform_position(p0);
-            vec3 n_tmp = T.transform_vector(n0);
-            p_tmp *= weight;
-            n_tmp *= weight;
-            p_accumulated += p_tmp;
-            n_accumulated += n_tmp;
-        }
-        mesh_deformed.position[k_vertex] = p_accumulated;
-        mesh_deformed.normal[k_vertex] = n_accumulated;
+bool rigged_mesh_structure::skinning_up_to_date(int pose_version) const
+{
+    return deformed_pose_version==pose_version && deformed_method==method;
+}
+
+void rigged_mesh_structure::skinning_lbs_blocks(int block_min, int block_max)
+{
+    float const* T = skinning_transformation.data.data();
+    vec3* position = mesh_deformed.position.data.data();
+    vec3* normal = mesh_deformed.normal.data.data();
+    int const N_influence = skinning_packed.N_influence;
+    if(method==skinning_method::dual_quaternion) {
+        if(skinning_packed.compressed) {
+            if(N_influence==4) skinning_dqs_packed<4,true>(skinning_packed, T, position, normal, block_min, block_max);
+            else               skinning_dqs_packed<8,true>(skinning_packed, T, position, normal, block_min, block_max);
+        }
+        else {
+            if(N_influence==4) skinning_dqs_packed<4,false>(skinning_packed, T, position, normal, block_min, block_max);
+            else               skinning_dqs_packed<8,false>(skinning_packed, T, position, normal, block_min, block_max);
+        }
+    }
+    else {
+        if(skinning_packed.compressed) {
+            if(N_influence==4) skinning_lbs_packed<4,true>(skinning_packed, T, position, normal, block_min, block_max);
+            else               skinning_lbs_packed<8,true>(skinning_packed, T, position, normal, block_min, block_max);
+        }
+        else {
+            if(N_influence==4) skinning_lbs_packed<4,false>(skinning_packed, T, position, normal, block_min, block_max);
+            else               skinning_lbs_packed<8,false>(skinning_packed, T, position, normal, block_min, block_max);
+        }
     }
 }
 
+static size_t memory_size(mesh const& m)
+{
+    return (m.position.size() + m.normal.size() + m.color.size()) * sizeof(vec3) + m.uv.size() * sizeof(vec2) + m.connectivity.size() * sizeof(uint3);
+}
+
+size_t rigged_mesh_structure::memory_size() const
+{
+    size_t size = ::memory_size(mesh_bind_pose) + ::memory_size(mesh_deformed);
+    for (auto const& dependence : controller_skinning.vertex_to_joint_dependence)
+        size += sizeof(dependence) + dependence.size() * sizeof(skinning_weight_info);
+    size += controller_skinning.inverse_bind_matrices.size() * sizeof(mat4) + controller_skinning.rig_index_to_skeleton_index.size() * sizeof(int);
+    size += skinning_packed.memory_size() + skinning_transformation.size() * sizeof(float);
+    return size;
+}
+
+void animated_model_structure::compress_skinning()
+{
+    for(auto& entry : rigged_mesh) {
+        rigged_mesh_structure& rigged = entry.second;
+        assert_cgp(rigged.controller_skinning.vertex_to_joint_dependence.size() == rigged.mesh_bind_pose.position.size(), "The skinning of the mesh "+entry.first+" is already compressed");
+        rigged.skinning_packed.initialize(rigged.controller_skinning, rigged.mesh_bind_pose, true);
+        rigged.controller_skinning.vertex_to_joint_dependence = numarray<numarray<skinning_weight_info> >();
+        rigged.mesh_bind_pose = mesh();
+    }
+}
+
+size_t animated_model_structure::memory_size_rigged_mesh() const
+{
+    size_t size = 0;
+    for(auto const& entry : rigged_mesh)
+        size += entry.second.memory_size();
+    return size;
+}
+
+void animated_model_structure::skinning_lbs(std::string const& mesh_name)
+{
+    rigged_mesh_structure& rigged = rigged_mesh[mesh_name];
+    rigged.skinning_update_transformation(skeleton);
+    rigged.skinning_lbs_blocks(0, rigged.skinning_packed.N_block());
+    rigged.deformed_pose_version = pose_version;
+    rigged.deformed_method = rigged.method;
+    rigged.deformed_revision++;
+}
+
+void skinning_lbs_parallel(std::vector<animated_model_structure*> const& models, int blocks_per_task)
+{
+    assert_cgp_no_msg(blocks_per_task > 0);
+
+    // Joint transformations of every mesh, and the list of tasks (a mesh and a range of blocks)
+    struct task_structure { rigged_mesh_structure* rigged; int block_min; int block_max; };
+    std::vector<task_structure> tasks;
+    for(animated_model_structure* model : models) {
+        for(auto& entry : model->rigged_mesh) {
+            rigged_mesh_structure& rigged = entry.second;
+            if(rigged.skinning_up_to_date(model->pose_version))
+                continue;
+            rigged.skinning_update_transformation(model->skeleton);
+            rigged.deformed_pose_version = model->pose_version;
+            rigged.deformed_method = rigged.method;
+            rigged.deformed_revision++;
+
+            int const N_block = rigged.skinning_packed.N_block();
+            for(int block_min=0; block_min<N_block; block_min+=blocks_per_task)
+                tasks.push_back({ &rigged, block_min, std::min(block_min+blocks_per_task, N_block) });
+        }
+    }
+
+    // The tasks write disjoint ranges of the deformed meshes
+    int const N_task = int(tasks.size());
+#pragma omp parallel for schedule(dynamic)
+    for(int k=0; k<N_task; ++k)
+        tasks[k].rigged->skinning_lbs_blocks(tasks[k].block_min, tasks[k].block_max);
+}
+
+void animated_model_structure::pose_changed()
+{
+    pose_version++;
+    pose_animation_name.clear();
+}
+
 void animated_model_structure::set_skeleton_from_animation(std::string const& animation_name, float t)
 {
+    if(animation_name==pose_animation_name && t==pose_time)
+        return;
+
     auto const& current_animation = animation[animation_name];
     int N_joint = current_animation.joint_index.size();
     for(int k=0; k<N_joint; ++k) {
@@ -60,6 +358,10 @@ void animated_model_structure::set_skeleton_from_animation(std::string const& an
         skeleton.joint_matrix_local[joint] = M;
     }
     skeleton.update_joint_matrix_local_to_global();
+
+    pose_changed();
+    pose_animation_name = animation_name;
+    pose_time = t;
 }
 
 void animated_model_structure::apply_transformation(vec3 const& translation, rotation_transform rotation, float scaling)
@@ -81,4 +383,5 @@ void animated_model_structure::apply_transformation(vec3 const& translation, rot
         }
     }
 
+    pose_changed();
 }
\ No newline at end of file
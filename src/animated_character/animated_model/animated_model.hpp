@@ -6,10 +6,34 @@
 #include "../skeleton_structure/skeleton_structure.hpp"
 #include "../skeleton_animation/skeleton_animation.hpp"
 
+// Skinning deformation of a rigged mesh
+//  - linear_blend: blend of the joint matrices (the volume collapses around the joints that twist: candy-wrapper effect)
+//  - dual_quaternion: blend of the rigid joint transformations as unit dual quaternions (the uniform scaling of the joints is blended separately)
+enum class skinning_method { linear_blend, dual_quaternion };
+
 struct rigged_mesh_structure {
     cgp::mesh mesh_bind_pose;  // Bind pose (/un-deformed) mesh
     cgp::mesh mesh_deformed;   // Deformed mesh
     controller_skinning_structure controller_skinning;   // skinning weights dependence
+    skinning_packed_structure skinning_packed;           // compacted weights and bind pose read by skinning_lbs (built from the two previous fields at load time)
+    skinning_method method = skinning_method::linear_blend;
+    cgp::numarray<float> skinning_transformation;        // transformation of each local joint for the current pose: 3x4 matrix (12 floats)
+                                                         //  with linear_blend, dual quaternion and scaling (9 floats: real part xyzw, dual part xyzw, scaling) with dual_quaternion
+
+    // State of mesh_deformed: pose_version of the skeleton and method of its last skinning, and number of times it was recomputed
+    //  (a copy of mesh_deformed, ex. on the GPU, only needs to be updated when deformed_revision changed)
+    int deformed_pose_version = -1;
+    skinning_method deformed_method = skinning_method::linear_blend;
+    int deformed_revision = 0;
+    bool skinning_up_to_date(int pose_version) const; // True if mesh_deformed already corresponds to this pose and to the current method
+
+    // Update skinning_transformation from the global joint matrices of the skeleton
+    void skinning_update_transformation(skeleton_structure const& skeleton);
+    // Deform the vertices of the blocks [block_min,block_max[ of skinning_packed with the current skinning_transformation
+    void skinning_lbs_blocks(int block_min, int block_max);
+
+    // Size in bytes of the meshes and skinning data (the per-vertex arrays of vertex_to_joint_dependence are counted with their header)
+    size_t memory_size() const;
 };
 
 struct animated_model_structure {
@@ -18,15 +42,40 @@ struct animated_model_structure {
     std::map<std::string, rigged_mesh_structure> rigged_mesh; // an animated model may be linked to multiple rigged meshes
     std::map<std::string, skeleton_animation_structure> animation; // storage for all the possible animation of this skeleton
 
+    // Version of the pose of the skeleton, incremented every time it changes: the skinning of an unchanged pose is skipped
+    //  set_skeleton_from_animation does not evaluate again the pose of its previous call (same animation and time).
+    //  The code modifying the skeleton directly must call pose_changed().
+    int pose_version = 0;
+    std::string pose_animation_name; // Animation and time of the pose set by the last set_skeleton_from_animation (empty if the skeleton changed since)
+    float pose_time = 0.0f;
+    void pose_changed();
+
     // Compute the joint position corresponding to the given animation_name at time t from the animation structure. Then update the skeleton structure in filling the local joint matrix. Finally update the global matrices of the skeleton.
     //  - t can be an arbitrary float values, the animation matrix are interpolated between the frames
     //  - This function doesn't call the Skinning deformation on the rigged_mesh
+    //  - Nothing is done if the skeleton is already in this pose (see pose_version)
     void set_skeleton_from_animation(std::string const& animation_name, float t);
     
 
-    // Compute the Linear Blend Skinning deformation on the designated rigged mesh
+    // Compute the skinning deformation on the designated rigged mesh (Linear Blend Skinning, or Dual Quaternion Skinning depending on its method)
+    //  Reads the packed weights of the mesh (skinning_packed), 8 vertices at a time. The joint transformations are assumed affine.
+    //  The deformation is always computed (see skinning_lbs_parallel to skip the meshes already up to date).
     void skinning_lbs(std::string const& mesh_name);
 
+    // Build the compressed format of skinning_packed for every rigged mesh (8 bits weights and joints, octahedral normals),
+    //  and release the data it is built from: vertex_to_joint_dependence and mesh_bind_pose (the packed data can't be initialized again).
+    void compress_skinning();
+    // Size in bytes of the rigged meshes
+    size_t memory_size_rigged_mesh() const;
+
     // Apply a tranlation, rotation, and scaling to all the skeleton structure (current skeleton and all animation)
     void apply_transformation(cgp::vec3 const& translation, cgp::rotation_transform rotation= cgp::rotation_transform(), float scaling=1.0f);
-};
\ No newline at end of file
+};
+
+
+// Skinning of all the rigged meshes of several models (ex. a crowd of characters) in a single parallel loop
+//  The vertices of every mesh are split in tasks of blocks_per_task blocks of skinning_block_size vertices, all the tasks
+//  being distributed over the threads together: the small meshes do not leave threads idle, and a single large mesh is still split.
+//  Each task writes directly in its range of mesh_deformed. The result is the same as skinning_lbs on each mesh.
+//  The meshes already deformed for the current pose of their model and with their current method are skipped.
+void skinning_lbs_parallel(std::vector<animated_model_structure*> const& models, int blocks_per_task = 64);
\ No newline at end of file
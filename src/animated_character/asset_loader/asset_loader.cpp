@@ -84,6 +84,7 @@ animated_model_structure mesh_skinning_loader(filename_loader_structure param, a
         rigged_mesh.controller_skinning.vertex_to_joint_dependence = vertex_to_joint_dependence;
         read_from_file(param_mesh.controller_skinning_rig_to_skeleton_joint_index, rigged_mesh.controller_skinning.rig_index_to_skeleton_index);
         read_from_file(param_mesh.controller_skinning_global_bind_matrix, rigged_mesh.controller_skinning.global_bind_matrix);
+        rigged_mesh.skinning_packed.initialize(rigged_mesh.controller_skinning, rigged_mesh.mesh_bind_pose);
     }
 
 
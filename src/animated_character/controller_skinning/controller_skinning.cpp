@@ -1,5 +1,8 @@
 #include "controller_skinning.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 std::string type_str(skinning_weight_info const& )
 {
     return "skinning_weight_info";
@@ -8,4 +11,130 @@ std::ostream& operator<<(std::ostream& s, skinning_weight_info const& weight_inf
 {
     s<<weight_info.joint_index<<" "<<weight_info.weight;
     return s;
-}
\ No newline at end of file
+}
+
+
+int skinning_packed_structure::N_block() const
+{
+    return (N_vertex + skinning_block_size - 1) / skinning_block_size;
+}
+
+size_t skinning_packed_structure::memory_size() const
+{
+    return joint.size() * sizeof(uint16_t) + (weight.size() + position_bind.size() + normal_bind.size()) * sizeof(float)
+        + joint_quantized.size() + weight_quantized.size() + normal_octahedral.size() * sizeof(int16_t);
+}
+
+void skinning_quantize_weight(float const* weight, uint8_t* weight_quantized, int N)
+{
+    int sum = 0;
+    float remainder[8];
+    assert_cgp_no_msg(N <= 8);
+    for (int k = 0; k < N; ++k) {
+        float const w = std::min(std::max(weight[k], 0.0f), 1.0f) * 255.0f;
+        int const q = static_cast<int>(w);
+        weight_quantized[k] = static_cast<uint8_t>(q);
+        remainder[k] = w - q;
+        sum += q;
+    }
+    if (sum == 0)
+        return; // no weight
+    while (sum < 255) {
+        int const k = static_cast<int>(std::max_element(remainder, remainder + N) - remainder);
+        weight_quantized[k]++;
+        remainder[k] = -1.0f;
+        sum++;
+    }
+}
+
+void octahedral_encode(cgp::vec3 const& n, int16_t& u, int16_t& v)
+{
+    float const l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    float x = l1 > 0 ? n.x / l1 : 0.0f;
+    float y = l1 > 0 ? n.y / l1 : 0.0f;
+    if (n.z < 0) { // lower half: folded on the corners of the square
+        float const fx = (1.0f - std::abs(y)) * (x >= 0 ? 1.0f : -1.0f);
+        float const fy = (1.0f - std::abs(x)) * (y >= 0 ? 1.0f : -1.0f);
+        x = fx;
+        y = fy;
+    }
+    u = static_cast<int16_t>(std::round(x * 32767.0f));
+    v = static_cast<int16_t>(std::round(y * 32767.0f));
+}
+
+cgp::vec3 octahedral_decode(int16_t u, int16_t v)
+{
+    float const x = u / 32767.0f, y = v / 32767.0f;
+    float const z = 1.0f - std::abs(x) - std::abs(y);
+    float const t = std::max(-z, 0.0f);
+    return cgp::normalize(cgp::vec3{ x - std::copysign(t, x), y - std::copysign(t, y), z });
+}
+
+void skinning_packed_structure::initialize(controller_skinning_structure const& controller_skinning, cgp::mesh const& mesh_bind_pose, bool compressed_arg)
+{
+    int const B = skinning_block_size;
+    N_vertex = mesh_bind_pose.position.size();
+    assert_cgp(controller_skinning.vertex_to_joint_dependence.size() == N_vertex, "The skinning weights do not match the vertices of the mesh");
+    assert_cgp(controller_skinning.inverse_bind_matrices.size() <= 65536, "Too many joints for 16 bits joint indices");
+    compressed = compressed_arg;
+    assert_cgp(!compressed || controller_skinning.inverse_bind_matrices.size() <= 256, "Too many joints for the 8 bits joint indices of the compressed skinning");
+
+    int N_dependence_max = 0;
+    for (int kv = 0; kv < N_vertex; ++kv)
+        N_dependence_max = std::max(N_dependence_max, int(controller_skinning.vertex_to_joint_dependence[kv].size()));
+    N_influence = N_dependence_max <= 4 ? 4 : 8;
+    N_truncated = 0;
+
+    // Only the buffers of the chosen format are allocated (the previous buffers are released)
+    int const N_weight = N_block() * N_influence * B;
+    joint = cgp::numarray<uint16_t>(compressed ? 0 : N_weight);
+    weight = cgp::numarray<float>(compressed ? 0 : N_weight);
+    position_bind = cgp::numarray<float>(N_block() * 3 * B);
+    normal_bind = cgp::numarray<float>(compressed ? 0 : N_block() * 3 * B);
+    joint_quantized = cgp::numarray<uint8_t>(compressed ? N_weight : 0);
+    weight_quantized = cgp::numarray<uint8_t>(compressed ? N_weight : 0);
+    normal_octahedral = cgp::numarray<int16_t>(compressed ? N_block() * 2 * B : 0);
+
+    for (int kv = 0; kv < N_vertex; ++kv) {
+        int const k_block = kv / B;
+        int const lane = kv % B;
+
+        // Keep the N_influence strongest weights
+        cgp::numarray<skinning_weight_info> dependence = controller_skinning.vertex_to_joint_dependence[kv];
+        std::sort(dependence.begin(), dependence.end(), [](skinning_weight_info const& a, skinning_weight_info const& b) { return a.weight > b.weight; });
+        if (dependence.size() > N_influence) {
+            dependence.resize(N_influence);
+            N_truncated++;
+        }
+        float weight_sum = 0.0f;
+        for (skinning_weight_info const& d : dependence)
+            weight_sum += d.weight;
+
+        float w[8];
+        for (int k = 0; k < dependence.size(); ++k)
+            w[k] = weight_sum > 0 ? dependence[k].weight / weight_sum : 0.0f;
+        uint8_t w_quantized[8];
+        if (compressed)
+            skinning_quantize_weight(w, w_quantized, dependence.size());
+
+        for (int k = 0; k < dependence.size(); ++k) {
+            int const offset = (k_block * N_influence + k) * B + lane;
+            if (compressed) {
+                joint_quantized[offset] = static_cast<uint8_t>(dependence[k].joint_index);
+                weight_quantized[offset] = w_quantized[k];
+            }
+            else {
+                joint[offset] = static_cast<uint16_t>(dependence[k].joint_index);
+                weight[offset] = w[k];
+            }
+        }
+
+        for (int kc = 0; kc < 3; ++kc)
+            position_bind[(k_block * 3 + kc) * B + lane] = mesh_bind_pose.position[kv][kc];
+        if (compressed)
+            octahedral_encode(mesh_bind_pose.normal[kv], normal_octahedral[(k_block * 2 + 0) * B + lane], normal_octahedral[(k_block * 2 + 1) * B + lane]);
+        else
+            for (int kc = 0; kc < 3; ++kc)
+                normal_bind[(k_block * 3 + kc) * B + lane] = mesh_bind_pose.normal[kv][kc];
+    }
+}
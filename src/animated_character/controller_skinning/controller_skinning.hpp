@@ -19,3 +19,45 @@ struct controller_skinning_structure {
     cgp::numarray<int> rig_index_to_skeleton_index; // correspondance between the index of the local joint (for a given mesh), and the index in the global skeleton structure
     cgp::mat4 global_bind_matrix;                   // A global bind matrix (usually identity)
 };
+
+
+// Number of vertices deformed together by the skinning kernel (one AVX register of floats)
+int constexpr skinning_block_size = 8;
+
+// Compacted copy of the skinning weights read by the skinning kernel, built once at load time
+//  Each vertex has exactly N_influence influences (4, or 8 if a vertex has more than 4 joints): its strongest weights, renormalized,
+//  completed by zero weights. The vertices are grouped by blocks of skinning_block_size, and each value is stored for the 8 vertices
+//  of a block contiguously (structure of arrays), so that the kernel reads the k-th influence of 8 vertices as one vector:
+//    joint[(k_block*N_influence + k_influence)*8 + lane], weight[...]          (local joint index, as in vertex_to_joint_dependence)
+//    position_bind[(k_block*3 + k_coordinate)*8 + lane], normal_bind[...]     (bind pose of the mesh)
+//  The lanes after the last vertex of the last block have zero weights.
+//
+// Compressed format (compressed=true, meshes with at most 256 local joints), decoded by the skinning kernel:
+//    joint_quantized[...]: 8 bits local joint index      weight_quantized[...]: weight*255, the weights of a vertex summing exactly to 255
+//    normal_octahedral[(k_block*2 + k)*8 + lane]: bind normal projected on the octahedron |x|+|y|+|z|=1, unfolded on the square [-1,1]^2, in 16 bits (x32767)
+//  The position is kept in float. joint, weight and normal_bind are then empty.
+struct skinning_packed_structure {
+    int N_vertex = 0;
+    int N_influence = 0;
+    int N_truncated = 0; // Number of vertices with more than 8 influences (their weakest influences are dropped)
+    bool compressed = false;
+
+    cgp::numarray<uint16_t> joint;
+    cgp::numarray<float> weight;
+    cgp::numarray<float> position_bind;
+    cgp::numarray<float> normal_bind;
+
+    cgp::numarray<uint8_t> joint_quantized;
+    cgp::numarray<uint8_t> weight_quantized;
+    cgp::numarray<int16_t> normal_octahedral;
+
+    void initialize(controller_skinning_structure const& controller_skinning, cgp::mesh const& mesh_bind_pose, bool compressed=false);
+    int N_block() const;
+    size_t memory_size() const; // Size of the buffers in bytes
+};
+
+// Quantize weights (summing to 1) on 8 bits such that they sum exactly to 255 (the rounding error goes to the largest fractional parts)
+void skinning_quantize_weight(float const* weight, uint8_t* weight_quantized, int N);
+// Octahedral encoding of a unit vector on two 16 bits values, and its decoding (normalized)
+void octahedral_encode(cgp::vec3 const& n, int16_t& u, int16_t& v);
+cgp::vec3 octahedral_decode(int16_t u, int16_t v);
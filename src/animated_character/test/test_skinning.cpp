@@ -0,0 +1,305 @@
+#include "cgp/01_base/base.hpp"
+#include "../animated_model/animated_model.hpp"
+
+#include <cmath>
+#include <iostream>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace cgp;
+
+namespace cgp_test {
+
+	// Rigged mesh of N_vertex vertices, each one depending on 1 to N_dependence_max joints among N_joint
+	static rigged_mesh_structure test_skinning_rigged_mesh(int N_vertex, int N_joint, int N_dependence_max)
+	{
+		rigged_mesh_structure rigged;
+		rigged.mesh_bind_pose.position.resize(N_vertex);
+		rigged.mesh_bind_pose.normal.resize(N_vertex);
+		rigged.controller_skinning.vertex_to_joint_dependence.resize(N_vertex);
+		for (int kv = 0; kv < N_vertex; ++kv) {
+			rigged.mesh_bind_pose.position[kv] = { std::sin(1.3f * kv), std::cos(0.7f * kv), 0.1f * (kv % 11) };
+			rigged.mesh_bind_pose.normal[kv] = normalize(vec3{ std::cos(0.3f * kv), 1.0f, std::sin(2.1f * kv) });
+
+			int const N_dependence = 1 + kv % N_dependence_max;
+			float weight_sum = 0.0f;
+			for (int k = 0; k < N_dependence; ++k) {
+				float const w = 1.0f + (kv * 7 + k * 3) % 5;
+				rigged.controller_skinning.vertex_to_joint_dependence[kv].push_back({ (kv + 5 * k) % N_joint, w });
+				weight_sum += w;
+			}
+			for (auto& d : rigged.controller_skinning.vertex_to_joint_dependence[kv])
+				d.weight /= weight_sum;
+		}
+		rigged.mesh_deformed = rigged.mesh_bind_pose;
+
+		for (int kj = 0; kj < N_joint; ++kj) {
+			rigged.controller_skinning.inverse_bind_matrices.push_back(mat4::build_translation(-0.1f * kj, 0.0f, 0.05f * kj));
+			rigged.controller_skinning.rig_index_to_skeleton_index.push_back(N_joint - 1 - kj);
+		}
+		rigged.skinning_packed.initialize(rigged.controller_skinning, rigged.mesh_bind_pose);
+		return rigged;
+	}
+
+	// The packed SIMD kernel gives the same deformation as blending the 4x4 matrices vertex by vertex
+	void test_skinning()
+	{
+		int const N_joint = 9;
+		animated_model_structure model;
+		for (int kj = 0; kj < N_joint; ++kj) {
+			mat4 M = mat4::build_rotation_from_axis_angle(normalize(vec3{ 1.0f,0.5f * kj,0.2f }), 0.4f * kj);
+			M.apply_scaling_to_block_linear(1.0f + 0.05f * kj);
+			M.apply_translation({ 0.3f * kj, -0.2f, 0.1f });
+			model.skeleton.joint_matrix_global.push_back(M);
+		}
+
+		// 37 vertices: the last block of 8 vertices is incomplete. 4 then 8 influences per vertex.
+		model.rigged_mesh["mesh_4"] = test_skinning_rigged_mesh(37, N_joint, 4);
+		model.rigged_mesh["mesh_8"] = test_skinning_rigged_mesh(37, N_joint, 6);
+		assert_cgp_no_msg(model.rigged_mesh["mesh_4"].skinning_packed.N_influence == 4);
+		assert_cgp_no_msg(model.rigged_mesh["mesh_8"].skinning_packed.N_influence == 8);
+
+		for (auto& entry : model.rigged_mesh) {
+			model.skinning_lbs(entry.first);
+
+			rigged_mesh_structure const& rigged = entry.second;
+			controller_skinning_structure const& controller = rigged.controller_skinning;
+			for (int kv = 0; kv < rigged.mesh_bind_pose.position.size(); ++kv) {
+				vec3 p, n;
+				for (skinning_weight_info const& d : controller.vertex_to_joint_dependence[kv]) {
+					mat4 const T = model.skeleton.joint_matrix_global[controller.rig_index_to_skeleton_index[d.joint_index]] * controller.inverse_bind_matrices[d.joint_index];
+					p += d.weight * T.transform_position(rigged.mesh_bind_pose.position[kv]);
+					n += d.weight * T.transform_vector(rigged.mesh_bind_pose.normal[kv]);
+				}
+				assert_cgp(norm(p - rigged.mesh_deformed.position[kv]) < 1e-5f, "Skinning position of the vertex " + str(kv) + " of " + entry.first);
+				assert_cgp(norm(n - rigged.mesh_deformed.normal[kv]) < 1e-5f, "Skinning normal of the vertex " + str(kv) + " of " + entry.first);
+			}
+		}
+
+		// The parallel skinning of several models gives the same meshes as skinning_lbs mesh by mesh, for any task size
+		{
+			animated_model_structure crowd[3] = { model, model, model };
+			for (int k = 0; k < 3; ++k)
+				crowd[k].skeleton.joint_matrix_global[2].apply_translation({ 0.0f, 0.1f * k, 0.0f });
+			crowd[2].rigged_mesh["mesh_large"] = test_skinning_rigged_mesh(203, N_joint, 5);
+			crowd[1].rigged_mesh["mesh_8"].method = skinning_method::dual_quaternion;
+
+			for (int blocks_per_task : { 1, 2, 64 }) {
+				for (int k = 0; k < 3; ++k) {
+					for (auto& entry : crowd[k].rigged_mesh)
+						entry.second.mesh_deformed.position.fill(vec3{ 0,0,0 });
+					crowd[k].pose_changed();
+				}
+#ifdef _OPENMP
+				// The tasks are run by several threads, whatever the number of cores
+				int const N_thread_default = omp_get_max_threads();
+				omp_set_num_threads(4);
+				skinning_lbs_parallel({ &crowd[0], &crowd[1], &crowd[2] }, blocks_per_task);
+				omp_set_num_threads(N_thread_default);
+#else
+				// Without OpenMP the tasks are run one after the other on a single thread
+				skinning_lbs_parallel({ &crowd[0], &crowd[1], &crowd[2] }, blocks_per_task);
+#endif
+
+				for (int k = 0; k < 3; ++k) {
+					animated_model_structure reference = crowd[k];
+					for (auto& entry : reference.rigged_mesh) {
+						reference.skinning_lbs(entry.first);
+						assert_cgp(is_equal(entry.second.mesh_deformed.position, crowd[k].rigged_mesh[entry.first].mesh_deformed.position), "Parallel skinning of " + entry.first);
+						assert_cgp(is_equal(entry.second.mesh_deformed.normal, crowd[k].rigged_mesh[entry.first].mesh_deformed.normal), "Parallel skinning of " + entry.first);
+					}
+				}
+			}
+		}
+
+		// Lazy skinning: a mesh is deformed again only if the pose of its model, or its skinning method, changed
+		{
+			animated_model_structure lazy = model;
+			skeleton_animation_structure& animation = lazy.animation["anim"];
+			lazy.skeleton.joint_matrix_local.resize(N_joint);
+			for (int kj = 0; kj < N_joint; ++kj) {
+				lazy.skeleton.parent_index.push_back(kj - 1);
+				animation.joint_index.push_back(kj);
+				animation.times.push_back(numarray<float>{ 0.0f, 1.0f });
+				animation.matrix.push_back(numarray<mat4>{ mat4::build_identity(), mat4::build_translation(0.0f, 0.1f * kj, 0.0f) });
+			}
+			animation.update_time_max();
+
+			lazy.set_skeleton_from_animation("anim", 0.25f);
+			int const version = lazy.pose_version;
+			skinning_lbs_parallel({ &lazy });
+			int const revision = lazy.rigged_mesh["mesh_4"].deformed_revision;
+
+			// Same animation and time (ex. paused animation): no new pose, no new skinning
+			lazy.set_skeleton_from_animation("anim", 0.25f);
+			skinning_lbs_parallel({ &lazy });
+			assert_cgp_no_msg(lazy.pose_version == version);
+			assert_cgp_no_msg(lazy.rigged_mesh["mesh_4"].deformed_revision == revision);
+
+			// The skeleton changed: the meshes are deformed again
+			lazy.set_skeleton_from_animation("anim", 0.5f);
+			skinning_lbs_parallel({ &lazy });
+			assert_cgp_no_msg(lazy.pose_version == version + 1);
+			assert_cgp_no_msg(lazy.rigged_mesh["mesh_4"].deformed_revision == revision + 1);
+			animated_model_structure reference = lazy;
+			reference.skinning_lbs("mesh_4");
+			assert_cgp_no_msg(is_equal(reference.rigged_mesh["mesh_4"].mesh_deformed.position, lazy.rigged_mesh["mesh_4"].mesh_deformed.position));
+
+			lazy.skeleton.joint_matrix_global[1].apply_translation({ 0.0f,0.0f,0.2f });
+			lazy.pose_changed();
+			lazy.set_skeleton_from_animation("anim", 0.5f); // the pose was modified since: evaluated again
+			assert_cgp_no_msg(lazy.pose_version == version + 3);
+			assert_cgp_no_msg(is_equal(lazy.skeleton.joint_matrix_global, reference.skeleton.joint_matrix_global));
+
+			// Only the mesh whose method changed is deformed again
+			lazy.rigged_mesh["mesh_8"].method = skinning_method::dual_quaternion;
+			skinning_lbs_parallel({ &lazy });
+			int const revision_4 = lazy.rigged_mesh["mesh_4"].deformed_revision;
+			int const revision_8 = lazy.rigged_mesh["mesh_8"].deformed_revision;
+			skinning_lbs_parallel({ &lazy });
+			lazy.rigged_mesh["mesh_8"].method = skinning_method::linear_blend;
+			skinning_lbs_parallel({ &lazy });
+			assert_cgp_no_msg(lazy.rigged_mesh["mesh_4"].deformed_revision == revision_4);
+			assert_cgp_no_msg(lazy.rigged_mesh["mesh_8"].deformed_revision == revision_8 + 1);
+		}
+
+		// Dual quaternion skinning: same deformation as the linear blend for vertices with a single joint (including the scaling of the joints)
+		{
+			model.rigged_mesh["mesh_1"] = test_skinning_rigged_mesh(37, N_joint, 1);
+			rigged_mesh_structure& rigged = model.rigged_mesh["mesh_1"];
+			model.skinning_lbs("mesh_1");
+			numarray<vec3> const position_lbs = rigged.mesh_deformed.position;
+			numarray<vec3> const normal_lbs = rigged.mesh_deformed.normal;
+
+			rigged.method = skinning_method::dual_quaternion;
+			model.skinning_lbs("mesh_1");
+			for (int kv = 0; kv < position_lbs.size(); ++kv) {
+				assert_cgp(norm(position_lbs[kv] - rigged.mesh_deformed.position[kv]) < 1e-4f, "Dual quaternion skinning position of the vertex " + str(kv));
+				assert_cgp(norm(normal_lbs[kv] - rigged.mesh_deformed.normal[kv]) < 1e-4f, "Dual quaternion skinning normal of the vertex " + str(kv));
+			}
+			model.rigged_mesh.erase("mesh_1");
+		}
+
+		// Candy-wrapper: a vertex between two joints twisted by 170 degrees around the bone collapses onto the bone with the linear blend,
+		//  and keeps its distance to the bone with dual quaternions
+		{
+			animated_model_structure twist;
+			twist.skeleton.joint_matrix_global.push_back(mat4::build_identity());
+			twist.skeleton.joint_matrix_global.push_back(mat4::build_rotation_from_axis_angle({ 1,0,0 }, 170.0f * 3.14159265f / 180.0f));
+			rigged_mesh_structure& rigged = twist.rigged_mesh["arm"];
+			rigged.mesh_bind_pose.position = { {0.5f,1.0f,0.0f} };
+			rigged.mesh_bind_pose.normal = { {0.0f,1.0f,0.0f} };
+			rigged.mesh_deformed = rigged.mesh_bind_pose;
+			rigged.controller_skinning.vertex_to_joint_dependence = { { {0,0.5f}, {1,0.5f} } };
+			rigged.controller_skinning.inverse_bind_matrices = { mat4::build_identity(), mat4::build_identity() };
+			rigged.controller_skinning.rig_index_to_skeleton_index = { 0, 1 };
+			rigged.skinning_packed.initialize(rigged.controller_skinning, rigged.mesh_bind_pose);
+
+			twist.skinning_lbs("arm");
+			vec3 const p_lbs = rigged.mesh_deformed.position[0];
+			rigged.method = skinning_method::dual_quaternion;
+			twist.skinning_lbs("arm");
+			vec3 const p_dqs = rigged.mesh_deformed.position[0];
+
+			assert_cgp_no_msg(std::abs(p_lbs.x - 0.5f) < 1e-5f && norm(vec2{ p_lbs.y, p_lbs.z }) < 0.1f);
+			assert_cgp_no_msg(std::abs(p_dqs.x - 0.5f) < 1e-5f && std::abs(norm(vec2{ p_dqs.y, p_dqs.z }) - 1.0f) < 1e-5f);
+			assert_cgp_no_msg(std::abs(norm(rigged.mesh_deformed.normal[0]) - 1.0f) < 1e-5f);
+		}
+
+		// Compressed skinning: 8 bits weights summing to 255, octahedral normals, same deformation as the float format up to the quantization
+		{
+			for (int k = 0; k < 100; ++k) {
+				float w[5];
+				float sum = 0.0f;
+				for (int i = 0; i < 5; ++i) { w[i] = 1.0f + (k * 13 + i * 7) % 17 * (i == 4 ? 0.01f : 1.0f); sum += w[i]; }
+				for (int i = 0; i < 5; ++i) w[i] /= sum;
+				uint8_t q[5];
+				skinning_quantize_weight(w, q, 5);
+				int sum_quantized = 0;
+				for (int i = 0; i < 5; ++i) {
+					sum_quantized += q[i];
+					assert_cgp_no_msg(std::abs(q[i] - 255.0f * w[i]) < 1.0f);
+				}
+				assert_cgp(sum_quantized == 255, "Quantized weights sum to " + str(sum_quantized));
+			}
+
+			for (int k = 0; k < 1000; ++k) {
+				vec3 const n = k < 6 ? vec3{ float(k % 3 == 0), float(k % 3 == 1), float(k % 3 == 2) } * (k < 3 ? 1.0f : -1.0f)
+					: normalize(vec3{ std::sin(0.37f * k), std::cos(1.7f * k), std::sin(2.9f * k + 1.0f) });
+				int16_t u, v;
+				octahedral_encode(n, u, v);
+				assert_cgp(norm(octahedral_decode(u, v) - n) < 1e-4f, "Octahedral normal " + str(n));
+			}
+
+			for (auto& entry : model.rigged_mesh) {
+				for (skinning_method method : { skinning_method::linear_blend, skinning_method::dual_quaternion }) {
+					rigged_mesh_structure rigged = entry.second;
+					rigged.method = method;
+					rigged.skinning_update_transformation(model.skeleton);
+					rigged.skinning_lbs_blocks(0, rigged.skinning_packed.N_block());
+					numarray<vec3> const position_float = rigged.mesh_deformed.position;
+					numarray<vec3> const normal_float = rigged.mesh_deformed.normal;
+
+					rigged.skinning_packed.initialize(rigged.controller_skinning, rigged.mesh_bind_pose, true);
+					assert_cgp_no_msg(rigged.skinning_packed.compressed && rigged.skinning_packed.weight.size() == 0);
+					rigged.skinning_lbs_blocks(0, rigged.skinning_packed.N_block());
+					for (int kv = 0; kv < position_float.size(); ++kv) {
+						assert_cgp(norm(position_float[kv] - rigged.mesh_deformed.position[kv]) < 0.05f, "Compressed skinning position of the vertex " + str(kv) + " of " + entry.first);
+						assert_cgp(norm(normal_float[kv] - rigged.mesh_deformed.normal[kv]) < 0.05f, "Compressed skinning normal of the vertex " + str(kv) + " of " + entry.first);
+					}
+
+					// Exact decoding: same deformation as the float format initialized with the decoded weights and normals
+					rigged_mesh_structure decoded = rigged;
+					for (int kv = 0; kv < position_float.size(); ++kv) {
+						int const offset = (kv / skinning_block_size) * rigged.skinning_packed.N_influence * skinning_block_size + kv % skinning_block_size;
+						for (skinning_weight_info& d : decoded.controller_skinning.vertex_to_joint_dependence[kv]) {
+							d.weight = 0.0f;
+							for (int k = 0; k < rigged.skinning_packed.N_influence; ++k)
+								if (rigged.skinning_packed.joint_quantized[offset + k * skinning_block_size] == d.joint_index)
+									d.weight += rigged.skinning_packed.weight_quantized[offset + k * skinning_block_size] / 255.0f;
+						}
+						int const offset_normal = (kv / skinning_block_size) * 2 * skinning_block_size + kv % skinning_block_size;
+						decoded.mesh_bind_pose.normal[kv] = octahedral_decode(rigged.skinning_packed.normal_octahedral[offset_normal], rigged.skinning_packed.normal_octahedral[offset_normal + skinning_block_size]);
+					}
+					decoded.skinning_packed.initialize(decoded.controller_skinning, decoded.mesh_bind_pose);
+					decoded.skinning_lbs_blocks(0, decoded.skinning_packed.N_block());
+					for (int kv = 0; kv < position_float.size(); ++kv) {
+						assert_cgp(norm(decoded.mesh_deformed.position[kv] - rigged.mesh_deformed.position[kv]) < 1e-5f, "Compressed skinning position of the vertex " + str(kv) + " of " + entry.first);
+						assert_cgp(norm(decoded.mesh_deformed.normal[kv] - rigged.mesh_deformed.normal[kv]) < 1e-5f, "Compressed skinning normal of the vertex " + str(kv) + " of " + entry.first);
+					}
+				}
+			}
+
+			// compress_skinning releases the source data of the packed format
+			animated_model_structure compressed = model;
+			size_t const memory_size = compressed.memory_size_rigged_mesh();
+			compressed.compress_skinning();
+			assert_cgp_no_msg(compressed.memory_size_rigged_mesh() < memory_size / 2);
+			for (auto& entry : compressed.rigged_mesh) {
+				assert_cgp_no_msg(entry.second.skinning_packed.compressed && entry.second.mesh_bind_pose.position.size() == 0);
+				compressed.skinning_lbs(entry.first);
+			}
+		}
+
+		// More than 8 influences: the strongest 8 are kept and renormalized
+		{
+			rigged_mesh_structure rigged = test_skinning_rigged_mesh(3, 12, 1);
+			rigged.controller_skinning.vertex_to_joint_dependence[1].clear();
+			for (int k = 0; k < 10; ++k)
+				rigged.controller_skinning.vertex_to_joint_dependence[1].push_back({ k, k < 2 ? 0.01f : 0.12f });
+			rigged.skinning_packed.initialize(rigged.controller_skinning, rigged.mesh_bind_pose);
+
+			skinning_packed_structure const& packed = rigged.skinning_packed;
+			assert_cgp_no_msg(packed.N_influence == 8 && packed.N_truncated == 1);
+			float weight_sum = 0.0f;
+			for (int k = 0; k < 8; ++k) {
+				int const offset = k * skinning_block_size + 1;
+				assert_cgp_no_msg(packed.joint[offset] >= 2);
+				weight_sum += packed.weight[offset];
+			}
+			assert_cgp_no_msg(std::abs(weight_sum - 1.0f) < 1e-6f);
+		}
+	}
+}
@@ -0,0 +1,214 @@
+#include "cape_rig.hpp"
+#include "../animated_character/asset_loader/asset_loader.hpp"
+
+using namespace cgp;
+
+
+/*
+ * Joint indices of the mixamo skeletons
+ *  0: Hips, 1: Spine, 2: LeftUpLeg, 3: RightUpLeg, 4: Spine1, 5: LeftLeg, 6: RightLeg, 7: Spine2, 8: LeftFoot, 9: RightFoot,
+ *  10: Neck, 11: LeftShoulder, 12: RightShoulder, 13: LeftToeBase, 14: RightToeBase, 15: Head, 16: LeftArm, 17: RightArm,
+ *  18: LeftToe_End, 19: RightToe_End, 20: HeadTop_End, 21: LeftEye, 22: RightEye, 23: LeftForeArm, 24: RightForeArm,
+ *  25: LeftHand, 26: RightHand
+ */
+
+void cape_rig_update_pins(constraint_structure& constraint, numarray<mat4> const& joint_frames, int N_cloth)
+{
+    constraint.fixed_sample.clear();
+
+    const vec3& p_al = joint_frames[16].get_block_translation();
+    const vec3& p_sl = joint_frames[11].get_block_translation();
+    const vec3& p_l = 0.5f * (p_sl - p_al) + p_al;
+
+    const vec3& p_ar = joint_frames[17].get_block_translation();
+    const vec3& p_sr = joint_frames[12].get_block_translation();
+    const vec3& p_r = 0.5f * (p_sr - p_ar) + p_ar;
+
+    constraint.add_fixed_position(0, 0, p_al);
+    constraint.add_fixed_position(0, (int) (N_cloth/4), p_l);
+
+    constraint.add_fixed_position(0, N_cloth - 1, p_ar);
+    constraint.add_fixed_position(0, N_cloth - 1 - (int) (N_cloth/4), p_r);
+}
+
+void cape_rig_update_colliders(constraint_structure& constraint, numarray<mat4> const& joint_frames)
+{
+    static numarray<int> const joint_spheres = {
+        0, // Hips
+        23, // Left elbow
+        24, // Right elbow
+        2, // Left hip
+        3, // Right hip
+        5, // Left knee
+        6 // Right knee
+    };
+
+    static numarray<float> const joint_radiuses = {
+        0.20f, // Hips
+        0.08f, // Left elbow
+        0.08f, // Right elbow
+        0.15f, // Left hip
+        0.15f, //Right hip
+        0.12f, // Left knee
+        0.12f // Right knee
+    };
+
+    for (int i = 0; i < joint_spheres.size(); i++) {
+        vec3 joint_position = joint_frames[joint_spheres[i]].get_block_translation();
+        float radius = joint_radiuses[i];
+
+        if (i >= constraint.spherical_constraints.size()) {
+            constraint.spherical_constraints.push_back({joint_position, radius});
+            continue;
+        }
+
+        constraint.spherical_constraints[i] = {joint_position, radius};
+    }
+
+
+    static numarray<int2> const cylinder_connections = {
+        {11, 23}, // Left arm upper
+        {12, 24}, // Right arm upper
+        {2, 5}, // Left leg upper
+        {3, 6}, // Right leg upper
+        {5, 8}, // Left leg lower
+        {6, 9}, // Right leg lower
+        {23, 25}, // Left arm lower
+        {24, 26}, // Right arm lower
+        {0, 7} // Body
+    };
+    static numarray<float> const cylinder_radiuses = {
+        0.06f, // Left arm upper
+        0.06f, // Right arm upper
+        0.12f, // Left leg upper
+        0.12f, // Right leg upper
+        0.10f, // Left leg lower
+        0.10f, // Right leg lower
+        0.06f, // Left arm lower
+        0.06f, // Right arm lower
+        0.11f // Body
+    };
+
+    for (int i = 0; i < cylinder_connections.size(); i++) {
+        vec3 start = joint_frames[cylinder_connections[i].x].get_block_translation();
+        vec3 end = joint_frames[cylinder_connections[i].y].get_block_translation();
+        float radius = cylinder_radiuses[i];
+
+        if (i >= constraint.cylindrical_constraints.size()) {
+            constraint.cylindrical_constraints.push_back({start, end, radius});
+            continue;
+        }
+
+        constraint.cylindrical_constraints[i] = {start, end, radius};
+    }
+}
+
+void cape_rig_body_frame(numarray<mat4> const& joint_frames, vec3& origin, vec3& e_x, vec3& e_y, vec3& e_z)
+{
+    vec3 const p_hips = joint_frames[0].get_block_translation();
+    vec3 const p_neck = joint_frames[10].get_block_translation();
+    vec3 const p_sl = joint_frames[11].get_block_translation();
+    vec3 const p_sr = joint_frames[12].get_block_translation();
+
+    origin = 0.5f * (p_sl + p_sr);
+    e_x = normalize(p_sr - p_sl);
+    vec3 const up = p_neck - p_hips;
+    e_y = normalize(up - dot(up, e_x) * e_x);
+    e_z = cross(e_x, e_y);
+}
+
+void cape_rig_drape(cloth_structure& cloth, constraint_structure const& constraint)
+{
+    int const N = cloth.N_samples();
+    float const L0 = 1.0f / (N - 1.0f);
+
+    // Pins of the top side ordered along kv
+    std::map<int, vec3> top;
+    for (auto const& it : constraint.fixed_sample)
+        if (it.second.ku == 0)
+            top[it.second.kv] = it.second.position;
+    if (top.empty())
+        return;
+
+    for (int kv = 0; kv < N; ++kv) {
+        // Linear interpolation between the two pins around kv (the closest pin beyond the first/last one)
+        auto next = top.lower_bound(kv);
+        vec3 p_top;
+        if (next == top.end())
+            p_top = top.rbegin()->second;
+        else if (next == top.begin() || next->first == kv)
+            p_top = next->second;
+        else {
+            auto const previous = std::prev(next);
+            float const alpha = (kv - previous->first) / static_cast<float>(next->first - previous->first);
+            p_top = (1 - alpha) * previous->second + alpha * next->second;
+        }
+
+        for (int ku = 0; ku < N; ++ku) {
+            cloth.position(ku, kv) = p_top - vec3{ 0, ku * L0, 0 };
+            cloth.velocity(ku, kv) = { 0,0,0 };
+        }
+    }
+}
+
+
+float cape_rig_clip::duration() const
+{
+    return frames.size() / frame_rate;
+}
+
+void cape_rig_clip::evaluate(float t, numarray<mat4>& joint_frames) const
+{
+    assert_cgp(frames.size() > 0, "The clip " + name + " has no frame");
+
+    int const N_frame = static_cast<int>(frames.size());
+    float const s = t * frame_rate;
+    float const s_floor = std::floor(s);
+    float const alpha = s - s_floor;
+    int const k = static_cast<int>(s_floor);
+    int const cycle = k >= 0 ? k / N_frame : -((-k + N_frame - 1) / N_frame);
+    int const k0 = k - cycle * N_frame;
+    int const k1 = (k0 + 1) % N_frame;
+
+    // Translations of the two samples, the second one may belong to the next cycle
+    vec3 const translation_0 = static_cast<float>(cycle) * cycle_translation;
+    vec3 const translation_1 = k1 == 0 ? translation_0 + cycle_translation : translation_0;
+
+    numarray<mat4> const& f0 = frames[k0];
+    numarray<mat4> const& f1 = frames[k1];
+    joint_frames.resize(f0.size());
+    for (int kj = 0; kj < f0.size(); ++kj) {
+        // The pins and colliders only use the translation of the frames
+        joint_frames[kj] = (1 - alpha) * f0[kj] + alpha * f1[kj];
+        joint_frames[kj].set_block_translation(joint_frames[kj].get_block_translation() + (1 - alpha) * translation_0 + alpha * translation_1);
+    }
+}
+
+cape_rig_clip cape_rig_load_clip(std::string const& character_path, std::string const& animation_name, float frame_rate)
+{
+    filename_loader_structure loader_param;
+    loader_param.set_skeleton(character_path + "skeleton/");
+    loader_param.add_animation(animation_name, character_path + "animation/" + animation_name + "/");
+
+    // Same scaling as the characters of the scene (see character_loader)
+    animated_model_structure animated_model = mesh_skinning_loader(loader_param, affine_rts().set_scaling(0.01f));
+
+    // Samples evenly spaced over one cycle (the frame rate is adjusted to fit an integer number of samples in the cycle)
+    float const time_max = animated_model.animation[animation_name].time_max;
+    int const N_frame = std::max(static_cast<int>(std::round(time_max * frame_rate)), 1);
+
+    cape_rig_clip clip;
+    clip.name = animation_name;
+    clip.frame_rate = time_max > 0 ? N_frame / time_max : frame_rate;
+    for (int k = 0; k < N_frame; ++k) {
+        animated_model.set_skeleton_from_animation(animation_name, k / clip.frame_rate);
+        clip.frames.push_back(animated_model.skeleton.joint_matrix_global);
+    }
+
+    // Root motion: horizontal displacement of the hips between the start and the end of the cycle
+    animated_model.set_skeleton_from_animation(animation_name, time_max);
+    vec3 const translation = animated_model.skeleton.joint_matrix_global[0].get_block_translation() - clip.frames[0][0].get_block_translation();
+    clip.cycle_translation = { translation.x, 0.0f, translation.z };
+
+    return clip;
+}
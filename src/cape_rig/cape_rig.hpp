@@ -0,0 +1,41 @@
+#pragma once
+
+#include "cgp/cgp.hpp"
+#include "../constraint/constraint.hpp"
+
+
+// Attachment of the cape and colliders approximating the body of a character
+//  The joint indices are the ones of the mixamo skeletons of the characters in assets/ (ex. 0: Hips, 11/12: Left/RightShoulder, 16/17: Left/RightArm).
+//  Shared by the interactive scene and the headless tools (parameter sweep, bake).
+
+// Pin the cape of N_cloth x N_cloth vertices to the shoulders and arms given by the global joint frames (previous pins are removed)
+void cape_rig_update_pins(constraint_structure& constraint, cgp::numarray<cgp::mat4> const& joint_frames, int N_cloth);
+
+// Update the colliders following the body: spheres on the hips, elbows and legs, cylinders along the limbs and the spine
+void cape_rig_update_colliders(constraint_structure& constraint, cgp::numarray<cgp::mat4> const& joint_frames);
+
+// Orthonormal frame following the upper body, from the positions of the hips, neck and shoulders
+//  origin: middle of the shoulders, e_x: from the left to the right shoulder, e_y: from the hips to the neck (orthogonalized), e_z = e_x x e_y
+void cape_rig_body_frame(cgp::numarray<cgp::mat4> const& joint_frames, cgp::vec3& origin, cgp::vec3& e_x, cgp::vec3& e_y, cgp::vec3& e_z);
+
+// Place the cloth hanging vertically below its pins of the side ku=0, and reset its velocity (initial state of the headless runs)
+void cape_rig_drape(cloth_structure& cloth, constraint_structure const& constraint);
+
+
+// Global joint frames of an animation clip sampled at a fixed rate, without the meshes of the character
+//  Used by the headless tools: the skeleton is evaluated once, and the clip can be read by several threads at the same time.
+struct cape_rig_clip
+{
+    std::string name;
+    float frame_rate = 60.0f;
+    std::vector<cgp::numarray<cgp::mat4>> frames;
+    cgp::vec3 cycle_translation = { 0,0,0 }; // horizontal displacement of the character over one cycle (root motion of a walk)
+
+    float duration() const;
+    // Joint frames at time t: linear interpolation between the samples
+    //  The clip is repeated periodically, and the root motion accumulated over the cycles (the character keeps walking forward).
+    void evaluate(float t, cgp::numarray<cgp::mat4>& joint_frames) const;
+};
+
+// Load the skeleton of a character (ex. assets/lola/) and sample one of its animations (ex. "walk" in assets/lola/animation/walk/)
+cape_rig_clip cape_rig_load_clip(std::string const& character_path, std::string const& animation_name, float frame_rate = 60.0f);
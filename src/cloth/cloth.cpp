@@ -3,6 +3,29 @@
 using namespace cgp;
 
 
+// Fill the list of triangles around each vertex (compressed storage: offset per vertex + concatenated lists)
+static void build_vertex_triangle(cloth_structure& cloth)
+{
+    int const N_vertex = cloth.position.size();
+    int const N_triangle = cloth.triangle_connectivity.size();
+
+    cloth.vertex_triangle_offset.resize_clear(N_vertex + 1);
+    for (int k_tri = 0; k_tri < N_triangle; ++k_tri)
+        for (unsigned int idx : cloth.triangle_connectivity[k_tri])
+            cloth.vertex_triangle_offset[idx + 1]++;
+    for (int k = 0; k < N_vertex; ++k)
+        cloth.vertex_triangle_offset[k + 1] += cloth.vertex_triangle_offset[k];
+
+    numarray<int> fill = cloth.vertex_triangle_offset;
+    cloth.vertex_triangle.resize(N_triangle * 3);
+    for (int k_tri = 0; k_tri < N_triangle; ++k_tri)
+        for (unsigned int idx : cloth.triangle_connectivity[k_tri])
+            cloth.vertex_triangle[fill[idx]++] = k_tri;
+
+    cloth.triangle_normal.resize(N_triangle);
+    cloth.triangle_aerodynamic_force.resize_clear(N_triangle);
+}
+
 void cloth_structure::initialize(int N_samples_edge_arg)
 {
     assert_cgp(N_samples_edge_arg > 3, "N_samples_edge=" + str(N_samples_edge_arg) + " should be > 3");
@@ -23,6 +46,58 @@ void cloth_structure::initialize(int N_samples_edge_arg)
     position = grid_2D<vec3>::from_buffer(cloth_mesh.position, N_samples_edge_arg, N_samples_edge_arg);
     normal = grid_2D<vec3>::from_buffer(cloth_mesh.normal, N_samples_edge_arg, N_samples_edge_arg);
     triangle_connectivity = cloth_mesh.connectivity;
+
+    aerodynamic_force.resize(N_samples_edge_arg, N_samples_edge_arg);
+    aerodynamic_force.fill({ 0,0,0 });
+    aerodynamic_force_valid = false;
+    build_vertex_triangle(*this);
+}
+
+// Bilinear resampling of a squared grid on a new squared grid of dimension (N,N)
+//  The corners of the grid are preserved exactly
+static grid_2D<vec3> resample_bilinear(grid_2D<vec3> const& value, int N)
+{
+    int const N_previous = value.dimension.x;
+    float const scale = (N_previous - 1.0f) / (N - 1.0f);
+
+    grid_2D<vec3> result(N, N);
+    for (int kv = 0; kv < N; ++kv) {
+        float const y = kv * scale;
+        int const y0 = std::min(int(y), N_previous - 2);
+        float const dy = y - y0;
+        for (int ku = 0; ku < N; ++ku) {
+            float const x = ku * scale;
+            int const x0 = std::min(int(x), N_previous - 2);
+            float const dx = x - x0;
+
+            vec3 const v0 = interpolation_linear(dx, value(x0, y0), value(x0 + 1, y0));
+            vec3 const v1 = interpolation_linear(dx, value(x0, y0 + 1), value(x0 + 1, y0 + 1));
+            result(ku, kv) = interpolation_linear(dy, v0, v1);
+        }
+    }
+    return result;
+}
+
+void cloth_structure::resample(int N_samples_edge_arg)
+{
+    assert_cgp(N_samples_edge_arg > 3, "N_samples_edge=" + str(N_samples_edge_arg) + " should be > 3");
+    if (N_samples_edge_arg == N_samples())
+        return;
+
+    position = resample_bilinear(position, N_samples_edge_arg);
+    velocity = resample_bilinear(velocity, N_samples_edge_arg);
+
+    force.resize(N_samples_edge_arg, N_samples_edge_arg);
+    force.fill({ 0,0,0 });
+    normal.resize(N_samples_edge_arg, N_samples_edge_arg);
+
+    mesh const cloth_mesh = mesh_primitive_grid({ 0,0,0 }, { 1,0,0 }, { 1,1,0 }, { 0,1,0 }, N_samples_edge_arg, N_samples_edge_arg);
+    triangle_connectivity = cloth_mesh.connectivity;
+    aerodynamic_force.resize(N_samples_edge_arg, N_samples_edge_arg);
+    aerodynamic_force.fill({ 0,0,0 });
+    aerodynamic_force_valid = false;
+    build_vertex_triangle(*this);
+    update_normal();
 }
 
 void cloth_structure::update_normal()
@@ -30,16 +105,181 @@ void cloth_structure::update_normal()
     normal_per_vertex(position.data, triangle_connectivity, normal.data);
 }
 
+void normal_grid_block(cloth_block_view const& block, int ku_min, int ku_max, int kv_min, int kv_max)
+{
+    int const N = block.N;
+    vec3 const* position = block.position;
+    for (int kv = kv_min; kv < kv_max; ++kv) {
+        // Offsets of the previous/next rows (one-sided differences on the borders)
+        int const row_prev = block.index(0, std::max(kv - 1, 0));
+        int const row_next = block.index(0, std::min(kv + 1, N - 1));
+        int const row = block.index(0, kv);
+        for (int ku = ku_min; ku < ku_max; ++ku) {
+            int const ku_prev = std::max(ku - 1, 0);
+            int const ku_next = std::min(ku + 1, N - 1);
+
+            // Tangents along the two grid directions
+            vec3 const du = position[row + ku_next] - position[row + ku_prev];
+            vec3 const dv = position[row_next + ku] - position[row_prev + ku];
+
+            vec3 const n = cross(dv, du);
+            float const L = norm(n);
+            block.normal[row + ku] = L > 1e-12f ? n / L : vec3{ 0,0,0 };
+        }
+    }
+}
+
+void normal_grid_rows(vec3 const* position, vec3* normal, int N, int kv_min, int kv_max)
+{
+    cloth_block_view const block = { const_cast<vec3*>(position), nullptr, nullptr, normal, nullptr, N, 0, 0, N };
+    normal_grid_block(block, 0, N, kv_min, kv_max);
+}
+
+void cloth_structure::update_normal_grid()
+{
+    int const N = N_samples();
+    vec3 const* p = position.data.data.data();
+    vec3* n = normal.data.data.data();
+
+#pragma omp parallel for
+    for (int kv = 0; kv < N; ++kv)
+        normal_grid_rows(p, n, N, kv, kv + 1);
+}
+
 int cloth_structure::N_samples() const
 {
     return position.dimension.x;
 }
 
+int cloth_block_view::index(int ku, int kv) const
+{
+    return (ku - ku_origin) + stride * (kv - kv_origin);
+}
+
+cloth_block_view block_view(cloth_grid_view const& grid)
+{
+    return { grid.position, grid.velocity, grid.force, grid.normal, grid.aerodynamic_force, grid.N, 0, 0, grid.N };
+}
+
+cloth_grid_view cloth_structure::grid_view()
+{
+    return { position.data.data.data(), velocity.data.data.data(), force.data.data.data(), normal.data.data.data(), aerodynamic_force.data.data.data(), N_samples() };
+}
+
+
+void cloth_refinement_structure::initialize(int N_arg, int factor_arg)
+{
+    assert_cgp(N_arg >= 4 && factor_arg >= 1, "The refinement needs a grid of at least 4x4 vertices");
+    N = N_arg;
+    factor = factor_arg;
+    int const M = N_refined();
+
+    first.resize(M);
+    weight.resize_clear(4 * M);
+    weight_derivative.resize_clear(4 * M);
+    for (int i = 0; i < M; ++i) {
+        // Cell of the simulated grid containing the sample, and parameter in this cell
+        int const c = std::min(i / factor, N - 2);
+        float const t = (i - c * factor) / float(factor);
+        float const t2 = t * t;
+        float const t3 = t2 * t;
+
+        // Catmull-Rom weights of the samples c-1, c, c+1, c+2
+        float const w[4] = { 0.5f * (-t3 + 2 * t2 - t), 0.5f * (3 * t3 - 5 * t2 + 2), 0.5f * (-3 * t3 + 4 * t2 + t), 0.5f * (t3 - t2) };
+        float const dw[4] = { 0.5f * (-3 * t2 + 4 * t - 1), 0.5f * (9 * t2 - 10 * t), 0.5f * (-9 * t2 + 8 * t + 1), 0.5f * (3 * t2 - 2 * t) };
+
+        // The samples -1 and N beyond the borders are linear extrapolations (2 p_0 - p_1, 2 p_{N-1} - p_{N-2}): their weights are folded on the grid
+        int const s = std::min(std::max(c - 1, 0), N - 4);
+        first[i] = s;
+        for (int a = 0; a < 4; ++a) {
+            int const j = c - 1 + a;
+            int j_0 = j, j_1 = -1;
+            if (j < 0)      { j_0 = 0;     j_1 = 1; }
+            if (j > N - 1)  { j_0 = N - 1; j_1 = N - 2; }
+            float const f = (j_1 < 0) ? 1.0f : 2.0f;
+            weight[4 * i + j_0 - s] += f * w[a];
+            weight_derivative[4 * i + j_0 - s] += f * dw[a];
+            if (j_1 >= 0) {
+                weight[4 * i + j_1 - s] -= w[a];
+                weight_derivative[4 * i + j_1 - s] -= dw[a];
+            }
+        }
+    }
+
+    row_position.resize(N * M);
+    row_tangent.resize(N * M);
+}
+
+int cloth_refinement_structure::N_refined() const
+{
+    return (N - 1) * factor + 1;
+}
+
+void cloth_refinement_structure::evaluate(grid_2D<vec3> const& position, grid_2D<vec3>& position_refined, grid_2D<vec3>& normal_refined)
+{
+    assert_cgp_no_msg(position.dimension.x == N && position.dimension.y == N);
+    int const M = N_refined();
+    position_refined.resize(M, M);
+    normal_refined.resize(M, M);
+
+    vec3 const* p = position.data.data.data();
+    vec3* row_p = row_position.data.data();
+    vec3* row_t = row_tangent.data.data();
+    int const* first_sample = first.data.data();
+    float const* w = weight.data.data();
+    float const* dw = weight_derivative.data.data();
 
+    // Along ku, on each simulated row
+#pragma omp parallel for
+    for (int kv = 0; kv < N; ++kv) {
+        vec3 const* row = p + N * kv;
+        for (int i = 0; i < M; ++i) {
+            vec3 const* q = row + first_sample[i];
+            float const* w_i = w + 4 * i;
+            float const* dw_i = dw + 4 * i;
+            row_p[M * kv + i] = w_i[0] * q[0] + w_i[1] * q[1] + w_i[2] * q[2] + w_i[3] * q[3];
+            row_t[M * kv + i] = dw_i[0] * q[0] + dw_i[1] * q[1] + dw_i[2] * q[2] + dw_i[3] * q[3];
+        }
+    }
 
-void cloth_structure_drawable::initialize(int N_samples_edge)
+    // Along kv, on each refined row: position, tangents along ku and kv, and normal oriented as normal_grid_rows
+    vec3* p_refined = position_refined.data.data.data();
+    vec3* n_refined = normal_refined.data.data.data();
+#pragma omp parallel for
+    for (int j = 0; j < M; ++j) {
+        int const s = first_sample[j];
+        float const* w_j = w + 4 * j;
+        float const* dw_j = dw + 4 * j;
+        vec3 const* p0 = row_p + M * s;
+        vec3 const* t0 = row_t + M * s;
+        for (int i = 0; i < M; ++i) {
+            vec3 const& a = p0[i];
+            vec3 const& b = p0[i + M];
+            vec3 const& c = p0[i + 2 * M];
+            vec3 const& d = p0[i + 3 * M];
+            p_refined[M * j + i] = w_j[0] * a + w_j[1] * b + w_j[2] * c + w_j[3] * d;
+
+            vec3 const du = w_j[0] * t0[i] + w_j[1] * t0[i + M] + w_j[2] * t0[i + 2 * M] + w_j[3] * t0[i + 3 * M];
+            vec3 const dv = dw_j[0] * a + dw_j[1] * b + dw_j[2] * c + dw_j[3] * d;
+            vec3 const n = cross(dv, du);
+            float const L = norm(n);
+            n_refined[M * j + i] = L > 1e-12f ? n / L : vec3{ 0,0,0 };
+        }
+    }
+}
+
+
+void cloth_structure_drawable::initialize(int N_samples_edge, int refinement_factor)
 {
-    mesh const cloth_mesh = mesh_primitive_grid({ 0.5,0,0 }, {1,0,0 }, { 1,1,0 }, { 0,1,0 }, N_samples_edge, N_samples_edge);
+    // The refined mesh has (N-1) factor + 1 vertices per edge
+    int N_drawn = N_samples_edge;
+    refinement = cloth_refinement_structure();
+    if (refinement_factor > 1 && N_samples_edge >= 4) {
+        refinement.initialize(N_samples_edge, refinement_factor);
+        N_drawn = refinement.N_refined();
+    }
+
+    mesh const cloth_mesh = mesh_primitive_grid({ 0.5,0,0 }, {1,0,0 }, { 1,1,0 }, { 0,1,0 }, N_drawn, N_drawn);
 
     drawable.clear();
     drawable.initialize_data_on_gpu(cloth_mesh);
@@ -50,8 +290,19 @@ void cloth_structure_drawable::initialize(int N_samples_edge)
 
 void cloth_structure_drawable::update(cloth_structure const& cloth)
 {    
-    drawable.vbo_position.update(cloth.position.data);
-    drawable.vbo_normal.update(cloth.normal.data);
+    update(cloth.position, cloth.normal);
+}
+
+void cloth_structure_drawable::update(grid_2D<vec3> const& position, grid_2D<vec3> const& normal)
+{
+    if (refinement.factor > 1) {
+        refinement.evaluate(position, position_refined, normal_refined);
+        drawable.vbo_position.update(position_refined.data);
+        drawable.vbo_normal.update(normal_refined.data);
+        return;
+    }
+    drawable.vbo_position.update(position.data);
+    drawable.vbo_normal.update(normal.data);
 }
 
 void draw(cloth_structure_drawable const& cloth_drawable, environment_generic_structure const& environment)
@@ -4,6 +4,37 @@
 #include "cgp/cgp.hpp"
 #include "../environment.hpp"
 
+// Non-owning access to the buffers of a square grid of N x N vertices (stored as grid(ku,kv) = buffer[ku + N*kv])
+//  The simulation kernels run on this view: either on a cloth_structure, or on one cloth of a larger arena (cloth_batch_structure).
+struct cloth_grid_view
+{
+    cgp::vec3* position;
+    cgp::vec3* velocity;
+    cgp::vec3* force;
+    cgp::vec3* normal;
+    cgp::vec3 const* aerodynamic_force; // nullptr when no aerodynamic force is available
+    int N;
+};
+
+// Non-owning access to a rectangular block of a larger N x N grid, stored with its own row stride (see cloth_distributed_block)
+//  The vertex (ku,kv) of the whole grid is stored at index (ku-ku_origin) + stride*(kv-kv_origin) of the buffers.
+//  A cloth_grid_view is the block covering the whole grid (origin 0, stride N).
+struct cloth_block_view
+{
+    cgp::vec3* position;
+    cgp::vec3* velocity;
+    cgp::vec3* force;
+    cgp::vec3* normal;
+    cgp::vec3 const* aerodynamic_force; // nullptr when no aerodynamic force is available
+    int N;         // vertices per edge of the whole grid
+    int ku_origin; // first vertex of the block stored in the buffers
+    int kv_origin;
+    int stride;
+
+    int index(int ku, int kv) const; // index in the buffers of the vertex (ku,kv) of the whole grid
+};
+cloth_block_view block_view(cloth_grid_view const& grid);
+
 // Stores the buffers representing the cloth vertices
 struct cloth_structure
 {    
@@ -16,10 +47,54 @@ struct cloth_structure
     // Also stores the triangle connectivity used to update the normals
     cgp::numarray<cgp::uint3> triangle_connectivity;
 
+    // Triangles around each vertex, used to gather per-triangle quantities on the vertices without concurrent writes
+    //  The triangles around the vertex k are vertex_triangle[vertex_triangle_offset[k] .. vertex_triangle_offset[k+1]-1] (in increasing order)
+    cgp::numarray<int> vertex_triangle_offset;
+    cgp::numarray<int> vertex_triangle;
+
+    // Per-triangle unit normal and aerodynamic force, and the aerodynamic force gathered on each vertex (see simulation_update_normal)
+    cgp::numarray<cgp::vec3> triangle_normal;
+    cgp::numarray<cgp::vec3> triangle_aerodynamic_force;
+    cgp::grid_2D<cgp::vec3> aerodynamic_force;
+    bool aerodynamic_force_valid = false; // aerodynamic_force was computed on the current state (by the last simulation_update_normal)
+
     
     void initialize(int N_samples_edge);  // Initialize a square flat cloth
-    void update_normal();       // Call this function every time the cloth is updated before its draw
+    void resample(int N_samples_edge);    // Change the resolution of the cloth, its position and velocity are bilinearly resampled
+    void update_normal();       // Call this function every time the cloth is updated before its draw (generic per-triangle normals)
+    void update_normal_grid();  // Faster equivalent for the regular grid: normals from central differences of the neighbor positions (parallel, gather only)
     int N_samples() const;      // Number of vertex along one dimension of the grid
+    cloth_grid_view grid_view(); // View on the buffers of the cloth
+};
+
+// Normals of the rows [kv_min,kv_max[ of a grid of N x N positions from central differences (see cloth_structure::update_normal_grid)
+void normal_grid_rows(cgp::vec3 const* position, cgp::vec3* normal, int N, int kv_min, int kv_max);
+// Same normals on the vertices [ku_min,ku_max[ x [kv_min,kv_max[ of a block (the block must store their neighbors)
+void normal_grid_block(cloth_block_view const& block, int ku_min, int ku_max, int kv_min, int kv_max);
+
+
+// Smooth render mesh of a simulated grid of N x N vertices (N >= 4)
+//  Each cell of the grid is split in factor x factor cells of the bicubic Catmull-Rom surface interpolating the simulated vertices
+//  (the pinned vertices stay in place, the surface is extended linearly beyond the borders). The normals are the analytic normals of the surface.
+//  The surface is evaluated separably: along ku on the N simulated rows, then along kv on each refined row (both passes in parallel).
+struct cloth_refinement_structure
+{
+    int N = 0;      // simulated vertices per edge
+    int factor = 1; // refined cells per simulated cell along each direction
+
+    // For each refined sample along one direction: first of the 4 simulated samples it depends on,
+    //  and their 4 weights for the value and for the derivative of the surface
+    cgp::numarray<int> first;
+    cgp::numarray<float> weight;
+    cgp::numarray<float> weight_derivative;
+
+    // Surface evaluated along ku only: N rows of N_refined() values, and their derivatives along ku
+    cgp::numarray<cgp::vec3> row_position;
+    cgp::numarray<cgp::vec3> row_tangent;
+
+    void initialize(int N, int factor);
+    int N_refined() const; // (N-1) factor + 1 refined vertices per edge
+    void evaluate(cgp::grid_2D<cgp::vec3> const& position, cgp::grid_2D<cgp::vec3>& position_refined, cgp::grid_2D<cgp::vec3>& normal_refined);
 };
 
 
@@ -29,8 +104,14 @@ struct cloth_structure_drawable
 {
     cgp::mesh_drawable drawable;
 
-    void initialize(int N_sample_edge);
+    // The drawn mesh can be finer than the simulated grid (refinement.factor > 1): the cape is simulated coarse and drawn smooth
+    cloth_refinement_structure refinement;
+    cgp::grid_2D<cgp::vec3> position_refined;
+    cgp::grid_2D<cgp::vec3> normal_refined;
+
+    void initialize(int N_sample_edge, int refinement_factor = 1); // N_sample_edge simulated vertices per edge (the refinement is ignored below 4)
     void update(cloth_structure const& cloth);
+    void update(cgp::grid_2D<cgp::vec3> const& position, cgp::grid_2D<cgp::vec3> const& normal); // Update from a state computed elsewhere (ex. simulation thread)
 };
 
 void draw(cloth_structure_drawable const& cloth_drawable, environment_generic_structure const& environment);
@@ -0,0 +1,56 @@
+#include "cgp/01_base/base.hpp"
+#include "../cloth.hpp"
+
+using namespace cgp;
+
+namespace cgp_test {
+
+	// The refined surface passes through the simulated vertices, reproduces a planar grid exactly (borders included) with its constant normal,
+	//  and its normals are oriented as the central-difference normals of the simulated grid
+	void test_cloth_refinement()
+	{
+		int const N = 7;
+		int const factor = 3;
+		cloth_refinement_structure refinement;
+		refinement.initialize(N, factor);
+		int const M = refinement.N_refined();
+		assert_cgp_no_msg(M == (N - 1) * factor + 1);
+
+		// Planar grid: p(u,v) = origin + u e_u + v e_v
+		vec3 const origin = { 0.2f, -0.1f, 0.3f };
+		vec3 const e_u = { 0.1f, 0.0f, 0.05f };
+		vec3 const e_v = { 0.0f, -0.15f, 0.02f };
+		grid_2D<vec3> position(N, N);
+		for (int kv = 0; kv < N; ++kv)
+			for (int ku = 0; ku < N; ++ku)
+				position(ku, kv) = origin + float(ku) * e_u + float(kv) * e_v;
+
+		grid_2D<vec3> position_refined, normal_refined;
+		refinement.evaluate(position, position_refined, normal_refined);
+		assert_cgp_no_msg(position_refined.dimension.x == M && normal_refined.dimension.y == M);
+		vec3 const n_plane = normalize(cross(e_v, e_u));
+		for (int j = 0; j < M; ++j) {
+			for (int i = 0; i < M; ++i) {
+				vec3 const expected = origin + (i / float(factor)) * e_u + (j / float(factor)) * e_v;
+				assert_cgp_no_msg(norm(position_refined(i, j) - expected) < 1e-5f);
+				assert_cgp_no_msg(norm(normal_refined(i, j) - n_plane) < 1e-4f);
+			}
+		}
+
+		// Curved grid
+		for (int kv = 0; kv < N; ++kv)
+			for (int ku = 0; ku < N; ++ku)
+				position(ku, kv) = { 0.1f * ku, -0.1f * kv, 0.05f * std::sin(0.9f * ku + 0.4f * kv) };
+		refinement.evaluate(position, position_refined, normal_refined);
+
+		grid_2D<vec3> normal(N, N);
+		normal_grid_rows(position.data.data.data(), normal.data.data.data(), N, 0, N);
+		for (int kv = 0; kv < N; ++kv) {
+			for (int ku = 0; ku < N; ++ku) {
+				assert_cgp_no_msg(norm(position_refined(factor * ku, factor * kv) - position(ku, kv)) < 1e-5f);
+				assert_cgp_no_msg(dot(normal_refined(factor * ku, factor * kv), normal(ku, kv)) > 0.9f);
+			}
+		}
+	}
+
+}
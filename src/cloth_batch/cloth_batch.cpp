@@ -0,0 +1,125 @@
+#include "cloth_batch.hpp"
+
+using namespace cgp;
+
+
+int cloth_batch_structure::add(cloth_structure const& cloth, simulation_parameters const& parameters_cloth)
+{
+    int const k_cloth = size();
+    int const N = cloth.N_samples();
+
+    vertex_offset.push_back(position.size());
+    N_samples.push_back(N);
+    parameters.push_back(parameters_cloth);
+    constraint.push_back(constraint_structure());
+
+    position.push_back(cloth.position.data);
+    velocity.push_back(cloth.velocity.data);
+    normal.push_back(cloth.normal.data);
+    force.resize(position.size());
+
+    for (int kv = 0; kv < N; ++kv)
+        rows.push_back({ k_cloth, kv });
+
+    return k_cloth;
+}
+
+void cloth_batch_structure::clear()
+{
+    position.clear();
+    velocity.clear();
+    force.clear();
+    normal.clear();
+    vertex_offset.clear();
+    N_samples.clear();
+    parameters.clear();
+    constraint.clear();
+    rows.clear();
+}
+
+void cloth_batch_structure::extract(int k_cloth, cloth_structure& cloth) const
+{
+    int const N = N_samples[k_cloth];
+    assert_cgp(cloth.N_samples() == N, "Cloth of resolution " + str(cloth.N_samples()) + " cannot receive the cloth " + str(k_cloth) + " of resolution " + str(N));
+
+    int const offset = vertex_offset[k_cloth];
+    for (int k = 0; k < N * N; ++k) {
+        cloth.position.data[k] = position[offset + k];
+        cloth.velocity.data[k] = velocity[offset + k];
+        cloth.force.data[k] = force[offset + k];
+        cloth.normal.data[k] = normal[offset + k];
+    }
+}
+
+cloth_grid_view cloth_batch_structure::grid_view(int k_cloth)
+{
+    int const offset = vertex_offset[k_cloth];
+    return { &position[offset], &velocity[offset], &force[offset], &normal[offset], nullptr, N_samples[k_cloth] };
+}
+
+int cloth_batch_structure::size() const
+{
+    return N_samples.size();
+}
+
+
+void cloth_batch_compute_force(cloth_batch_structure& batch)
+{
+    int const N_row = batch.rows.size();
+#pragma omp parallel for
+    for (int k = 0; k < N_row; ++k) {
+        int2 const& row = batch.rows[k];
+        simulation_compute_force(batch.grid_view(row.x), batch.parameters[row.x], row.y, row.y + 1);
+    }
+}
+
+void cloth_batch_numerical_integration(cloth_batch_structure& batch)
+{
+    int const N_row = batch.rows.size();
+#pragma omp parallel for
+    for (int k = 0; k < N_row; ++k) {
+        int2 const& row = batch.rows[k];
+        simulation_parameters const& parameters = batch.parameters[row.x];
+        simulation_numerical_integration(batch.grid_view(row.x), parameters, parameters.dt, row.y, row.y + 1);
+    }
+}
+
+void cloth_batch_apply_constraints(cloth_batch_structure& batch)
+{
+    // Fixed positions
+    int const N_cloth = batch.size();
+    for (int k_cloth = 0; k_cloth < N_cloth; ++k_cloth) {
+        cloth_grid_view const cloth = batch.grid_view(k_cloth);
+        for (auto const& it : batch.constraint[k_cloth].fixed_sample) {
+            position_contraint const& c = it.second;
+            cloth.position[c.ku + cloth.N * c.kv] = c.position;
+        }
+    }
+
+    // Collisions
+    int const N_row = batch.rows.size();
+#pragma omp parallel for
+    for (int k = 0; k < N_row; ++k) {
+        int2 const& row = batch.rows[k];
+        simulation_apply_collisions(batch.grid_view(row.x), batch.constraint[row.x], row.y, row.y + 1);
+    }
+}
+
+void cloth_batch_update_normal(cloth_batch_structure& batch)
+{
+    int const N_row = batch.rows.size();
+#pragma omp parallel for
+    for (int k = 0; k < N_row; ++k) {
+        int2 const& row = batch.rows[k];
+        cloth_grid_view const cloth = batch.grid_view(row.x);
+        normal_grid_rows(cloth.position, cloth.normal, cloth.N, row.y, row.y + 1);
+    }
+}
+
+void cloth_batch_simulation_step(cloth_batch_structure& batch)
+{
+    cloth_batch_compute_force(batch);
+    cloth_batch_numerical_integration(batch);
+    cloth_batch_apply_constraints(batch);
+    cloth_batch_update_normal(batch);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "cgp/cgp.hpp"
+#include "../cloth/cloth.hpp"
+#include "../constraint/constraint.hpp"
+#include "../simulation/simulation.hpp"
+
+
+// Many cloths (ex. the capes of a crowd) simulated together
+//  The vertices of all the cloths are packed in a single arena, with one contiguous array per attribute.
+//  Each simulation stage runs as a single parallel loop over the rows of all the cloths, with the parameters and constraints of each cloth.
+//  The cloths can have different resolutions. The aerodynamic model is not available in batch (the wind acts along the vertex normals).
+struct cloth_batch_structure
+{
+    // Arena storing the vertices of all the cloths
+    cgp::numarray<cgp::vec3> position;
+    cgp::numarray<cgp::vec3> velocity;
+    cgp::numarray<cgp::vec3> force;
+    cgp::numarray<cgp::vec3> normal;
+
+    // Description of each cloth
+    cgp::numarray<int> vertex_offset;                 // Index of the first vertex of the cloth in the arena
+    cgp::numarray<int> N_samples;                     // Number of vertices along one dimension of the cloth grid
+    std::vector<simulation_parameters> parameters;    // Simulation parameters of each cloth
+    std::vector<constraint_structure> constraint;     // Pins and colliders of each cloth
+
+    // Work items of the parallel loops: (cloth index, row kv) for every row of every cloth
+    cgp::numarray<cgp::int2> rows;
+
+
+    // Append a cloth to the batch (its current state is copied), returns its index in the batch
+    int add(cloth_structure const& cloth, simulation_parameters const& parameters);
+    void clear();
+
+    // Copy the state of the cloth k_cloth back in a cloth_structure of the same resolution
+    void extract(int k_cloth, cloth_structure& cloth) const;
+
+    cloth_grid_view grid_view(int k_cloth); // View on the buffers of the cloth k_cloth in the arena
+    int size() const;                       // Number of cloths
+};
+
+
+// Simulation stages applied on all the cloths of the batch (each one is a single parallel dispatch)
+void cloth_batch_compute_force(cloth_batch_structure& batch);
+void cloth_batch_numerical_integration(cloth_batch_structure& batch);
+void cloth_batch_apply_constraints(cloth_batch_structure& batch);
+void cloth_batch_update_normal(cloth_batch_structure& batch);
+
+// One complete simulation step (force, integration, constraints, normals) of every cloth with its own time step
+void cloth_batch_simulation_step(cloth_batch_structure& batch);
@@ -0,0 +1,57 @@
+#include "cgp/01_base/base.hpp"
+#include "../cloth_batch.hpp"
+
+#include <iostream>
+
+using namespace cgp;
+
+namespace cgp_test {
+
+	// The batched simulation of cloths of different resolutions and parameters gives the same result as their individual simulation
+	void test_cloth_batch()
+	{
+		int const N_cloth = 3;
+		int const N_samples[N_cloth] = { 8, 13, 20 };
+		float const K[N_cloth] = { 5.0f, 10.0f, 2.0f };
+
+		cloth_batch_structure batch;
+		cloth_structure cloth[N_cloth];
+		simulation_parameters parameters[N_cloth];
+		constraint_structure constraint[N_cloth];
+		for (int k = 0; k < N_cloth; ++k) {
+			int const N = N_samples[k];
+			cloth[k].initialize(N);
+			parameters[k].K = K[k];
+			parameters[k].wind.magnitude = 2.0f * k;
+			parameters[k].wind.direction = { 0,0,1 };
+			constraint[k].add_fixed_position(0, 0, cloth[k].position(0, 0));
+			constraint[k].add_fixed_position(N - 1, 0, cloth[k].position(N - 1, 0));
+			constraint[k].spherical_constraints.push_back({ {0.1f * k,-0.4f,-0.6f}, 0.2f });
+
+			int const k_batch = batch.add(cloth[k], parameters[k]);
+			assert_cgp_no_msg(k_batch == k);
+			batch.constraint[k] = constraint[k];
+		}
+
+		for (int k_step = 0; k_step < 100; ++k_step) {
+			cloth_batch_simulation_step(batch);
+			for (int k = 0; k < N_cloth; ++k) {
+				simulation_compute_force(cloth[k], parameters[k]);
+				simulation_numerical_integration(cloth[k], parameters[k], parameters[k].dt);
+				simulation_apply_constraints(cloth[k], constraint[k]);
+				simulation_update_normal(cloth[k], parameters[k]);
+			}
+		}
+
+		for (int k = 0; k < N_cloth; ++k) {
+			cloth_structure result;
+			result.initialize(N_samples[k]);
+			batch.extract(k, result);
+			for (int i = 0; i < result.position.size(); ++i) {
+				assert_cgp_no_msg(is_equal(result.position.data[i], cloth[k].position.data[i]));
+				assert_cgp_no_msg(is_equal(result.velocity.data[i], cloth[k].velocity.data[i]));
+			}
+		}
+	}
+
+}
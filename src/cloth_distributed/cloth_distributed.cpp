@@ -0,0 +1,324 @@
+#include "cloth_distributed.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace cgp;
+
+
+// Number of rings of halo: the springs of the 24 neighbors stencil reach 2 vertices away
+static int const halo_width = 2;
+
+void cloth_distributed_decomposition::initialize(int N_arg, int N_process)
+{
+    assert_cgp_no_msg(N_process >= 1);
+    N = N_arg;
+
+    // Largest divisor of N_process below its square root
+    N_block_v = 1;
+    for (int d = 1; d * d <= N_process; ++d)
+        if (N_process % d == 0)
+            N_block_v = d;
+    N_block_u = N_process / N_block_v;
+
+    assert_cgp(N / N_block_u >= halo_width && N / N_block_v >= halo_width, "The blocks of the distributed cloth must have at least 2 vertices per edge (N=" + str(N) + ", " + str(N_process) + " processes)");
+}
+
+int cloth_distributed_decomposition::N_process() const
+{
+    return N_block_u * N_block_v;
+}
+
+void cloth_distributed_decomposition::block_range(int rank, int& ku_min, int& ku_max, int& kv_min, int& kv_max) const
+{
+    int const bu = rank % N_block_u;
+    int const bv = rank / N_block_u;
+    ku_min = bu * N / N_block_u;
+    ku_max = (bu + 1) * N / N_block_u;
+    kv_min = bv * N / N_block_v;
+    kv_max = (bv + 1) * N / N_block_v;
+}
+
+
+// Intersection of the range a with the range b extended by the halo (ranges as ku_min, ku_max, kv_min, kv_max). Returns false if empty.
+static bool intersect_halo(int const* a, int const* b, int* result)
+{
+    result[0] = std::max(a[0], b[0] - halo_width);
+    result[1] = std::min(a[1], b[1] + halo_width);
+    result[2] = std::max(a[2], b[2] - halo_width);
+    result[3] = std::min(a[3], b[3] + halo_width);
+    return result[0] < result[1] && result[2] < result[3];
+}
+
+void cloth_distributed_block::initialize(cloth_distributed_decomposition const& decomposition_arg, int rank_arg, cloth_structure const& cloth)
+{
+    decomposition = decomposition_arg;
+    rank = rank_arg;
+    int const N = decomposition.N;
+    assert_cgp_no_msg(cloth.N_samples() == N);
+
+    decomposition.block_range(rank, ku_min, ku_max, kv_min, kv_max);
+    stride = ku_max - ku_min + 2 * halo_width;
+    int const N_row = kv_max - kv_min + 2 * halo_width;
+    position.resize_clear(stride * N_row);
+    velocity.resize_clear(stride * N_row);
+    force.resize_clear(stride * N_row);
+    normal.resize_clear(stride * N_row);
+
+    // Owned vertices and halo that are in the grid
+    cloth_block_view const block = view();
+    for (int kv = std::max(kv_min - halo_width, 0); kv < std::min(kv_max + halo_width, N); ++kv) {
+        for (int ku = std::max(ku_min - halo_width, 0); ku < std::min(ku_max + halo_width, N); ++ku) {
+            position[block.index(ku, kv)] = cloth.position(ku, kv);
+            velocity[block.index(ku, kv)] = cloth.velocity(ku, kv);
+        }
+    }
+
+    // Halos exchanged with the 8 neighboring blocks
+    halo.clear();
+    int const bu = rank % decomposition.N_block_u;
+    int const bv = rank / decomposition.N_block_u;
+    int const owned[4] = { ku_min, ku_max, kv_min, kv_max };
+    for (int dv = -1; dv <= 1; ++dv) {
+        for (int du = -1; du <= 1; ++du) {
+            int const nu = bu + du;
+            int const nv = bv + dv;
+            if ((du == 0 && dv == 0) || nu < 0 || nu >= decomposition.N_block_u || nv < 0 || nv >= decomposition.N_block_v)
+                continue;
+
+            cloth_distributed_halo h;
+            h.rank = nu + decomposition.N_block_u * nv;
+            int other[4];
+            decomposition.block_range(h.rank, other[0], other[1], other[2], other[3]);
+            bool const has_send = intersect_halo(owned, other, h.send);
+            bool const has_receive = intersect_halo(other, owned, h.receive);
+            assert_cgp_no_msg(has_send == has_receive);
+            if (!has_send)
+                continue;
+            h.send_buffer.resize((h.send[1] - h.send[0]) * (h.send[3] - h.send[2]));
+            h.receive_buffer.resize((h.receive[1] - h.receive[0]) * (h.receive[3] - h.receive[2]));
+            halo.push_back(h);
+        }
+    }
+}
+
+cloth_block_view cloth_distributed_block::view()
+{
+    return { position.data.data(), velocity.data.data(), force.data.data(), normal.data.data(), nullptr, decomposition.N, ku_min - halo_width, kv_min - halo_width, stride };
+}
+
+void cloth_distributed_block::pack_halo()
+{
+    cloth_block_view const block = view();
+    for (cloth_distributed_halo& h : halo) {
+        vec3* buffer = h.send_buffer.data.data();
+        for (int kv = h.send[2]; kv < h.send[3]; ++kv)
+            for (int ku = h.send[0]; ku < h.send[1]; ++ku)
+                *buffer++ = block.position[block.index(ku, kv)];
+    }
+}
+
+void cloth_distributed_block::unpack_halo()
+{
+    cloth_block_view const block = view();
+    for (cloth_distributed_halo const& h : halo) {
+        vec3 const* buffer = h.receive_buffer.data.data();
+        for (int kv = h.receive[2]; kv < h.receive[3]; ++kv)
+            for (int ku = h.receive[0]; ku < h.receive[1]; ++ku)
+                block.position[block.index(ku, kv)] = *buffer++;
+    }
+}
+
+
+// Owned vertices whose neighbors up to 2 vertices away are all owned (the borders of the grid have no neighbor beyond them)
+//  An empty interior is returned as [ku_min,ku_min[ x [kv_max,kv_max[: the border rings then cover the whole block.
+static void interior_range(cloth_distributed_block const& b, int& iu_min, int& iu_max, int& iv_min, int& iv_max)
+{
+    int const N = b.decomposition.N;
+    iu_min = b.ku_min == 0 ? 0 : b.ku_min + halo_width;
+    iu_max = b.ku_max == N ? N : b.ku_max - halo_width;
+    iv_min = b.kv_min == 0 ? 0 : b.kv_min + halo_width;
+    iv_max = b.kv_max == N ? N : b.kv_max - halo_width;
+    if (iu_min >= iu_max || iv_min >= iv_max) {
+        iu_min = iu_max = b.ku_min;
+        iv_min = iv_max = b.kv_max;
+    }
+}
+
+// Normals then forces of the vertices of a range, row by row in parallel
+static void normal_and_force_range(cloth_block_view const& block, simulation_parameters const& parameters, int ku_min, int ku_max, int kv_min, int kv_max)
+{
+    if (ku_min >= ku_max)
+        return;
+#pragma omp parallel for
+    for (int kv = kv_min; kv < kv_max; ++kv) {
+        normal_grid_block(block, ku_min, ku_max, kv, kv + 1);
+        simulation_compute_force(block, parameters, ku_min, ku_max, kv, kv + 1);
+    }
+}
+
+void cloth_distributed_block::step_interior(simulation_parameters const& parameters)
+{
+    int iu_min, iu_max, iv_min, iv_max;
+    interior_range(*this, iu_min, iu_max, iv_min, iv_max);
+    normal_and_force_range(view(), parameters, iu_min, iu_max, iv_min, iv_max);
+}
+
+void cloth_distributed_block::step_border(simulation_parameters const& parameters, constraint_structure const& constraint, float dt)
+{
+    cloth_block_view const block = view();
+    int iu_min, iu_max, iv_min, iv_max;
+    interior_range(*this, iu_min, iu_max, iv_min, iv_max);
+
+    // Rings along the borders: the rows below and above the interior, and the columns on its left and right
+    normal_and_force_range(block, parameters, ku_min, ku_max, kv_min, iv_min);
+    normal_and_force_range(block, parameters, ku_min, ku_max, iv_max, kv_max);
+    normal_and_force_range(block, parameters, ku_min, iu_min, iv_min, iv_max);
+    normal_and_force_range(block, parameters, iu_max, ku_max, iv_min, iv_max);
+
+    // Integration and constraints of the owned vertices, in the order of simulation_apply_constraints
+#pragma omp parallel for
+    for (int kv = kv_min; kv < kv_max; ++kv)
+        simulation_numerical_integration(block, parameters, dt, ku_min, ku_max, kv, kv + 1);
+
+    for (auto const& it : constraint.fixed_sample) {
+        position_contraint const& c = it.second;
+        if (c.ku >= ku_min && c.ku < ku_max && c.kv >= kv_min && c.kv < kv_max)
+            block.position[block.index(c.ku, c.kv)] = c.position;
+    }
+
+#pragma omp parallel for
+    for (int kv = kv_min; kv < kv_max; ++kv)
+        simulation_apply_collisions(block, constraint, ku_min, ku_max, kv, kv + 1);
+}
+
+void cloth_distributed_block::copy_to(cloth_structure& cloth) const
+{
+    int const ku_origin = ku_min - halo_width;
+    int const kv_origin = kv_min - halo_width;
+    for (int kv = kv_min; kv < kv_max; ++kv) {
+        for (int ku = ku_min; ku < ku_max; ++ku) {
+            int const offset = (ku - ku_origin) + stride * (kv - kv_origin);
+            cloth.position(ku, kv) = position[offset];
+            cloth.velocity(ku, kv) = velocity[offset];
+        }
+    }
+}
+
+bool cloth_distributed_block::detect_divergence() const
+{
+    int const ku_origin = ku_min - halo_width;
+    int const kv_origin = kv_min - halo_width;
+    for (int kv = kv_min; kv < kv_max; ++kv) {
+        for (int ku = ku_min; ku < ku_max; ++ku) {
+            vec3 const& p = position[(ku - ku_origin) + stride * (kv - kv_origin)];
+            if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z))
+                return true;
+        }
+    }
+    return false;
+}
+
+
+void cloth_distributed_exchange_local(std::vector<cloth_distributed_block>& blocks)
+{
+    for (cloth_distributed_block& block : blocks)
+        block.pack_halo();
+
+    // The halo received by a block from a neighbor is the one sent by the neighbor to this block
+    for (cloth_distributed_block& block : blocks) {
+        for (cloth_distributed_halo& h : block.halo) {
+            for (cloth_distributed_halo const& h_neighbor : blocks[h.rank].halo)
+                if (h_neighbor.rank == block.rank)
+                    h.receive_buffer = h_neighbor.send_buffer;
+        }
+    }
+
+    for (cloth_distributed_block& block : blocks)
+        block.unpack_halo();
+}
+
+
+#ifdef CLOTH_MPI
+void cloth_distributed_exchange::begin(cloth_distributed_block& block, MPI_Comm communicator)
+{
+    block.pack_halo();
+
+    request.resize(2 * block.halo.size());
+    for (size_t k = 0; k < block.halo.size(); ++k) {
+        cloth_distributed_halo& h = block.halo[k];
+        MPI_Irecv(h.receive_buffer.data.data(), 3 * h.receive_buffer.size(), MPI_FLOAT, h.rank, 0, communicator, &request[2 * k]);
+        MPI_Isend(h.send_buffer.data.data(), 3 * h.send_buffer.size(), MPI_FLOAT, h.rank, 0, communicator, &request[2 * k + 1]);
+    }
+}
+
+void cloth_distributed_exchange::end(cloth_distributed_block& block)
+{
+    MPI_Waitall(static_cast<int>(request.size()), request.data(), MPI_STATUSES_IGNORE);
+    block.unpack_halo();
+}
+
+void cloth_distributed_step(cloth_distributed_block& block, cloth_distributed_exchange& exchange, MPI_Comm communicator,
+    simulation_parameters const& parameters, constraint_structure const& constraint, float dt)
+{
+    exchange.begin(block, communicator);
+    block.step_interior(parameters);
+    exchange.end(block);
+    block.step_border(parameters, constraint, dt);
+}
+
+void cloth_distributed_gather(cloth_distributed_block const& block, MPI_Comm communicator, int root, cloth_structure& cloth)
+{
+    // Owned positions and velocities of each block, in the row order of the block
+    int const N_owned = (block.ku_max - block.ku_min) * (block.kv_max - block.kv_min);
+    numarray<vec3> owned;
+    owned.resize(2 * N_owned);
+    int const ku_origin = block.ku_min - halo_width;
+    int const kv_origin = block.kv_min - halo_width;
+    int k = 0;
+    for (int kv = block.kv_min; kv < block.kv_max; ++kv) {
+        for (int ku = block.ku_min; ku < block.ku_max; ++ku, ++k) {
+            int const offset = (ku - ku_origin) + block.stride * (kv - kv_origin);
+            owned[k] = block.position[offset];
+            owned[N_owned + k] = block.velocity[offset];
+        }
+    }
+
+    int rank = 0;
+    MPI_Comm_rank(communicator, &rank);
+    if (rank != root) {
+        MPI_Send(owned.data.data(), 3 * owned.size(), MPI_FLOAT, root, 1, communicator);
+        return;
+    }
+
+    cloth_distributed_decomposition const& decomposition = block.decomposition;
+    for (int r = 0; r < decomposition.N_process(); ++r) {
+        int ku_min, ku_max, kv_min, kv_max;
+        decomposition.block_range(r, ku_min, ku_max, kv_min, kv_max);
+        int const N_block = (ku_max - ku_min) * (kv_max - kv_min);
+        numarray<vec3> received;
+        if (r == rank)
+            received = owned;
+        else {
+            received.resize(2 * N_block);
+            MPI_Recv(received.data.data(), 3 * received.size(), MPI_FLOAT, r, 1, communicator, MPI_STATUS_IGNORE);
+        }
+
+        int k_block = 0;
+        for (int kv = kv_min; kv < kv_max; ++kv) {
+            for (int ku = ku_min; ku < ku_max; ++ku, ++k_block) {
+                cloth.position(ku, kv) = received[k_block];
+                cloth.velocity(ku, kv) = received[N_block + k_block];
+            }
+        }
+    }
+}
+
+bool cloth_distributed_detect_divergence(cloth_distributed_block const& block, MPI_Comm communicator)
+{
+    int const diverged_local = block.detect_divergence() ? 1 : 0;
+    int diverged = 0;
+    MPI_Allreduce(&diverged_local, &diverged, 1, MPI_INT, MPI_MAX, communicator);
+    return diverged != 0;
+}
+#endif
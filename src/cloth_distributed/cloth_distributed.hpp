@@ -0,0 +1,107 @@
+#pragma once
+
+#include "cgp/cgp.hpp"
+#include "../cloth/cloth.hpp"
+#include "../constraint/constraint.hpp"
+#include "../simulation/simulation.hpp"
+
+#include <vector>
+
+#ifdef CLOTH_MPI
+#include <mpi.h>
+#endif
+
+
+// Distributed simulation of a large cloth (offline capes of millions of vertices, see tools/distributed)
+//
+// The N x N grid is split in N_block_u x N_block_v rectangular blocks, one per process. Each block stores its vertices and a halo
+//  of 2 rings of vertices of the neighboring blocks: the 24 neighbors stencil of the springs reaches 2 vertices away.
+// A step of a block follows the order of the single process solver (grid normals, forces, integration, fixed positions and collisions):
+//  - the exchange of the halo positions with the (up to 8) neighboring blocks is started
+//  - the normals and forces of the interior vertices, that only read vertices of the block, are computed while the messages are in flight
+//  - once the halo is received: the normals and forces of the 2 rings of vertices along the borders of the block, then the integration and the constraints
+// Each vertex is computed by the same operations as in the single process solver: the results are bitwise identical for any decomposition.
+// The aerodynamic model (per-triangle forces) and the sleeping tiles are not supported.
+//
+// The exchange goes through MPI non-blocking messages when the project is compiled with CLOTH_MPI, or through memory copies
+//  between blocks of the same process (cloth_distributed_exchange_local, used by the unit test).
+
+
+// Split of the grid in blocks (the process of rank r owns the block (r % N_block_u, r / N_block_u))
+struct cloth_distributed_decomposition
+{
+    int N = 0; // vertices per edge of the whole grid
+    int N_block_u = 1;
+    int N_block_v = 1;
+
+    void initialize(int N, int N_process); // Most square split in N_process blocks, each block has at least 2 vertices per edge
+    int N_process() const;
+    void block_range(int rank, int& ku_min, int& ku_max, int& kv_min, int& kv_max) const; // Vertices [ku_min,ku_max[ x [kv_min,kv_max[ owned by a process
+};
+
+
+// Vertices of the grid exchanged with a neighboring block
+struct cloth_distributed_halo
+{
+    int rank = 0;                    // process of the neighboring block
+    int send[4];                     // range ku_min, ku_max, kv_min, kv_max of owned vertices in the halo of the neighbor
+    int receive[4];                  // range of vertices of the neighbor in the halo of this block
+    cgp::numarray<cgp::vec3> send_buffer;
+    cgp::numarray<cgp::vec3> receive_buffer;
+};
+
+// Block of the grid simulated by one process
+struct cloth_distributed_block
+{
+    cloth_distributed_decomposition decomposition;
+    int rank = 0;
+
+    // Owned vertices [ku_min,ku_max[ x [kv_min,kv_max[, stored with 2 rings of halo (the rings outside the grid are not used)
+    int ku_min = 0, ku_max = 0, kv_min = 0, kv_max = 0;
+    int stride = 0;
+    cgp::numarray<cgp::vec3> position;
+    cgp::numarray<cgp::vec3> velocity;
+    cgp::numarray<cgp::vec3> force;
+    cgp::numarray<cgp::vec3> normal;
+
+    std::vector<cloth_distributed_halo> halo;
+
+    // Copy the owned vertices and their halo from the whole cloth (every process can build the same initial cloth)
+    void initialize(cloth_distributed_decomposition const& decomposition, int rank, cloth_structure const& cloth);
+    cloth_block_view view();
+
+    void pack_halo();   // Copy the positions sent to each neighbor in its send buffer
+    void unpack_halo(); // Copy the received positions in the halo
+
+    // The two parts of a step, before and after the halo positions are received (see the description of the decomposition above)
+    void step_interior(simulation_parameters const& parameters);
+    void step_border(simulation_parameters const& parameters, constraint_structure const& constraint, float dt);
+
+    void copy_to(cloth_structure& cloth) const; // Write the position and velocity of the owned vertices in the whole cloth
+    bool detect_divergence() const;             // True if an owned vertex is not finite
+};
+
+// Exchange of the halos between blocks simulated by the same process
+void cloth_distributed_exchange_local(std::vector<cloth_distributed_block>& blocks);
+
+
+#ifdef CLOTH_MPI
+// Non-blocking exchange of the halo of the block of this process with its neighbors
+struct cloth_distributed_exchange
+{
+    std::vector<MPI_Request> request;
+
+    void begin(cloth_distributed_block& block, MPI_Comm communicator); // Pack the halos, post the receives and the sends
+    void end(cloth_distributed_block& block);                          // Wait for the messages and unpack the received halos
+};
+
+// One step of the block of this process, the interior being computed during the exchange
+void cloth_distributed_step(cloth_distributed_block& block, cloth_distributed_exchange& exchange, MPI_Comm communicator,
+    simulation_parameters const& parameters, constraint_structure const& constraint, float dt);
+
+// Positions and velocities of all the blocks gathered in the whole cloth of the process root (the other processes do not modify cloth)
+void cloth_distributed_gather(cloth_distributed_block const& block, MPI_Comm communicator, int root, cloth_structure& cloth);
+
+// True on all the processes if a block diverged
+bool cloth_distributed_detect_divergence(cloth_distributed_block const& block, MPI_Comm communicator);
+#endif
@@ -0,0 +1,73 @@
+#include "cgp/01_base/base.hpp"
+#include "../cloth_distributed.hpp"
+
+#include <cstring>
+
+using namespace cgp;
+
+// Pinned cloth falling on a sphere under wind, simulated by the single process solver or by blocks exchanging their halos in memory
+static void initialize_scenario(int N, cloth_structure& cloth, simulation_parameters& parameters, constraint_structure& constraint)
+{
+	cloth.initialize(N);
+	parameters.wind.magnitude = 5.0f;
+	parameters.wind.direction = { 0,0,1 };
+	constraint.add_fixed_position(0, 0, cloth.position(0, 0));
+	constraint.add_fixed_position(N - 1, 0, cloth.position(N - 1, 0));
+	constraint.add_fixed_position(N / 2, 0, cloth.position(N / 2, 0));
+	constraint.spherical_constraints.push_back({ {0.5f,-0.3f,-0.6f}, 0.2f });
+}
+
+namespace cgp_test {
+
+	// The distributed solver gives bitwise the same cloth as the single process solver, for blocks of various shapes
+	//  (down to blocks of 2 vertices per edge, whose halo is the whole neighboring blocks)
+	void test_cloth_distributed()
+	{
+		int const N = 18;
+		int const N_step = 150;
+
+		cloth_structure reference;
+		simulation_parameters parameters_reference;
+		constraint_structure constraint_reference;
+		initialize_scenario(N, reference, parameters_reference, constraint_reference);
+		for (int k_step = 0; k_step < N_step; ++k_step) {
+			reference.update_normal_grid();
+			simulation_compute_force(reference, parameters_reference);
+			simulation_numerical_integration(reference, parameters_reference, parameters_reference.dt);
+			simulation_apply_constraints(reference, constraint_reference);
+		}
+		assert_cgp_no_msg(simulation_detect_divergence(reference) == false);
+
+		for (int N_process : { 1, 4, 6, 81 }) {
+			// Same scenario as the reference, built from scratch (the constraint would otherwise accumulate a copy of the sphere)
+			cloth_structure cloth;
+			simulation_parameters parameters;
+			constraint_structure constraint;
+			initialize_scenario(N, cloth, parameters, constraint);
+
+			cloth_distributed_decomposition decomposition;
+			decomposition.initialize(N, N_process);
+			assert_cgp_no_msg(decomposition.N_process() == N_process);
+			std::vector<cloth_distributed_block> blocks(N_process);
+			for (int rank = 0; rank < N_process; ++rank)
+				blocks[rank].initialize(decomposition, rank, cloth);
+
+			for (int k_step = 0; k_step < N_step; ++k_step) {
+				for (cloth_distributed_block& block : blocks)
+					block.step_interior(parameters);
+				cloth_distributed_exchange_local(blocks);
+				for (cloth_distributed_block& block : blocks)
+					block.step_border(parameters, constraint, parameters.dt);
+			}
+
+			for (cloth_distributed_block const& block : blocks) {
+				assert_cgp_no_msg(block.detect_divergence() == false);
+				block.copy_to(cloth);
+			}
+			size_t const size = reference.position.size() * sizeof(vec3);
+			assert_cgp_no_msg(std::memcmp(cloth.position.data.data.data(), reference.position.data.data.data(), size) == 0);
+			assert_cgp_no_msg(std::memcmp(cloth.velocity.data.data.data(), reference.velocity.data.data.data(), size) == 0);
+		}
+	}
+
+}
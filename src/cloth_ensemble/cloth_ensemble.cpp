@@ -0,0 +1,347 @@
+#include "cloth_ensemble.hpp"
+#include "../simulation/spring_stencil.hpp"
+
+using namespace cgp;
+
+
+// Helpers to access the lanes of a coordinate of a vertex (unchecked: used in the inner loops)
+template <int N_lane>
+static float* lanes(numarray<float>& value, int k_vertex, int k_coordinate)
+{
+    return value.data.data() + (3 * k_vertex + k_coordinate) * N_lane;
+}
+template <int N_lane>
+static float const* lanes(numarray<float> const& value, int k_vertex, int k_coordinate)
+{
+    return value.data.data() + (3 * k_vertex + k_coordinate) * N_lane;
+}
+
+
+// Check that the parameters of the lanes are supported by the ensemble (see cloth_ensemble_structure)
+template <int N_lane>
+static void check_parameters(std::array<simulation_parameters, N_lane> const& parameters)
+{
+    for (int l = 0; l < N_lane; ++l) {
+        assert_cgp(parameters[l].stencil == parameters[0].stencil, "Lane " + str(l) + " has a stencil of " + str(parameters[l].stencil) + " springs, lane 0 of " + str(parameters[0].stencil) + ": the lanes of an ensemble share their stencil");
+        assert_cgp(parameters[l].aerodynamics.active == false, "Lane " + str(l) + ": the aerodynamic model is not supported by the ensemble");
+        assert_cgp(parameters[l].wind.field.active == false, "Lane " + str(l) + ": the turbulent wind field is not supported by the ensemble");
+    }
+}
+
+template <int N_lane>
+void cloth_ensemble_structure<N_lane>::initialize(cloth_structure const& cloth, std::array<simulation_parameters, N_lane> const& parameters_arg)
+{
+    check_parameters<N_lane>(parameters_arg);
+    N = cloth.N_samples();
+    parameters = parameters_arg;
+
+    int const N_value = 3 * N * N * N_lane;
+    position.resize(N_value);
+    velocity.resize(N_value);
+    force.resize_clear(N_value);
+    normal.resize(N_value);
+
+    for (int k = 0; k < N * N; ++k) {
+        for (int c = 0; c < 3; ++c) {
+            for (int l = 0; l < N_lane; ++l) {
+                lanes<N_lane>(position, k, c)[l] = cloth.position.data[k][c];
+                lanes<N_lane>(velocity, k, c)[l] = cloth.velocity.data[k][c];
+                lanes<N_lane>(normal, k, c)[l] = cloth.normal.data[k][c];
+            }
+        }
+    }
+}
+
+template <int N_lane>
+void cloth_ensemble_structure<N_lane>::extract(int lane, cloth_structure& cloth) const
+{
+    assert_cgp(cloth.N_samples() == N, "Cloth of resolution " + str(cloth.N_samples()) + " cannot receive an ensemble of resolution " + str(N));
+    assert_cgp(lane >= 0 && lane < N_lane, "lane=" + str(lane) + " should be in [0," + str(N_lane) + "[");
+
+    for (int k = 0; k < N * N; ++k) {
+        for (int c = 0; c < 3; ++c) {
+            cloth.position.data[k][c] = lanes<N_lane>(position, k, c)[lane];
+            cloth.velocity.data[k][c] = lanes<N_lane>(velocity, k, c)[lane];
+            cloth.force.data[k][c] = lanes<N_lane>(force, k, c)[lane];
+            cloth.normal.data[k][c] = lanes<N_lane>(normal, k, c)[lane];
+        }
+    }
+}
+
+
+// Forces of the vertices of the row kv, for all the lanes
+//  The innermost loops run over the lanes with a fixed trip count: they are compiled as SIMD operations.
+template <int N_lane, typename ensemble_stencil>
+static void compute_force_row_stencil(cloth_ensemble_structure<N_lane>& e, int kv, float const* m, float const* K, float const* mu, float const* wind_x, float const* wind_y, float const* wind_z)
+{
+#ifdef SOLUTION
+    int const N = e.N;
+    float const L0 = 1.0f / (N - 1.0f);
+    float const g = -9.81f;
+
+    for (int ku = 0; ku < N; ++ku) {
+        int const k = ku + N * kv;
+        float* fx = lanes<N_lane>(e.force, k, 0);
+        float* fy = lanes<N_lane>(e.force, k, 1);
+        float* fz = lanes<N_lane>(e.force, k, 2);
+        float const* px = lanes<N_lane>(e.position, k, 0);
+        float const* py = lanes<N_lane>(e.position, k, 1);
+        float const* pz = lanes<N_lane>(e.position, k, 2);
+        float const* vx = lanes<N_lane>(e.velocity, k, 0);
+        float const* vy = lanes<N_lane>(e.velocity, k, 1);
+        float const* vz = lanes<N_lane>(e.velocity, k, 2);
+        float const* nx = lanes<N_lane>(e.normal, k, 0);
+        float const* ny = lanes<N_lane>(e.normal, k, 1);
+        float const* nz = lanes<N_lane>(e.normal, k, 2);
+
+        // gravity, damping and wind
+#pragma omp simd
+        for (int l = 0; l < N_lane; ++l) {
+            float const coeff = (wind_x[l] * nx[l] + wind_y[l] * ny[l] + wind_z[l] * nz[l]) * L0 * L0;
+            fx[l] = -mu[l] * m[l] * vx[l] + coeff * nx[l];
+            fy[l] = m[l] * g - mu[l] * m[l] * vy[l] + coeff * ny[l];
+            fz[l] = -mu[l] * m[l] * vz[l] + coeff * nz[l];
+        }
+
+        // springs
+        for (int kn = 0; kn < ensemble_stencil::N_neighbor; ++kn) {
+            int const ku_n = ku + ensemble_stencil::offset_u[kn];
+            int const kv_n = kv + ensemble_stencil::offset_v[kn];
+            if (ku_n < 0 || ku_n >= N || kv_n < 0 || kv_n >= N)
+                continue;
+
+            float const a = ensemble_stencil::alpha[kn];
+            int const k_n = ku_n + N * kv_n;
+            float const* pnx = lanes<N_lane>(e.position, k_n, 0);
+            float const* pny = lanes<N_lane>(e.position, k_n, 1);
+            float const* pnz = lanes<N_lane>(e.position, k_n, 2);
+
+#pragma omp simd
+            for (int l = 0; l < N_lane; ++l) {
+                float const dx = px[l] - pnx[l];
+                float const dy = py[l] - pny[l];
+                float const dz = pz[l] - pnz[l];
+                float const L = std::sqrt(dx * dx + dy * dy + dz * dz);
+                float const s = -(K[l] / a) * (L - a * L0) / L;
+                fx[l] += s * dx;
+                fy[l] += s * dy;
+                fz[l] += s * dz;
+            }
+        }
+    }
+#else
+    (void)e; (void)kv; (void)m; (void)K; (void)mu; (void)wind_x; (void)wind_y; (void)wind_z;
+#endif
+}
+
+// Kernel of the stencil shared by the lanes (any other value than 4, 8 or 12 uses the 24 neighbors, as the single cloth simulation)
+template <int N_lane>
+static void compute_force_row(cloth_ensemble_structure<N_lane>& e, int kv, float const* m, float const* K, float const* mu, float const* wind_x, float const* wind_y, float const* wind_z)
+{
+    switch (e.parameters[0].stencil) {
+    case 4: compute_force_row_stencil<N_lane, spring_stencil_4>(e, kv, m, K, mu, wind_x, wind_y, wind_z); break;
+    case 8: compute_force_row_stencil<N_lane, spring_stencil_8>(e, kv, m, K, mu, wind_x, wind_y, wind_z); break;
+    case 12: compute_force_row_stencil<N_lane, spring_stencil_12>(e, kv, m, K, mu, wind_x, wind_y, wind_z); break;
+    default: compute_force_row_stencil<N_lane, spring_stencil_24>(e, kv, m, K, mu, wind_x, wind_y, wind_z); break;
+    }
+}
+
+// Semi-implicit integration of the row kv
+template <int N_lane>
+static void numerical_integration_row(cloth_ensemble_structure<N_lane>& e, int kv, float const* m, float const* dt)
+{
+    int const N = e.N;
+    for (int ku = 0; ku < N; ++ku) {
+        int const k = ku + N * kv;
+        for (int c = 0; c < 3; ++c) {
+            float* v = lanes<N_lane>(e.velocity, k, c);
+            float* p = lanes<N_lane>(e.position, k, c);
+            float const* f = lanes<N_lane>(e.force, k, c);
+#pragma omp simd
+            for (int l = 0; l < N_lane; ++l) {
+                v[l] = v[l] + dt[l] * f[l] / m[l];
+                p[l] = p[l] + dt[l] * v[l];
+            }
+        }
+    }
+}
+
+// Collisions of the vertices of the row kv with the ground, spheres and cylinders (same model as the single cloth simulation)
+template <int N_lane>
+static void apply_collision_row(cloth_ensemble_structure<N_lane>& e, int kv)
+{
+#ifdef SOLUTION
+    float const epsilon = 1e-2f;
+    constraint_structure const& constraint = e.constraint;
+    int const N = e.N;
+
+    for (int ku = 0; ku < N; ++ku) {
+        int const k = ku + N * kv;
+        float* px = lanes<N_lane>(e.position, k, 0);
+        float* py = lanes<N_lane>(e.position, k, 1);
+        float* pz = lanes<N_lane>(e.position, k, 2);
+        float* vx = lanes<N_lane>(e.velocity, k, 0);
+        float* vy = lanes<N_lane>(e.velocity, k, 1);
+        float* vz = lanes<N_lane>(e.velocity, k, 2);
+
+        // Ground
+        float const y_min = constraint.ground_y + epsilon;
+#pragma omp simd
+        for (int l = 0; l < N_lane; ++l) {
+            bool const inside = py[l] <= y_min;
+            py[l] = inside ? y_min : py[l];
+            vy[l] = inside ? 0.0f : vy[l];
+        }
+
+        // Spheres
+        for (sphere_parameter const& sphere : constraint.spherical_constraints) {
+            vec3 const& p0 = sphere.center;
+            float const r = sphere.radius + epsilon;
+#pragma omp simd
+            for (int l = 0; l < N_lane; ++l) {
+                float const dx = px[l] - p0.x;
+                float const dy = py[l] - p0.y;
+                float const dz = pz[l] - p0.z;
+                float const d = std::sqrt(dx * dx + dy * dy + dz * dz);
+                if (d < r && d > 0) {
+                    float const ux = dx / d, uy = dy / d, uz = dz / d;
+                    px[l] = p0.x + r * ux;
+                    py[l] = p0.y + r * uy;
+                    pz[l] = p0.z + r * uz;
+                    float const vn = vx[l] * ux + vy[l] * uy + vz[l] * uz;
+                    vx[l] -= vn * ux;
+                    vy[l] -= vn * uy;
+                    vz[l] -= vn * uz;
+                }
+            }
+        }
+
+        // Cylinders (segment [p0,p1] of radius r)
+        for (cylinder_parameter const& cylinder : constraint.cylindrical_constraints) {
+            vec3 const& p0 = cylinder.positionStart;
+            vec3 const p01 = cylinder.positionEnd - cylinder.positionStart;
+            float const L01_squared = dot(p01, p01);
+            float const r = cylinder.radius + epsilon;
+            for (int l = 0; l < N_lane; ++l) {
+                vec3 const p = { px[l], py[l], pz[l] };
+                float const t = dot(p - p0, p01) / L01_squared;
+                if (t < 0 || t > 1)
+                    continue;
+                vec3 const axis_point = p0 + t * p01;
+                vec3 const d = p - axis_point;
+                float const Ld = norm(d);
+                if (Ld < r && Ld > 0) {
+                    vec3 const u = d / Ld;
+                    vec3 const v = { vx[l], vy[l], vz[l] };
+                    vec3 const p_new = axis_point + r * u;
+                    vec3 const v_new = v - dot(v, u) * u;
+                    px[l] = p_new.x; py[l] = p_new.y; pz[l] = p_new.z;
+                    vx[l] = v_new.x; vy[l] = v_new.y; vz[l] = v_new.z;
+                }
+            }
+        }
+    }
+#else
+    (void)e; (void)kv;
+#endif
+}
+
+// Normals of the row kv from central differences (same as cloth_structure::update_normal_grid)
+template <int N_lane>
+static void update_normal_row(cloth_ensemble_structure<N_lane>& e, int kv)
+{
+    int const N = e.N;
+    int const kv_prev = std::max(kv - 1, 0);
+    int const kv_next = std::min(kv + 1, N - 1);
+    for (int ku = 0; ku < N; ++ku) {
+        int const k = ku + N * kv;
+        int const k_u0 = std::max(ku - 1, 0) + N * kv;
+        int const k_u1 = std::min(ku + 1, N - 1) + N * kv;
+        int const k_v0 = ku + N * kv_prev;
+        int const k_v1 = ku + N * kv_next;
+
+        float du[3][N_lane], dv[3][N_lane];
+        for (int c = 0; c < 3; ++c) {
+            float const* pu0 = lanes<N_lane>(e.position, k_u0, c);
+            float const* pu1 = lanes<N_lane>(e.position, k_u1, c);
+            float const* pv0 = lanes<N_lane>(e.position, k_v0, c);
+            float const* pv1 = lanes<N_lane>(e.position, k_v1, c);
+#pragma omp simd
+            for (int l = 0; l < N_lane; ++l) {
+                du[c][l] = pu1[l] - pu0[l];
+                dv[c][l] = pv1[l] - pv0[l];
+            }
+        }
+
+        float* nx = lanes<N_lane>(e.normal, k, 0);
+        float* ny = lanes<N_lane>(e.normal, k, 1);
+        float* nz = lanes<N_lane>(e.normal, k, 2);
+#pragma omp simd
+        for (int l = 0; l < N_lane; ++l) {
+            float const x = dv[1][l] * du[2][l] - dv[2][l] * du[1][l];
+            float const y = dv[2][l] * du[0][l] - dv[0][l] * du[2][l];
+            float const z = dv[0][l] * du[1][l] - dv[1][l] * du[0][l];
+            float const L = std::sqrt(x * x + y * y + z * z);
+            float const inv = L > 1e-12f ? 1.0f / L : 0.0f;
+            nx[l] = x * inv;
+            ny[l] = y * inv;
+            nz[l] = z * inv;
+        }
+    }
+}
+
+
+template <int N_lane>
+void cloth_ensemble_simulation_step(cloth_ensemble_structure<N_lane>& ensemble)
+{
+    int const N = ensemble.N;
+    check_parameters<N_lane>(ensemble.parameters); // the parameters may have been changed since initialize()
+
+    // Per-lane constants of the step
+    alignas(64) float m[N_lane], K[N_lane], mu[N_lane], dt[N_lane], wind_x[N_lane], wind_y[N_lane], wind_z[N_lane];
+    for (int l = 0; l < N_lane; ++l) {
+        simulation_parameters const& parameters = ensemble.parameters[l];
+        m[l] = parameters.mass_total / (N * N);
+        K[l] = parameters.K;
+        mu[l] = parameters.mu;
+        dt[l] = parameters.dt;
+        wind_x[l] = parameters.wind.magnitude * parameters.wind.direction.x;
+        wind_y[l] = parameters.wind.magnitude * parameters.wind.direction.y;
+        wind_z[l] = parameters.wind.magnitude * parameters.wind.direction.z;
+    }
+
+#pragma omp parallel for
+    for (int kv = 0; kv < N; ++kv)
+        compute_force_row(ensemble, kv, m, K, mu, wind_x, wind_y, wind_z);
+
+#pragma omp parallel for
+    for (int kv = 0; kv < N; ++kv)
+        numerical_integration_row(ensemble, kv, m, dt);
+
+    // Fixed positions (shared by all the lanes), then collisions
+    for (auto const& it : ensemble.constraint.fixed_sample) {
+        position_contraint const& c = it.second;
+        int const k = c.ku + N * c.kv;
+        for (int coord = 0; coord < 3; ++coord) {
+            float* p = lanes<N_lane>(ensemble.position, k, coord);
+            for (int l = 0; l < N_lane; ++l)
+                p[l] = c.position[coord];
+        }
+    }
+#pragma omp parallel for
+    for (int kv = 0; kv < N; ++kv)
+        apply_collision_row(ensemble, kv);
+
+#pragma omp parallel for
+    for (int kv = 0; kv < N; ++kv)
+        update_normal_row(ensemble, kv);
+}
+
+
+// Supported ensemble sizes
+template struct cloth_ensemble_structure<4>;
+template struct cloth_ensemble_structure<8>;
+template struct cloth_ensemble_structure<16>;
+template void cloth_ensemble_simulation_step<4>(cloth_ensemble_structure<4>&);
+template void cloth_ensemble_simulation_step<8>(cloth_ensemble_structure<8>&);
+template void cloth_ensemble_simulation_step<16>(cloth_ensemble_structure<16>&);
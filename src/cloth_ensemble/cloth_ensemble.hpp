@@ -0,0 +1,46 @@
+#pragma once
+
+#include "cgp/cgp.hpp"
+#include "../cloth/cloth.hpp"
+#include "../constraint/constraint.hpp"
+#include "../simulation/simulation.hpp"
+
+#include <array>
+
+
+// Ensemble of N_lane variants of the same cloth simulated with different parameters (K, mu, mass, dt, wind)
+//  The variants share the resolution, the pins and the colliders. Each scalar of the state is stored for all the variants
+//  contiguously (lane-interleaved), so that the kernels process the N_lane variants of a vertex as one SIMD vector.
+//  Instantiated for N_lane = 4, 8 and 16 (one SSE, AVX or AVX-512 register of floats).
+// Restrictions with respect to the single cloth simulation (checked by assertions):
+//  - the variants share the same spring stencil (simulation_parameters::stencil), the loop over the neighbors being common to the lanes
+//  - the aerodynamic model and the turbulent wind field are not supported: the wind is the uniform force along the vertex normals
+template <int N_lane>
+struct cloth_ensemble_structure
+{
+    int N = 0; // Number of vertices along one dimension of the grid
+
+    // State of the vertices, stored as value[(3*k_vertex + k_coordinate)*N_lane + lane]
+    cgp::numarray<float> position;
+    cgp::numarray<float> velocity;
+    cgp::numarray<float> force;
+    cgp::numarray<float> normal;
+
+    // Parameters of each variant
+    std::array<simulation_parameters, N_lane> parameters;
+
+    // Pins and colliders, shared by all the variants
+    constraint_structure constraint;
+
+
+    // Start all the variants from the same cloth state, each one with its own parameters (see the restrictions above)
+    void initialize(cloth_structure const& cloth, std::array<simulation_parameters, N_lane> const& parameters);
+
+    // Copy the state of one variant in a cloth_structure of the same resolution
+    void extract(int lane, cloth_structure& cloth) const;
+};
+
+
+// One simulation step (force, integration with the time step of each variant, constraints, normals) of all the variants
+template <int N_lane>
+void cloth_ensemble_simulation_step(cloth_ensemble_structure<N_lane>& ensemble);
@@ -0,0 +1,66 @@
+#include "cgp/01_base/base.hpp"
+#include "../cloth_ensemble.hpp"
+
+#include <iostream>
+
+using namespace cgp;
+
+namespace cgp_test {
+
+	// Each lane of the ensemble follows the simulation of a single cloth with the same parameters
+	void test_cloth_ensemble()
+	{
+		int const N = 12;
+		int const N_lane = 4;
+
+		cloth_structure cloth_initial;
+		cloth_initial.initialize(N);
+
+		constraint_structure constraint;
+		constraint.add_fixed_position(0, 0, cloth_initial.position(0, 0));
+		constraint.add_fixed_position(N - 1, 0, cloth_initial.position(N - 1, 0));
+		constraint.spherical_constraints.push_back({ {0.0f,-0.4f,-0.6f}, 0.2f });
+		constraint.cylindrical_constraints.push_back({ {-0.5f,-0.7f,-0.4f}, {0.5f,-0.7f,-0.4f}, 0.1f });
+
+		// Stencil shared by the lanes
+		for (int stencil : { 24, 8 }) {
+			std::array<simulation_parameters, N_lane> parameters;
+			for (int l = 0; l < N_lane; ++l) {
+				parameters[l].K = 3.0f + 2.0f * l;
+				parameters[l].mu = 10.0f + l;
+				parameters[l].mass_total = 0.3f + 0.1f * l;
+				parameters[l].dt = 0.002f + 0.001f * l;
+				parameters[l].wind.magnitude = 2.0f * l;
+				parameters[l].wind.direction = { 0,0,1 };
+				parameters[l].stencil = stencil;
+			}
+
+			cloth_ensemble_structure<N_lane> ensemble;
+			ensemble.initialize(cloth_initial, parameters);
+			ensemble.constraint = constraint;
+
+			cloth_structure cloth[N_lane];
+			for (int l = 0; l < N_lane; ++l)
+				cloth[l] = cloth_initial;
+
+			for (int k_step = 0; k_step < 100; ++k_step) {
+				cloth_ensemble_simulation_step(ensemble);
+				for (int l = 0; l < N_lane; ++l) {
+					simulation_compute_force(cloth[l], parameters[l]);
+					simulation_numerical_integration(cloth[l], parameters[l], parameters[l].dt);
+					simulation_apply_constraints(cloth[l], constraint);
+					simulation_update_normal(cloth[l], parameters[l]);
+				}
+			}
+
+			// The lanes only differ from the single simulation by the rounding of the operations
+			for (int l = 0; l < N_lane; ++l) {
+				cloth_structure result = cloth_initial;
+				ensemble.extract(l, result);
+				for (int k = 0; k < result.position.size(); ++k)
+					assert_cgp(norm(result.position.data[k] - cloth[l].position.data[k]) < 1e-3f, "Lane " + str(l) + " with " + str(stencil) + " springs differs from the single cloth simulation at vertex " + str(k));
+			}
+		}
+	}
+
+}
@@ -0,0 +1,60 @@
+#include "cloth_lod.hpp"
+
+using namespace cgp;
+
+
+// Size in pixels of the projection of the bounding box of the cloth on screen
+//  Return a negative value if a corner of the box is behind the camera
+static float cloth_screen_size(cloth_structure const& cloth, mat4 const& camera_projection, mat4 const& camera_view, int window_width, int window_height)
+{
+    bounding_box box;
+    box.initialize(cloth.position.data);
+
+    mat4 const M = camera_projection * camera_view;
+    vec2 ndc_min = { 1e10f, 1e10f };
+    vec2 ndc_max = { -1e10f, -1e10f };
+    for (int k = 0; k < 8; ++k) {
+        vec3 const corner = { (k & 1) ? box.p_max.x : box.p_min.x, (k & 2) ? box.p_max.y : box.p_min.y, (k & 4) ? box.p_max.z : box.p_min.z };
+        vec4 const p = M * vec4(corner, 1.0f);
+        if (p.w <= 1e-4f)
+            return -1.0f;
+
+        vec2 const ndc = { p.x / p.w, p.y / p.w };
+        ndc_min = { std::min(ndc_min.x, ndc.x), std::min(ndc_min.y, ndc.y) };
+        ndc_max = { std::max(ndc_max.x, ndc.x), std::max(ndc_max.y, ndc.y) };
+    }
+
+    // Clip to the screen: the part of the cloth outside the window doesn't need to be detailed
+    ndc_min = { std::max(ndc_min.x, -1.0f), std::max(ndc_min.y, -1.0f) };
+    ndc_max = { std::min(ndc_max.x, 1.0f), std::min(ndc_max.y, 1.0f) };
+
+    float const size_x = std::max(ndc_max.x - ndc_min.x, 0.0f) * 0.5f * window_width;
+    float const size_y = std::max(ndc_max.y - ndc_min.y, 0.0f) * 0.5f * window_height;
+    return std::max(size_x, size_y);
+}
+
+int cloth_lod_structure::select_resolution(cloth_structure const& cloth, mat4 const& camera_projection, mat4 const& camera_view, int window_width, int window_height, int N_max)
+{
+    int const N_current = cloth.N_samples();
+    int const N_low = std::min(N_min, N_max);
+
+    screen_size = cloth_screen_size(cloth, camera_projection, camera_view, window_width, window_height);
+    if (screen_size < 0)
+        N_target = N_max;
+    else {
+        int const N_screen = int(std::round(screen_size / pixels_per_sample / level_step)) * level_step;
+        N_target = std::max(N_low, std::min(N_screen, N_max));
+    }
+
+    // The current resolution is out of the allowed range: switch immediately
+    if (N_current > N_max || N_current < N_low)
+        return N_target;
+
+    // Hysteresis: keep the current level while the target remains close to it
+    if (N_target > N_current * (1.0f + hysteresis) || N_target < N_current * (1.0f - hysteresis))
+        return N_target;
+    if ((N_target == N_max || N_target == N_low) && N_target != N_current && std::abs(N_target - N_current) >= level_step)
+        return N_target;
+
+    return N_current;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "cgp/cgp.hpp"
+#include "../cloth/cloth.hpp"
+
+
+// Level of detail of the cloth simulation
+//  Chooses the number of samples of the cloth from the size of its bounding box on screen.
+//  A new resolution is only selected when the target moves away from the current one by more than the hysteresis ratio.
+struct cloth_lod_structure
+{
+    bool active = false;
+    int N_min = 8;                  // Coarsest resolution of the cloth
+    float pixels_per_sample = 6.0f; // Target on-screen distance (in pixels) between two neighboring samples
+    float hysteresis = 0.25f;       // Relative change of the target resolution needed to switch level
+    int level_step = 4;             // Resolutions are rounded to a multiple of level_step (limits the number of levels)
+
+    float screen_size = 0.0f;       // Last measured size of the cloth on screen (in pixels)
+    int N_target = 0;               // Last resolution computed from the screen size (before hysteresis)
+
+    // Return the resolution the cloth should be simulated at, given its current state and the camera
+    //  N_max is the resolution used when the cloth covers a large part of the screen (or when it is behind the camera)
+    int select_resolution(cloth_structure const& cloth, cgp::mat4 const& camera_projection, cgp::mat4 const& camera_view, int window_width, int window_height, int N_max);
+};
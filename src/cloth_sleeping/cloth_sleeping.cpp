@@ -0,0 +1,238 @@
+#include "cloth_sleeping.hpp"
+
+using namespace cgp;
+
+
+void cloth_sleeping_structure::initialize(int N_samples_edge_arg)
+{
+    assert_cgp(tile_size > 0, "tile_size=" + str(tile_size) + " should be > 0");
+
+    N_samples_edge = N_samples_edge_arg;
+    int const N_tile_edge = (N_samples_edge + tile_size - 1) / tile_size;
+    N_tile = { N_tile_edge, N_tile_edge };
+
+    int const N = N_tiles();
+    awake.resize_clear(N);
+    quiet_steps.resize_clear(N);
+    box_min.resize_clear(N);
+    box_max.resize_clear(N);
+
+    previous_fixed_sample.clear();
+    previous_spheres.clear();
+    previous_cylinders.clear();
+
+    wake_all();
+}
+
+void cloth_sleeping_structure::wake_all()
+{
+    awake.fill(1);
+    quiet_steps.fill(0);
+
+    awake_tiles.clear();
+    for (int k_tile = 0; k_tile < N_tiles(); ++k_tile)
+        awake_tiles.push_back(k_tile);
+}
+
+int cloth_sleeping_structure::N_tiles() const
+{
+    return N_tile.x * N_tile.y;
+}
+
+float cloth_sleeping_structure::active_fraction() const
+{
+    if (N_tiles() == 0)
+        return 1.0f;
+    return awake_tiles.size() / static_cast<float>(N_tiles());
+}
+
+void cloth_sleeping_structure::tile_range(int k_tile, int& ku_min, int& ku_max, int& kv_min, int& kv_max) const
+{
+    int const tu = k_tile % N_tile.x;
+    int const tv = k_tile / N_tile.x;
+
+    ku_min = tu * tile_size;
+    kv_min = tv * tile_size;
+    ku_max = std::min(ku_min + tile_size, N_samples_edge);
+    kv_max = std::min(kv_min + tile_size, N_samples_edge);
+}
+
+
+// Helper functions detecting the motion of pins and colliders
+// ************************************************************ //
+
+static bool box_intersect(vec3 const& a_min, vec3 const& a_max, vec3 const& b_min, vec3 const& b_max)
+{
+    return a_min.x <= b_max.x && b_min.x <= a_max.x
+        && a_min.y <= b_max.y && b_min.y <= a_max.y
+        && a_min.z <= b_max.z && b_min.z <= a_max.z;
+}
+
+// Wake up the sleeping tiles whose bounding box intersects the box [p_min,p_max]
+static void wake_tiles_in_box(cloth_sleeping_structure& sleeping, vec3 const& p_min, vec3 const& p_max)
+{
+    for (int k_tile = 0; k_tile < sleeping.N_tiles(); ++k_tile) {
+        if (sleeping.awake[k_tile] == 0 && box_intersect(sleeping.box_min[k_tile], sleeping.box_max[k_tile], p_min, p_max)) {
+            sleeping.awake[k_tile] = 1;
+            sleeping.quiet_steps[k_tile] = 0;
+        }
+    }
+}
+
+static void wake_tiles_around_colliders(cloth_sleeping_structure& sleeping, constraint_structure const& constraint)
+{
+    float const d = sleeping.wake_distance;
+
+    for (size_t k = 0; k < constraint.spherical_constraints.size(); ++k) {
+        sphere_parameter const& sphere = constraint.spherical_constraints[k];
+        bool moved = k >= sleeping.previous_spheres.size();
+        if (!moved) {
+            sphere_parameter const& previous = sleeping.previous_spheres[k];
+            moved = norm(sphere.center - previous.center) > d || std::abs(sphere.radius - previous.radius) > d;
+        }
+
+        if (moved) {
+            vec3 const r = { sphere.radius + d, sphere.radius + d, sphere.radius + d };
+            wake_tiles_in_box(sleeping, sphere.center - r, sphere.center + r);
+        }
+    }
+
+    for (size_t k = 0; k < constraint.cylindrical_constraints.size(); ++k) {
+        cylinder_parameter const& cylinder = constraint.cylindrical_constraints[k];
+        bool moved = k >= sleeping.previous_cylinders.size();
+        if (!moved) {
+            cylinder_parameter const& previous = sleeping.previous_cylinders[k];
+            moved = norm(cylinder.positionStart - previous.positionStart) > d
+                || norm(cylinder.positionEnd - previous.positionEnd) > d
+                || std::abs(cylinder.radius - previous.radius) > d;
+        }
+
+        if (moved) {
+            vec3 const r = { cylinder.radius + d, cylinder.radius + d, cylinder.radius + d };
+            vec3 const p_min = { std::min(cylinder.positionStart.x, cylinder.positionEnd.x), std::min(cylinder.positionStart.y, cylinder.positionEnd.y), std::min(cylinder.positionStart.z, cylinder.positionEnd.z) };
+            vec3 const p_max = { std::max(cylinder.positionStart.x, cylinder.positionEnd.x), std::max(cylinder.positionStart.y, cylinder.positionEnd.y), std::max(cylinder.positionStart.z, cylinder.positionEnd.z) };
+            wake_tiles_in_box(sleeping, p_min - r, p_max + r);
+        }
+    }
+
+    sleeping.previous_spheres = constraint.spherical_constraints;
+    sleeping.previous_cylinders = constraint.cylindrical_constraints;
+}
+
+static void wake_tiles_around_pins(cloth_sleeping_structure& sleeping, constraint_structure const& constraint)
+{
+    for (auto const& it : constraint.fixed_sample) {
+        position_contraint const& c = it.second;
+        auto const previous = sleeping.previous_fixed_sample.find(it.first);
+
+        bool const moved = previous == sleeping.previous_fixed_sample.end() || norm(previous->second.position - c.position) > sleeping.wake_distance;
+        if (moved && c.ku >= 0 && c.kv >= 0 && c.ku < sleeping.N_samples_edge && c.kv < sleeping.N_samples_edge) {
+            int const k_tile = c.ku / sleeping.tile_size + sleeping.N_tile.x * (c.kv / sleeping.tile_size);
+            sleeping.awake[k_tile] = 1;
+            sleeping.quiet_steps[k_tile] = 0;
+        }
+    }
+
+    sleeping.previous_fixed_sample = constraint.fixed_sample;
+}
+
+
+void cloth_sleeping_structure::update(cloth_structure& cloth, constraint_structure const& constraint, float mass_vertex, bool varying_forces)
+{
+    if (cloth.N_samples() != N_samples_edge)
+        initialize(cloth.N_samples());
+
+    // A tile at rest under forces varying over time would not be at rest at the next step
+    if (active == false || varying_forces) {
+        if (awake_tiles.size() != N_tiles())
+            wake_all();
+        quiet_steps.fill(0);
+        return;
+    }
+
+    wake_tiles_around_pins(*this, constraint);
+    wake_tiles_around_colliders(*this, constraint);
+
+    // Measure the kinetic energy of the tiles that were simulated during this step
+    numarray<float> energy;
+    energy.resize_clear(N_tiles());
+    for (int k_tile : awake_tiles) {
+        int ku_min, ku_max, kv_min, kv_max;
+        tile_range(k_tile, ku_min, ku_max, kv_min, kv_max);
+        for (int kv = kv_min; kv < kv_max; ++kv)
+            for (int ku = ku_min; ku < ku_max; ++ku)
+                energy[k_tile] += 0.5f * mass_vertex * dot(cloth.velocity(ku, kv), cloth.velocity(ku, kv));
+    }
+
+    // The velocity of a pinned vertex is not meaningful (its position is overwritten at each step): remove it from the measure
+    for (auto const& it : constraint.fixed_sample) {
+        position_contraint const& c = it.second;
+        if (c.ku >= 0 && c.kv >= 0 && c.ku < N_samples_edge && c.kv < N_samples_edge) {
+            int const k_tile = c.ku / tile_size + N_tile.x * (c.kv / tile_size);
+            energy[k_tile] -= 0.5f * mass_vertex * dot(cloth.velocity(c.ku, c.kv), cloth.velocity(c.ku, c.kv));
+        }
+    }
+
+    numarray<int> energetic;
+    energetic.resize_clear(N_tiles());
+    for (int k_tile : awake_tiles) {
+        int ku_min, ku_max, kv_min, kv_max;
+        tile_range(k_tile, ku_min, ku_max, kv_min, kv_max);
+
+        float const energy_mean = energy[k_tile] / static_cast<float>((ku_max - ku_min) * (kv_max - kv_min));
+        if (energy_mean > energy_threshold) {
+            energetic[k_tile] = 1;
+            quiet_steps[k_tile] = 0;
+        }
+        else
+            quiet_steps[k_tile]++;
+    }
+
+    // A moving tile pulls on its neighbors through the springs: wake them up
+    for (int k_tile = 0; k_tile < N_tiles(); ++k_tile) {
+        if (energetic[k_tile] == 0)
+            continue;
+        int const tu = k_tile % N_tile.x;
+        int const tv = k_tile / N_tile.x;
+        for (int dv = -1; dv <= 1; ++dv) {
+            for (int du = -1; du <= 1; ++du) {
+                int const tu_n = tu + du;
+                int const tv_n = tv + dv;
+                if (tu_n >= 0 && tu_n < N_tile.x && tv_n >= 0 && tv_n < N_tile.y) {
+                    int const k_neighbor = tu_n + N_tile.x * tv_n;
+                    if (awake[k_neighbor] == 0) {
+                        awake[k_neighbor] = 1;
+                        quiet_steps[k_neighbor] = 0;
+                    }
+                }
+            }
+        }
+    }
+
+    // Put to sleep the tiles that remained quiet long enough, and rebuild the list of awake tiles
+    awake_tiles.clear();
+    for (int k_tile = 0; k_tile < N_tiles(); ++k_tile) {
+        if (awake[k_tile] == 1 && quiet_steps[k_tile] >= quiet_steps_to_sleep) {
+            int ku_min, ku_max, kv_min, kv_max;
+            tile_range(k_tile, ku_min, ku_max, kv_min, kv_max);
+
+            vec3 p_min = cloth.position(ku_min, kv_min);
+            vec3 p_max = p_min;
+            for (int kv = kv_min; kv < kv_max; ++kv) {
+                for (int ku = ku_min; ku < ku_max; ++ku) {
+                    vec3 const& p = cloth.position(ku, kv);
+                    p_min = { std::min(p_min.x, p.x), std::min(p_min.y, p.y), std::min(p_min.z, p.z) };
+                    p_max = { std::max(p_max.x, p.x), std::max(p_max.y, p.y), std::max(p_max.z, p.z) };
+                    cloth.velocity(ku, kv) = { 0,0,0 };
+                    cloth.force(ku, kv) = { 0,0,0 };
+                }
+            }
+            box_min[k_tile] = p_min;
+            box_max[k_tile] = p_max;
+            awake[k_tile] = 0;
+        }
+
+        if (awake[k_tile] == 1)
+            awake_tiles.push_back(k_tile);
+    }
+}
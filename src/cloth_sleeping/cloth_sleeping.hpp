@@ -0,0 +1,48 @@
+#pragma once
+
+#include "cgp/cgp.hpp"
+#include "../cloth/cloth.hpp"
+#include "../constraint/constraint.hpp"
+
+
+// Splits the cloth grid into square tiles and tracks their kinetic energy.
+//  Tiles that remain quiet long enough are put to sleep: the simulation skips their force, integration and collision work.
+//  A sleeping tile is woken up when a neighboring tile moves, or when a pin or a collider close to it moves.
+//  A change of the forces (wind, stiffness, mass, etc.) is not detected: the caller wakes up the cloth with wake_all().
+struct cloth_sleeping_structure
+{
+    bool active = true;              // Sleeping enabled (all tiles are kept awake otherwise)
+    int tile_size = 8;               // Number of vertices along one edge of a tile
+    float energy_threshold = 1e-7f;  // Mean kinetic energy per vertex under which a tile is considered quiet
+    float wake_distance = 1e-3f;     // Displacement of a pin or a collider above which the tiles around it are woken up
+    int quiet_steps_to_sleep = 60;   // Number of consecutive quiet steps before a tile falls asleep
+
+    int N_samples_edge = 0;           // Number of vertices along one dimension of the cloth grid
+    cgp::int2 N_tile;                 // Number of tiles along each dimension of the grid
+    cgp::numarray<int> awake;         // awake[k_tile] = 1 if the tile is simulated, 0 if it is sleeping
+    cgp::numarray<int> quiet_steps;   // Number of consecutive quiet steps of each tile
+    cgp::numarray<cgp::vec3> box_min; // Bounding box of each tile, stored when it falls asleep
+    cgp::numarray<cgp::vec3> box_max;
+    cgp::numarray<int> awake_tiles;   // Indices of the awake tiles - the list traversed by the simulation loops
+
+    // Pins and colliders seen at the previous update (used to detect their motion)
+    std::map<size_t, position_contraint> previous_fixed_sample;
+    std::vector<sphere_parameter> previous_spheres;
+    std::vector<cylinder_parameter> previous_cylinders;
+
+
+    void initialize(int N_samples_edge); // Allocate the tiles of a cloth with N_samples_edge^2 vertices (all awake)
+    void wake_all();                     // Wake up every tile of the cloth
+
+    // Update the sleeping state after a simulation step
+    //  - Wake up the tiles around moving pins/colliders and around energetic tiles
+    //  - Put to sleep the tiles that have been quiet for quiet_steps_to_sleep steps (their velocity is set to zero)
+    //  With forces varying over time (ex. turbulent wind), all the tiles are kept awake.
+    void update(cloth_structure& cloth, constraint_structure const& constraint, float mass_vertex, bool varying_forces = false);
+
+    // Range of vertices [ku_min,ku_max[ x [kv_min,kv_max[ covered by the tile of index k_tile
+    void tile_range(int k_tile, int& ku_min, int& ku_max, int& kv_min, int& kv_max) const;
+
+    int N_tiles() const;           // Total number of tiles
+    float active_fraction() const; // Ratio of awake tiles in [0,1]
+};
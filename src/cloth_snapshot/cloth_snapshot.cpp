@@ -0,0 +1,214 @@
+#include "cloth_snapshot.hpp"
+#include "../mapped_file/mapped_file.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+using namespace cgp;
+
+
+// Fixed-size header at the beginning of the file
+struct cloth_snapshot_header
+{
+    char magic[4];
+    uint32_t version;
+    int32_t N_samples_edge;
+    int32_t N_pin;
+
+    float dt;
+    float mass_total;
+    float K;
+    float mu;
+    int32_t stencil;
+    float wind_magnitude;
+    float wind_direction[3];
+
+    int32_t wind_field_active;
+    float turbulence;
+    float scale;
+    float scroll_speed;
+    float update_rate_hz;
+    int32_t N_cell;
+    float margin;
+    float wind_field_time;
+    float wind_field_alpha;
+    int32_t wind_field_keyframes; // 1 if the keyframes below were evaluated
+    float keyframe_p_min[2][3];   // previous, next
+    float keyframe_p_max[2][3];
+    float keyframe_time[2];
+
+    int32_t aerodynamics_active;
+    float air_density;
+    float drag;
+    float lift;
+};
+
+// A pinned vertex as stored in the file
+struct cloth_snapshot_pin
+{
+    int32_t ku;
+    int32_t kv;
+    float position[3];
+};
+
+static char const snapshot_magic[4] = { 'C','A','P','E' };
+
+static size_t snapshot_size(int N_samples_edge, int N_pin)
+{
+    size_t const N_vertex = size_t(N_samples_edge) * size_t(N_samples_edge);
+    return sizeof(cloth_snapshot_header) + 2 * N_vertex * sizeof(vec3) + size_t(N_pin) * sizeof(cloth_snapshot_pin);
+}
+
+
+bool cloth_snapshot_save(std::string const& filename, cloth_structure const& cloth, constraint_structure const& constraint, simulation_parameters const& parameters)
+{
+    static_assert(sizeof(vec3) == 3 * sizeof(float), "vec3 is expected to be stored as 3 contiguous floats");
+
+    std::ofstream stream(filename, std::ios::binary);
+    if (!stream.is_open()) {
+        std::cout << "Warning: cannot write the cloth snapshot " << filename << std::endl;
+        return false;
+    }
+
+    cloth_snapshot_header header;
+    std::memcpy(header.magic, snapshot_magic, 4);
+    header.version = cloth_snapshot_version;
+    header.N_samples_edge = cloth.N_samples();
+    header.N_pin = static_cast<int32_t>(constraint.fixed_sample.size());
+    header.dt = parameters.dt;
+    header.mass_total = parameters.mass_total;
+    header.K = parameters.K;
+    header.mu = parameters.mu;
+    header.stencil = parameters.stencil;
+    header.wind_magnitude = parameters.wind.magnitude;
+    for (int k = 0; k < 3; ++k)
+        header.wind_direction[k] = parameters.wind.direction[k];
+
+    wind_field_structure const& field = parameters.wind.field;
+    header.wind_field_active = field.active ? 1 : 0;
+    header.turbulence = field.turbulence;
+    header.scale = field.scale;
+    header.scroll_speed = field.scroll_speed;
+    header.update_rate_hz = field.update_rate_hz;
+    header.N_cell = field.N_cell;
+    header.margin = field.margin;
+    header.wind_field_time = field.time;
+    header.wind_field_alpha = field.alpha;
+    header.wind_field_keyframes = field.next.value.dimension.x == field.N_cell ? 1 : 0;
+    wind_field_structure::keyframe const* keyframes[2] = { &field.previous, &field.next };
+    for (int k_key = 0; k_key < 2; ++k_key) {
+        for (int k = 0; k < 3; ++k) {
+            header.keyframe_p_min[k_key][k] = keyframes[k_key]->p_min[k];
+            header.keyframe_p_max[k_key][k] = keyframes[k_key]->p_max[k];
+        }
+        header.keyframe_time[k_key] = keyframes[k_key]->time;
+    }
+
+    header.aerodynamics_active = parameters.aerodynamics.active ? 1 : 0;
+    header.air_density = parameters.aerodynamics.air_density;
+    header.drag = parameters.aerodynamics.drag;
+    header.lift = parameters.aerodynamics.lift;
+
+    stream.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<char const*>(cloth.position.data.data.data()), cloth.position.size() * sizeof(vec3));
+    stream.write(reinterpret_cast<char const*>(cloth.velocity.data.data.data()), cloth.velocity.size() * sizeof(vec3));
+    for (auto const& it : constraint.fixed_sample) {
+        position_contraint const& c = it.second;
+        cloth_snapshot_pin const pin = { c.ku, c.kv, { c.position.x, c.position.y, c.position.z } };
+        stream.write(reinterpret_cast<char const*>(&pin), sizeof(pin));
+    }
+
+    return stream.good();
+}
+
+bool cloth_snapshot_load(std::string const& filename, cloth_structure& cloth, constraint_structure& constraint, simulation_parameters& parameters)
+{
+    mapped_file_structure file;
+    if (file.open(filename) == false)
+        return false;
+
+    // Check the header before touching the cloth
+    cloth_snapshot_header header;
+    if (file.size < sizeof(header)) {
+        std::cout << "Warning: " << filename << " is not a cloth snapshot" << std::endl;
+        return false;
+    }
+    std::memcpy(&header, file.data, sizeof(header));
+    if (std::memcmp(header.magic, snapshot_magic, 4) != 0 || header.N_samples_edge <= 3 || header.N_pin < 0) {
+        std::cout << "Warning: " << filename << " is not a cloth snapshot" << std::endl;
+        return false;
+    }
+    if (header.version != cloth_snapshot_version) {
+        std::cout << "Warning: cloth snapshot " << filename << " has version " << header.version << " (expected " << cloth_snapshot_version << ")" << std::endl;
+        return false;
+    }
+    if (header.stencil != 4 && header.stencil != 8 && header.stencil != 12 && header.stencil != 24) {
+        std::cout << "Warning: cloth snapshot " << filename << " has an invalid spring stencil " << header.stencil << std::endl;
+        return false;
+    }
+    if (header.N_cell < 2 || header.update_rate_hz <= 0) {
+        std::cout << "Warning: cloth snapshot " << filename << " has an invalid wind field (N_cell=" << header.N_cell << ", update rate " << header.update_rate_hz << ")" << std::endl;
+        return false;
+    }
+    if (file.size != snapshot_size(header.N_samples_edge, header.N_pin)) {
+        std::cout << "Warning: cloth snapshot " << filename << " is truncated" << std::endl;
+        return false;
+    }
+
+    int const N = header.N_samples_edge;
+    size_t const N_bytes_grid = size_t(N) * size_t(N) * sizeof(vec3);
+    char const* cursor = file.data + sizeof(header);
+
+    cloth.initialize(N);
+    std::memcpy(cloth.position.data.data.data(), cursor, N_bytes_grid);
+    cursor += N_bytes_grid;
+    std::memcpy(cloth.velocity.data.data.data(), cursor, N_bytes_grid);
+    cursor += N_bytes_grid;
+    cloth.force.fill({ 0,0,0 });
+    cloth.update_normal();
+
+    constraint.fixed_sample.clear();
+    for (int k = 0; k < header.N_pin; ++k) {
+        cloth_snapshot_pin pin;
+        std::memcpy(&pin, cursor, sizeof(pin));
+        cursor += sizeof(pin);
+        constraint.add_fixed_position(pin.ku, pin.kv, { pin.position[0], pin.position[1], pin.position[2] });
+    }
+
+    parameters.dt = header.dt;
+    parameters.mass_total = header.mass_total;
+    parameters.K = header.K;
+    parameters.mu = header.mu;
+    parameters.stencil = header.stencil;
+    parameters.wind.magnitude = header.wind_magnitude;
+    parameters.wind.direction = { header.wind_direction[0], header.wind_direction[1], header.wind_direction[2] };
+
+    wind_field_structure& field = parameters.wind.field;
+    field.active = header.wind_field_active != 0;
+    field.turbulence = header.turbulence;
+    field.scale = header.scale;
+    field.scroll_speed = header.scroll_speed;
+    field.update_rate_hz = header.update_rate_hz;
+    field.N_cell = header.N_cell;
+    field.margin = header.margin;
+    field.time = header.wind_field_time;
+    field.alpha = header.wind_field_alpha;
+    field.previous = wind_field_structure::keyframe();
+    field.next = wind_field_structure::keyframe();
+    if (header.wind_field_keyframes != 0) {
+        wind_field_structure::keyframe* keyframes[2] = { &field.previous, &field.next };
+        for (int k_key = 0; k_key < 2; ++k_key) {
+            keyframes[k_key]->p_min = { header.keyframe_p_min[k_key][0], header.keyframe_p_min[k_key][1], header.keyframe_p_min[k_key][2] };
+            keyframes[k_key]->p_max = { header.keyframe_p_max[k_key][0], header.keyframe_p_max[k_key][1], header.keyframe_p_max[k_key][2] };
+            keyframes[k_key]->time = header.keyframe_time[k_key];
+        }
+        field.evaluate_keyframes(parameters.wind.magnitude * parameters.wind.direction);
+    }
+
+    parameters.aerodynamics.active = header.aerodynamics_active != 0;
+    parameters.aerodynamics.air_density = header.air_density;
+    parameters.aerodynamics.drag = header.drag;
+    parameters.aerodynamics.lift = header.lift;
+
+    return true;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "cgp/cgp.hpp"
+#include "../cloth/cloth.hpp"
+#include "../constraint/constraint.hpp"
+#include "../simulation/simulation.hpp"
+
+
+// Binary snapshot of the full state of a cloth simulation: position, velocity, pins and simulation parameters.
+//  Used to warm-start the cape from a pre-settled drape, or to resume the simulation at a given frame.
+//
+// File layout (little endian, 4-byte fields)
+//  - header: "CAPE", version, N_samples_edge, number of pins,
+//      simulation parameters (dt, mass_total, K, mu, stencil, wind magnitude, wind direction,
+//      turbulent wind field: active, turbulence, scale, scroll speed, update rate, N_cell, margin, time, alpha, keyframes stored (0/1),
+//      box and time of the previous and next keyframes, aerodynamics: active, air density, drag, lift)
+//  - position: N_samples_edge^2 vec3 in the order of the grid_2D storage
+//  - velocity: N_samples_edge^2 vec3
+//  - pins: (ku, kv, position) for each pin
+//  The values of the keyframes of the wind field are evaluated again when the snapshot is read: a turbulent run resumes with the same wind.
+int const cloth_snapshot_version = 4; // 2: spring stencil, 3: turbulent wind field, 4: aerodynamic model
+
+// Write the snapshot in a file, returns false if the file cannot be written
+bool cloth_snapshot_save(std::string const& filename, cloth_structure const& cloth, constraint_structure const& constraint, simulation_parameters const& parameters);
+
+// Read a snapshot written by cloth_snapshot_save. The file is memory-mapped and copied directly in the cloth buffers.
+//  The pins replace the fixed positions of the constraint (the colliders are kept).
+//  Returns false, and leaves the arguments unchanged, if the file is missing or is not a valid snapshot of the current version.
+bool cloth_snapshot_load(std::string const& filename, cloth_structure& cloth, constraint_structure& constraint, simulation_parameters& parameters);
@@ -0,0 +1,95 @@
+#include "cgp/01_base/base.hpp"
+#include "../cloth_snapshot.hpp"
+
+#include <cstdio>
+#include <iostream>
+
+using namespace cgp;
+
+namespace cgp_test {
+
+	void test_cloth_snapshot()
+	{
+		std::string const filename = "test_cloth_snapshot.cape";
+
+		// A cloth in an arbitrary (non flat) state
+		cloth_structure cloth;
+		cloth.initialize(12);
+		for (int k = 0; k < cloth.position.size(); ++k) {
+			cloth.position.data[k] += vec3{ 0.01f * k, 0, -0.02f * k };
+			cloth.velocity.data[k] = vec3{ 0.5f, -0.25f * k, 1.0f / (k + 1) };
+		}
+		constraint_structure constraint;
+		constraint.add_fixed_position(0, 0, { 1,2,3 });
+		constraint.add_fixed_position(11, 0, { -1,0.5f,2 });
+		simulation_parameters parameters;
+		parameters.K = 12.5f;
+		parameters.wind.magnitude = 3.0f;
+		parameters.wind.direction = { 0,0,1 };
+		parameters.stencil = 8;
+		parameters.aerodynamics.active = true;
+		parameters.aerodynamics.drag = 1.5f;
+		parameters.aerodynamics.lift = 0.25f;
+
+		// Turbulent wind in the middle of a run
+		wind_field_structure& field = parameters.wind.field;
+		field.active = true;
+		field.turbulence = 0.9f;
+		field.scale = 0.3f;
+		field.N_cell = 6;
+		for (int k_update = 0; k_update < 7; ++k_update)
+			field.update(0.07f, parameters.wind.magnitude * parameters.wind.direction, { -0.5f,-1,-0.5f }, { 0.5f + 0.1f * k_update,0,0.5f });
+
+		assert_cgp_no_msg(cloth_snapshot_save(filename, cloth, constraint, parameters));
+
+		// Round trip: the state is restored exactly
+		{
+			cloth_structure cloth_loaded;
+			cloth_loaded.initialize(4);
+			constraint_structure constraint_loaded;
+			simulation_parameters parameters_loaded;
+			assert_cgp_no_msg(cloth_snapshot_load(filename, cloth_loaded, constraint_loaded, parameters_loaded));
+
+			assert_cgp_no_msg(cloth_loaded.N_samples() == 12);
+			for (int k = 0; k < cloth.position.size(); ++k) {
+				assert_cgp_no_msg(is_equal(cloth_loaded.position.data[k], cloth.position.data[k]));
+				assert_cgp_no_msg(is_equal(cloth_loaded.velocity.data[k], cloth.velocity.data[k]));
+			}
+			assert_cgp_no_msg(constraint_loaded.fixed_sample.size() == 2);
+			for (auto const& it : constraint.fixed_sample) {
+				position_contraint const& c = constraint_loaded.fixed_sample.at(it.first);
+				assert_cgp_no_msg(c.ku == it.second.ku && c.kv == it.second.kv && is_equal(c.position, it.second.position));
+			}
+			assert_cgp_no_msg(parameters_loaded.K == 12.5f);
+			assert_cgp_no_msg(parameters_loaded.wind.magnitude == 3.0f);
+			assert_cgp_no_msg(is_equal(parameters_loaded.wind.direction, vec3{ 0,0,1 }));
+			assert_cgp_no_msg(parameters_loaded.stencil == 8);
+			assert_cgp_no_msg(parameters_loaded.aerodynamics.active && parameters_loaded.aerodynamics.drag == 1.5f && parameters_loaded.aerodynamics.lift == 0.25f);
+			assert_cgp_no_msg(parameters_loaded.aerodynamics.air_density == parameters.aerodynamics.air_density);
+
+			// The restored wind field gives the same wind, now and at the next keyframes
+			wind_field_structure& field_loaded = parameters_loaded.wind.field;
+			assert_cgp_no_msg(field_loaded.active && field_loaded.turbulence == 0.9f && field_loaded.scale == 0.3f && field_loaded.N_cell == 6);
+			wind_field_structure field_continued = field;
+			for (int k_update = 0; k_update < 5; ++k_update) {
+				for (vec3 const& p : { vec3{ 0,0,0 }, vec3{ 0.3f,-0.6f,0.2f }, cloth.position.data[5] })
+					assert_cgp_no_msg(is_equal(field_loaded.sample(p), field_continued.sample(p)));
+				field_loaded.update(0.07f, parameters.wind.magnitude * parameters.wind.direction, { -0.5f,-1,-0.5f }, { 0.5f,0,0.5f });
+				field_continued.update(0.07f, parameters.wind.magnitude * parameters.wind.direction, { -0.5f,-1,-0.5f }, { 0.5f,0,0.5f });
+			}
+		}
+
+		// A missing file leaves the state unchanged
+		{
+			cloth_structure cloth_loaded;
+			cloth_loaded.initialize(4);
+			constraint_structure constraint_loaded;
+			simulation_parameters parameters_loaded;
+			assert_cgp_no_msg(cloth_snapshot_load("missing_file.cape", cloth_loaded, constraint_loaded, parameters_loaded) == false);
+			assert_cgp_no_msg(cloth_loaded.N_samples() == 4);
+		}
+
+		std::remove(filename.c_str());
+	}
+
+}
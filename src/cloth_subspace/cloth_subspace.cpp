@@ -0,0 +1,616 @@
+#include "cloth_subspace.hpp"
+#include "../mapped_file/mapped_file.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+using namespace cgp;
+
+
+float const* cloth_subspace_basis::mode_data(int k_mode) const
+{
+    return mode.data.data() + size_t(k_mode) * mean.size();
+}
+
+int cloth_subspace_basis::N_dynamics() const
+{
+    return 2 * N_mode + cloth_subspace_N_input;
+}
+
+
+// Helper functions
+// ************************************************************ //
+
+// Eigen decomposition of the symmetric n x n matrix A (row major, overwritten) with the cyclic Jacobi method
+//  eigenvector[k*n+i] is the component i of the k-th eigenvector, the eigenvalues are sorted in decreasing order
+static void symmetric_eigen(std::vector<double>& A, int n, std::vector<double>& eigenvalue, std::vector<double>& eigenvector)
+{
+    std::vector<double> V(size_t(n) * n, 0.0); // the eigenvectors are the columns of V
+    for (int i = 0; i < n; ++i)
+        V[i * n + i] = 1.0;
+
+    double norm2 = 0.0;
+    for (double a : A)
+        norm2 += a * a;
+
+    for (int sweep = 0; sweep < 100; ++sweep)
+    {
+        double off = 0.0;
+        for (int p = 0; p < n; ++p)
+            for (int q = p + 1; q < n; ++q)
+                off += A[p * n + q] * A[p * n + q];
+        if (off <= 1e-24 * norm2)
+            break;
+
+        for (int p = 0; p < n; ++p) {
+            for (int q = p + 1; q < n; ++q) {
+                double const apq = A[p * n + q];
+                if (apq == 0.0)
+                    continue;
+
+                // Rotation in the plane (p,q) cancelling A[p,q]
+                double const theta = (A[q * n + q] - A[p * n + p]) / (2.0 * apq);
+                double const t = (theta >= 0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+                double const c = 1.0 / std::sqrt(t * t + 1.0);
+                double const s = t * c;
+
+                for (int k = 0; k < n; ++k) {
+                    double const akp = A[k * n + p], akq = A[k * n + q];
+                    A[k * n + p] = c * akp - s * akq;
+                    A[k * n + q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < n; ++k) {
+                    double const apk = A[p * n + k], aqk = A[q * n + k];
+                    A[p * n + k] = c * apk - s * aqk;
+                    A[q * n + k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < n; ++k) {
+                    double const vkp = V[k * n + p], vkq = V[k * n + q];
+                    V[k * n + p] = c * vkp - s * vkq;
+                    V[k * n + q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+
+    std::vector<int> order(n);
+    for (int k = 0; k < n; ++k)
+        order[k] = k;
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return A[a * n + a] > A[b * n + b]; });
+
+    eigenvalue.resize(n);
+    eigenvector.resize(size_t(n) * n);
+    for (int k = 0; k < n; ++k) {
+        eigenvalue[k] = A[order[k] * n + order[k]];
+        for (int i = 0; i < n; ++i)
+            eigenvector[k * n + i] = V[i * n + order[k]];
+    }
+}
+
+// Coordinates of a vector, and of a point, in the body frame
+static vec3 to_local_vector(vec3 const& d, vec3 const& e_x, vec3 const& e_y, vec3 const& e_z)
+{
+    return { dot(d, e_x), dot(d, e_y), dot(d, e_z) };
+}
+static vec3 to_local(vec3 const& p, vec3 const& origin, vec3 const& e_x, vec3 const& e_y, vec3 const& e_z)
+{
+    return to_local_vector(p - origin, e_x, e_y, e_z);
+}
+
+// Accumulate the sample x -> y in the normal equations of a least squares fit
+static void add_sample(std::vector<double>& XtX, std::vector<double>& XtY, std::vector<double> const& x, std::vector<double> const& y)
+{
+    int const N_x = static_cast<int>(x.size());
+    int const N_y = static_cast<int>(y.size());
+    for (int a = 0; a < N_x; ++a) {
+        for (int b = 0; b < N_x; ++b)
+            XtX[a * N_x + b] += x[a] * x[b];
+        for (int i = 0; i < N_y; ++i)
+            XtY[a * N_y + i] += x[a] * y[i];
+    }
+}
+
+// Growth rate per step of the free dynamics q(t+dt) = A1 q(t) + A2 q(t-dt): spectral radius of its companion matrix, estimated by power iteration
+static double dynamics_spectral_radius(std::vector<double> const& W, int r, int N_dynamics)
+{
+    std::vector<double> z(2 * r), z_next(2 * r);
+    for (int k = 0; k < 2 * r; ++k)
+        z[k] = 1.0 + 0.1 * k;
+
+    int const N_iteration = 400;
+    int const N_skip = 100;
+    double log_growth = 0.0;
+    for (int iteration = 0; iteration < N_iteration; ++iteration) {
+        for (int i = 0; i < r; ++i) {
+            double sum = 0.0;
+            for (int j = 0; j < 2 * r; ++j)
+                sum += W[i * N_dynamics + j] * z[j];
+            z_next[i] = sum;
+            z_next[r + i] = z[i];
+        }
+        double n2 = 0.0;
+        for (double a : z_next)
+            n2 += a * a;
+        double const n = std::sqrt(n2);
+        if (n == 0.0)
+            return 0.0;
+        if (iteration >= N_skip)
+            log_growth += std::log(n);
+        for (int k = 0; k < 2 * r; ++k)
+            z[k] = z_next[k] / n;
+    }
+    return std::exp(log_growth / (N_iteration - N_skip));
+}
+
+
+// Fit of the dynamics from the normal equations with a Tikhonov regularization (relative to the mean diagonal of XtX)
+//  The regularization is increased while the free dynamics grows.
+static std::vector<double> solve_dynamics(std::vector<double> XtX, std::vector<double> const& XtY, int r, int N_dynamics, double regularization)
+{
+    double trace = 0.0;
+    for (int a = 0; a < N_dynamics; ++a)
+        trace += XtX[a * N_dynamics + a];
+
+    std::vector<double> eigenvalue, eigenvector;
+    symmetric_eigen(XtX, N_dynamics, eigenvalue, eigenvector);
+    std::vector<double> projection(size_t(N_dynamics) * r, 0.0); // eigenvectors^T XtY
+    for (int k = 0; k < N_dynamics; ++k)
+        for (int b = 0; b < N_dynamics; ++b)
+            for (int i = 0; i < r; ++i)
+                projection[k * r + i] += eigenvector[k * N_dynamics + b] * XtY[b * r + i];
+
+    std::vector<double> W(size_t(r) * N_dynamics);
+    double alpha = regularization * trace / N_dynamics;
+    for (int attempt = 0; attempt < 8; ++attempt, alpha *= 10.0) {
+        for (int i = 0; i < r; ++i) {
+            for (int a = 0; a < N_dynamics; ++a) {
+                double sum = 0.0;
+                for (int k = 0; k < N_dynamics; ++k)
+                    sum += eigenvector[k * N_dynamics + a] * projection[k * r + i] / (std::max(eigenvalue[k], 0.0) + alpha);
+                W[i * N_dynamics + a] = sum;
+            }
+        }
+        double const radius = dynamics_spectral_radius(W, r, N_dynamics);
+        if (radius < 1.0)
+            break;
+        std::cout << "Warning: the reduced dynamics is unstable (spectral radius " << radius << "), the regularization is increased" << std::endl;
+    }
+    return W;
+}
+
+
+// Solve A x = b (n x n, row major) by Gaussian elimination with partial pivoting, x is written in b. Returns false if A is singular.
+static bool solve_linear_system(std::vector<double>& A, std::vector<double>& b, int n)
+{
+    for (int i = 0; i < n; ++i) {
+        int pivot = i;
+        for (int k = i + 1; k < n; ++k)
+            if (std::abs(A[k * n + i]) > std::abs(A[pivot * n + i]))
+                pivot = k;
+        if (std::abs(A[pivot * n + i]) < 1e-12)
+            return false;
+        for (int j = 0; j < n; ++j)
+            std::swap(A[i * n + j], A[pivot * n + j]);
+        std::swap(b[i], b[pivot]);
+
+        for (int k = i + 1; k < n; ++k) {
+            double const f = A[k * n + i] / A[i * n + i];
+            for (int j = i; j < n; ++j)
+                A[k * n + j] -= f * A[i * n + j];
+            b[k] -= f * b[i];
+        }
+    }
+    for (int i = n - 1; i >= 0; --i) {
+        for (int j = i + 1; j < n; ++j)
+            b[i] -= A[i * n + j] * b[j];
+        b[i] /= A[i * n + i];
+    }
+    return true;
+}
+
+
+// Body inputs
+// ************************************************************ //
+
+void cloth_subspace_body::reset()
+{
+    N_previous = 0;
+}
+
+void cloth_subspace_body::update(numarray<mat4> const& joint_frames, float dt, int N_sample, float* input)
+{
+    vec3 origin, e_x, e_y, e_z;
+    cape_rig_body_frame(joint_frames, origin, e_x, e_y, e_z);
+
+    vec3 velocity = { 0,0,0 };
+    vec3 acceleration = { 0,0,0 };
+    if (N_previous >= 1)
+        velocity = (origin - origin_previous[0]) / dt;
+    if (N_previous >= 2)
+        acceleration = (origin - 2.0f * origin_previous[0] + origin_previous[1]) / (dt * dt);
+    origin_previous[1] = origin_previous[0];
+    origin_previous[0] = origin;
+    N_previous = std::min(N_previous + 1, 2);
+
+    // The scenes are Y-up (the gravity of the simulation is along -y)
+    vec3 const value[3] = { to_local_vector({ 0,1,0 }, e_x, e_y, e_z), to_local_vector(velocity, e_x, e_y, e_z), to_local_vector(acceleration, e_x, e_y, e_z) };
+    for (int k = 0; k < 3; ++k)
+        for (int c = 0; c < 3; ++c)
+            input[3 * k + c] = value[k][c];
+
+    cape_rig_update_pins(constraint, joint_frames, N_sample);
+    assert_cgp(constraint.fixed_sample.size() == cloth_subspace_N_pin, "The cape has " + str(constraint.fixed_sample.size()) + " pins, the reduced model expects " + str(cloth_subspace_N_pin));
+    std::pair<int, vec3> pin[cloth_subspace_N_pin];
+    int k_pin = 0;
+    for (auto const& it : constraint.fixed_sample)
+        pin[k_pin++] = { it.second.ku + N_sample * it.second.kv, to_local(it.second.position, origin, e_x, e_y, e_z) };
+    std::sort(pin, pin + cloth_subspace_N_pin, [](std::pair<int, vec3> const& a, std::pair<int, vec3> const& b) { return a.first < b.first; });
+    for (int k = 0; k < cloth_subspace_N_pin; ++k)
+        for (int c = 0; c < 3; ++c)
+            input[9 + 3 * k + c] = pin[k].second[c];
+
+    input[cloth_subspace_N_input - 1] = 1.0f;
+}
+
+
+// Bake
+// ************************************************************ //
+
+bool cloth_subspace_record(cape_rig_clip const& clip, simulation_parameters const& parameters, cloth_subspace_record_settings const& settings, cloth_subspace_recording& recording)
+{
+    static_assert(sizeof(vec3) == 3 * sizeof(float), "vec3 is expected to be stored as 3 contiguous floats");
+
+    int const N_sample = settings.N_sample;
+    int const N_step_frame = std::max(static_cast<int>(std::round(1.0f / (settings.fps * parameters.dt))), 1);
+    float const dt = 1.0f / (settings.fps * N_step_frame);
+    float const dt_substep = dt / settings.substeps;
+    int const N_frame = std::max(static_cast<int>(std::round(settings.duration * settings.fps)), 1);
+    int const N_step_warmup = static_cast<int>(std::ceil(settings.warmup / dt));
+
+    cloth_structure cloth;
+    cloth.initialize(N_sample);
+    constraint_structure constraint;
+    numarray<mat4> joint_frames;
+
+    auto simulate = [&](float t_start, int N_step) {
+        for (int k_step = 0; k_step < N_step; ++k_step) {
+            clip.evaluate(t_start + k_step * dt, joint_frames);
+            cape_rig_update_pins(constraint, joint_frames, N_sample);
+            cape_rig_update_colliders(constraint, joint_frames);
+            for (int k_substep = 0; k_substep < settings.substeps; ++k_substep) {
+                simulation_compute_force(cloth, parameters);
+                simulation_numerical_integration(cloth, parameters, dt_substep);
+                simulation_apply_constraints(cloth, constraint);
+                if (simulation_detect_divergence(cloth))
+                    return false;
+                simulation_update_normal(cloth, parameters);
+            }
+        }
+        return true;
+    };
+
+    clip.evaluate(0.0f, joint_frames);
+    cape_rig_update_pins(constraint, joint_frames, N_sample);
+    cape_rig_drape(cloth, constraint);
+    for (int k_step = 0; k_step < N_step_warmup; ++k_step)
+        if (!simulate(0.0f, 1))
+            return false;
+
+    cloth_subspace_body body;
+    for (int k_frame = 0; k_frame < N_frame; ++k_frame) {
+        clip.evaluate(k_frame / settings.fps, joint_frames);
+
+        numarray<float> input;
+        input.resize(cloth_subspace_N_input);
+        body.update(joint_frames, 1.0f / settings.fps, N_sample, input.data.data());
+        recording.input.push_back(input);
+
+        vec3 origin, e_x, e_y, e_z;
+        cape_rig_body_frame(joint_frames, origin, e_x, e_y, e_z);
+        numarray<float> position;
+        position.resize(3 * cloth.position.size());
+        for (int k = 0; k < cloth.position.size(); ++k) {
+            vec3 const p = to_local(cloth.position.data[k], origin, e_x, e_y, e_z);
+            for (int c = 0; c < 3; ++c)
+                position[3 * k + c] = p[c];
+        }
+        recording.position.push_back(position);
+
+        if (k_frame + 1 < N_frame && !simulate(k_frame / settings.fps, N_step_frame))
+            return false;
+    }
+    return true;
+}
+
+cloth_subspace_basis cloth_subspace_build(std::vector<cloth_subspace_recording> const& recordings, float dt, int N_sample, int N_mode, float regularization, int max_snapshots)
+{
+    int const N_value = 3 * N_sample * N_sample;
+    std::vector<numarray<float> const*> frames;
+    for (cloth_subspace_recording const& recording : recordings) {
+        assert_cgp_no_msg(recording.position.size() == recording.input.size());
+        for (numarray<float> const& position : recording.position) {
+            assert_cgp(position.size() == N_value, "The recorded frame has " + str(position.size()) + " values, expected " + str(N_value));
+            frames.push_back(&position);
+        }
+    }
+
+    // The cost of the PCA grows with the cube of the number of snapshots: keep evenly spaced frames
+    std::vector<numarray<float> const*> snapshots;
+    int const N_snapshot = std::min(static_cast<int>(frames.size()), max_snapshots);
+    for (int k = 0; k < N_snapshot; ++k)
+        snapshots.push_back(frames[size_t(k) * frames.size() / N_snapshot]);
+    assert_cgp(N_snapshot >= 2, "The PCA needs at least 2 frames (" + str(N_snapshot) + " recorded)");
+
+    cloth_subspace_basis basis;
+    basis.N_sample = N_sample;
+    basis.dt = dt;
+
+    // Mean shape
+    std::vector<double> mean(N_value, 0.0);
+    for (numarray<float> const* snapshot : snapshots)
+        for (int k = 0; k < N_value; ++k)
+            mean[k] += (*snapshot)[k];
+    basis.mean.resize(N_value);
+    for (int k = 0; k < N_value; ++k) {
+        mean[k] /= N_snapshot;
+        basis.mean[k] = static_cast<float>(mean[k]);
+    }
+
+    // PCA from the eigenvectors of the Gram matrix of the centered snapshots (N_snapshot x N_snapshot, smaller than the covariance)
+    std::vector<double> gram(size_t(N_snapshot) * N_snapshot);
+#pragma omp parallel for schedule(dynamic)
+    for (int a = 0; a < N_snapshot; ++a) {
+        for (int b = a; b < N_snapshot; ++b) {
+            double sum = 0.0;
+            for (int k = 0; k < N_value; ++k)
+                sum += ((*snapshots[a])[k] - mean[k]) * ((*snapshots[b])[k] - mean[k]);
+            gram[a * N_snapshot + b] = sum;
+            gram[b * N_snapshot + a] = sum;
+        }
+    }
+    std::vector<double> lambda, w;
+    symmetric_eigen(gram, N_snapshot, lambda, w);
+
+    double const lambda_min = 1e-9 * std::max(lambda[0], 1e-30);
+    while (basis.N_mode < std::min(N_mode, N_snapshot) && lambda[basis.N_mode] > lambda_min)
+        basis.N_mode++;
+    int const r = basis.N_mode;
+
+    // mode_i = sum_a w_i[a] (snapshot_a - mean) / sqrt(lambda_i), orthonormalized again against the rounding errors
+    std::vector<double> mode(size_t(r) * N_value, 0.0);
+    for (int i = 0; i < r; ++i) {
+        double* u = &mode[size_t(i) * N_value];
+        for (int a = 0; a < N_snapshot; ++a) {
+            double const weight = w[a + size_t(i) * N_snapshot] / std::sqrt(lambda[i]);
+            for (int k = 0; k < N_value; ++k)
+                u[k] += weight * ((*snapshots[a])[k] - mean[k]);
+        }
+        for (int j = 0; j < i; ++j) {
+            double const* u_j = &mode[size_t(j) * N_value];
+            double d = 0.0;
+            for (int k = 0; k < N_value; ++k)
+                d += u[k] * u_j[k];
+            for (int k = 0; k < N_value; ++k)
+                u[k] -= d * u_j[k];
+        }
+        double n2 = 0.0;
+        for (int k = 0; k < N_value; ++k)
+            n2 += u[k] * u[k];
+        for (int k = 0; k < N_value; ++k)
+            u[k] /= std::sqrt(n2);
+    }
+    basis.mode.resize(size_t(r) * N_value);
+    basis.variance.resize(r);
+    for (int i = 0; i < r; ++i) {
+        basis.variance[i] = static_cast<float>(lambda[i] / N_snapshot);
+        for (int k = 0; k < N_value; ++k)
+            basis.mode[size_t(i) * N_value + k] = static_cast<float>(mode[size_t(i) * N_value + k]);
+    }
+
+    // Normal equations of the fit q(t+dt) = [q(t), q(t-dt), input(t+dt)] W over the consecutive frames of each recording
+    int const N_dynamics = basis.N_dynamics();
+    std::vector<double> XtX(size_t(N_dynamics) * N_dynamics, 0.0);
+    std::vector<double> XtY(size_t(N_dynamics) * r, 0.0);
+    std::vector<double> x(N_dynamics);
+    for (cloth_subspace_recording const& recording : recordings) {
+        std::vector<std::vector<double>> q(recording.position.size(), std::vector<double>(r));
+#pragma omp parallel for
+        for (int k_frame = 0; k_frame < int(recording.position.size()); ++k_frame) {
+            for (int i = 0; i < r; ++i) {
+                double sum = 0.0;
+                for (int k = 0; k < N_value; ++k)
+                    sum += (recording.position[k_frame][k] - mean[k]) * mode[size_t(i) * N_value + k];
+                q[k_frame][i] = sum;
+            }
+        }
+
+        for (size_t k_frame = 2; k_frame < recording.position.size(); ++k_frame) {
+            for (int i = 0; i < r; ++i) {
+                x[i] = q[k_frame - 1][i];
+                x[r + i] = q[k_frame - 2][i];
+            }
+            for (int k = 0; k < cloth_subspace_N_input; ++k)
+                x[2 * r + k] = recording.input[k_frame][k];
+            add_sample(XtX, XtY, x, q[k_frame]);
+        }
+    }
+    std::vector<double> const W = solve_dynamics(XtX, XtY, r, N_dynamics, regularization);
+
+    basis.dynamics.resize(W.size());
+    for (size_t k = 0; k < W.size(); ++k)
+        basis.dynamics[k] = static_cast<float>(W[k]);
+
+    return basis;
+}
+
+
+// File
+// ************************************************************ //
+
+// Fixed-size header at the beginning of the file
+struct cloth_subspace_header
+{
+    char magic[4];
+    uint32_t version;
+    int32_t N_sample;
+    int32_t N_mode;
+    int32_t N_input;
+    float dt;
+};
+
+static char const subspace_magic[4] = { 'C','S','U','B' };
+
+static size_t subspace_size(int N_sample, int N_mode, int N_input)
+{
+    size_t const N_value = 3 * size_t(N_sample) * size_t(N_sample);
+    return sizeof(cloth_subspace_header) + (N_value * (1 + size_t(N_mode)) + size_t(N_mode) * (1 + 2 * size_t(N_mode) + N_input)) * sizeof(float);
+}
+
+bool cloth_subspace_save(std::string const& filename, cloth_subspace_basis const& basis)
+{
+    std::ofstream stream(filename, std::ios::binary);
+    if (!stream.is_open()) {
+        std::cout << "Warning: cannot write the cloth subspace " << filename << std::endl;
+        return false;
+    }
+
+    cloth_subspace_header header;
+    std::memcpy(header.magic, subspace_magic, 4);
+    header.version = cloth_subspace_version;
+    header.N_sample = basis.N_sample;
+    header.N_mode = basis.N_mode;
+    header.N_input = cloth_subspace_N_input;
+    header.dt = basis.dt;
+
+    stream.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    for (numarray<float> const* array : { &basis.mean, &basis.mode, &basis.variance, &basis.dynamics })
+        stream.write(reinterpret_cast<char const*>(array->data.data()), array->size() * sizeof(float));
+
+    return stream.good();
+}
+
+bool cloth_subspace_load(std::string const& filename, cloth_subspace_basis& basis)
+{
+    mapped_file_structure file;
+    if (file.open(filename) == false)
+        return false;
+
+    cloth_subspace_header header;
+    if (file.size < sizeof(header)) {
+        std::cout << "Warning: " << filename << " is not a cloth subspace" << std::endl;
+        return false;
+    }
+    std::memcpy(&header, file.data, sizeof(header));
+    if (std::memcmp(header.magic, subspace_magic, 4) != 0 || header.N_sample <= 3 || header.N_mode < 0 || header.dt <= 0) {
+        std::cout << "Warning: " << filename << " is not a cloth subspace" << std::endl;
+        return false;
+    }
+    if (header.version != cloth_subspace_version || header.N_input != cloth_subspace_N_input) {
+        std::cout << "Warning: cloth subspace " << filename << " has version " << header.version << " with " << header.N_input << " inputs (expected "
+            << cloth_subspace_version << " with " << cloth_subspace_N_input << ")" << std::endl;
+        return false;
+    }
+    if (file.size != subspace_size(header.N_sample, header.N_mode, header.N_input)) {
+        std::cout << "Warning: cloth subspace " << filename << " is truncated" << std::endl;
+        return false;
+    }
+
+    size_t const N_value = 3 * size_t(header.N_sample) * size_t(header.N_sample);
+    basis.N_sample = header.N_sample;
+    basis.N_mode = header.N_mode;
+    basis.dt = header.dt;
+    basis.mean.resize(N_value);
+    basis.mode.resize(N_value * header.N_mode);
+    basis.variance.resize(header.N_mode);
+    basis.dynamics.resize(size_t(header.N_mode) * basis.N_dynamics());
+
+    char const* cursor = file.data + sizeof(header);
+    for (numarray<float>* array : { &basis.mean, &basis.mode, &basis.variance, &basis.dynamics }) {
+        std::memcpy(array->data.data(), cursor, array->size() * sizeof(float));
+        cursor += array->size() * sizeof(float);
+    }
+
+    return true;
+}
+
+
+// Runtime
+// ************************************************************ //
+
+void cloth_subspace_state::initialize(cloth_subspace_basis const& basis, numarray<mat4> const& joint_frames)
+{
+    int const r = basis.N_mode;
+    int const N_dynamics = basis.N_dynamics();
+    q.resize_clear(r);
+    q_previous.resize_clear(r);
+    x.resize_clear(N_dynamics);
+    body.reset();
+
+    // Equilibrium of the dynamics for the body at rest in this pose: (Id - A1 - A2) q = B input
+    std::vector<double> A(size_t(r) * r), b(r);
+    std::vector<float> input(cloth_subspace_N_input);
+    body.update(joint_frames, basis.dt, basis.N_sample, input.data());
+    body.reset();
+    for (int i = 0; i < r; ++i) {
+        float const* W_i = basis.dynamics.data.data() + size_t(i) * N_dynamics;
+        for (int j = 0; j < r; ++j)
+            A[i * r + j] = (i == j ? 1.0 : 0.0) - W_i[j] - W_i[r + j];
+        b[i] = 0.0;
+        for (int k = 0; k < cloth_subspace_N_input; ++k)
+            b[i] += W_i[2 * r + k] * input[k];
+    }
+    if (solve_linear_system(A, b, r)) {
+        for (int i = 0; i < r; ++i) {
+            q[i] = static_cast<float>(b[i]);
+            q_previous[i] = q[i];
+        }
+    }
+}
+
+void cloth_subspace_step(cloth_subspace_state& state, cloth_subspace_basis const& basis, numarray<mat4> const& joint_frames)
+{
+    int const r = basis.N_mode;
+    int const N_dynamics = basis.N_dynamics();
+    assert_cgp(state.q.size() == r && state.x.size() == N_dynamics, "The state has " + str(state.q.size()) + " coordinates, the basis " + str(r) + " modes");
+
+    float* x = state.x.data.data();
+    std::memcpy(x, state.q.data.data(), r * sizeof(float));
+    std::memcpy(x + r, state.q_previous.data.data(), r * sizeof(float));
+    state.body.update(joint_frames, basis.dt, basis.N_sample, x + 2 * r);
+
+    state.q_previous = state.q;
+    float const* W = basis.dynamics.data.data();
+    for (int i = 0; i < r; ++i) {
+        float const* W_i = W + size_t(i) * N_dynamics;
+        float sum = 0.0f;
+#pragma omp simd reduction(+:sum)
+        for (int k = 0; k < N_dynamics; ++k)
+            sum += W_i[k] * x[k];
+        state.q[i] = sum;
+    }
+}
+
+void cloth_subspace_reconstruct(cloth_subspace_state const& state, cloth_subspace_basis const& basis, numarray<mat4> const& joint_frames, grid_2D<vec3>& position)
+{
+    int const N = basis.N_sample;
+    int const N_value = 3 * N * N;
+
+    // Local positions: mean + U q, accumulated mode by mode over the contiguous values
+    position.resize(N, N);
+    float* x = reinterpret_cast<float*>(position.data.data.data());
+    std::memcpy(x, basis.mean.data.data(), N_value * sizeof(float));
+    for (int i = 0; i < basis.N_mode; ++i) {
+        float const q_i = state.q[i];
+        float const* u = basis.mode_data(i);
+#pragma omp simd
+        for (int k = 0; k < N_value; ++k)
+            x[k] += q_i * u[k];
+    }
+
+    vec3 origin, e_x, e_y, e_z;
+    cape_rig_body_frame(joint_frames, origin, e_x, e_y, e_z);
+    vec3* p = position.data.data.data();
+    for (int k = 0; k < N * N; ++k)
+        p[k] = origin + p[k].x * e_x + p[k].y * e_y + p[k].z * e_z;
+}
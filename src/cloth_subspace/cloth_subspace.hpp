@@ -0,0 +1,98 @@
+#pragma once
+
+#include "cgp/cgp.hpp"
+#include "../cape_rig/cape_rig.hpp"
+#include "../simulation/simulation.hpp"
+
+#include <vector>
+
+
+// Reduced-order cape for the background characters
+//
+// The full simulation is run offline over the animations (cloth_subspace_record), and the positions of the cape expressed in the
+//  frame of the upper body (cape_rig_body_frame) are compressed by a PCA: x_local = mean + sum_i q_i mode_i.
+// The dynamics of the N_mode coordinates q is fitted on the same runs (least squares with a Tikhonov regularization):
+//  q(t+dt) = A1 q(t) + A2 q(t-dt) + B input(t+dt), the input describing the motion of the body (see cloth_subspace_body).
+//  A linearization of the springs around the mean shape cannot follow the cape from hanging to streaming behind a walking character,
+//  the fitted dynamics does, at the cost of one N_mode x (2 N_mode + N_input) product per step.
+// The reconstruction of the vertices is one (3 N^2) x N_mode product.
+
+
+// Inputs of the reduced dynamics at each step, in the body frame: the vertical direction, the velocity and the acceleration of the origin of the frame,
+//  the positions of the pins (cape_rig_update_pins, by increasing vertex index), and a constant 1
+int const cloth_subspace_N_pin = 4;
+int const cloth_subspace_N_input = 9 + 3 * cloth_subspace_N_pin + 1;
+
+struct cloth_subspace_body
+{
+    cgp::vec3 origin_previous[2]; // positions of the frame at the previous steps
+    int N_previous = 0;
+    constraint_structure constraint;
+
+    void reset();
+    void update(cgp::numarray<cgp::mat4> const& joint_frames, float dt, int N_sample, float* input); // Move to the next step, and fill its N_input values
+};
+
+
+// Positions of the vertices in the body frame, and the body inputs, at each frame of a run of the full simulation
+struct cloth_subspace_recording
+{
+    std::vector<cgp::numarray<float>> position; // 3 N_sample^2 values per frame (x,y,z of each vertex in the grid_2D order)
+    std::vector<cgp::numarray<float>> input;    // N_input values per frame
+};
+
+// Full simulation of the cape over a clip, recorded at a given rate after a warmup on the first pose. Returns false if the simulation diverged.
+struct cloth_subspace_record_settings
+{
+    int N_sample = 30;
+    int substeps = 4;
+    float fps = 30.0f;
+    float duration = 4.0f;
+    float warmup = 1.0f;
+};
+bool cloth_subspace_record(cape_rig_clip const& clip, simulation_parameters const& parameters, cloth_subspace_record_settings const& settings, cloth_subspace_recording& recording);
+
+
+// Reduced model baked from the full simulation
+struct cloth_subspace_basis
+{
+    int N_sample = 0; // the cape has N_sample x N_sample vertices
+    int N_mode = 0;
+    float dt = 0.0f;  // time step of the dynamics (period of the recorded frames)
+
+    cgp::numarray<float> mean;     // mean local position (3 N_sample^2 values)
+    cgp::numarray<float> mode;     // N_mode orthonormal modes of 3 N_sample^2 values, stored one after the other
+    cgp::numarray<float> variance; // variance of the recorded positions along each mode (decreasing)
+    cgp::numarray<float> dynamics; // N_mode rows of [A1 A2 B] (2 N_mode + N_input values)
+
+    float const* mode_data(int k_mode) const;
+    int N_dynamics() const; // number of values of a row of dynamics
+};
+
+// PCA of the recorded positions (at most max_snapshots evenly spaced frames), then fit of the dynamics on all the frames
+//  The regularization is relative to the mean diagonal of the normal equations. It is increased until the fitted dynamics is stable.
+cloth_subspace_basis cloth_subspace_build(std::vector<cloth_subspace_recording> const& recordings, float dt, int N_sample, int N_mode, float regularization = 1e-4f, int max_snapshots = 600);
+
+// File of a basis (little endian): "CSUB", version, N_sample, N_mode, N_input, dt, then the arrays in the order of the structure
+int const cloth_subspace_version = 1;
+bool cloth_subspace_save(std::string const& filename, cloth_subspace_basis const& basis);
+bool cloth_subspace_load(std::string const& filename, cloth_subspace_basis& basis); // Returns false if the file is missing or is not a valid basis
+
+
+// Reduced coordinates of one cape (the basis can be shared by many capes)
+struct cloth_subspace_state
+{
+    cgp::numarray<float> q;
+    cgp::numarray<float> q_previous;
+    cloth_subspace_body body;
+    cgp::numarray<float> x; // [q, q_previous, input] of the step
+
+    // Cape at rest on the body in the pose given by the global joint frames (equilibrium of the reduced dynamics)
+    void initialize(cloth_subspace_basis const& basis, cgp::numarray<cgp::mat4> const& joint_frames);
+};
+
+// Advance the cape by basis.dt with the body given by the global joint frames
+void cloth_subspace_step(cloth_subspace_state& state, cloth_subspace_basis const& basis, cgp::numarray<cgp::mat4> const& joint_frames);
+
+// Global positions of the vertices of the cape (resized to N_sample x N_sample)
+void cloth_subspace_reconstruct(cloth_subspace_state const& state, cloth_subspace_basis const& basis, cgp::numarray<cgp::mat4> const& joint_frames, cgp::grid_2D<cgp::vec3>& position);
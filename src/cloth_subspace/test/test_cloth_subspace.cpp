@@ -0,0 +1,103 @@
+#include "cgp/01_base/base.hpp"
+#include "../cloth_subspace.hpp"
+
+#include <cstdio>
+#include <iostream>
+
+using namespace cgp;
+
+namespace cgp_test {
+
+	// Upper body swinging from left to right twice per second, the colliders being far below the cloth
+	static cape_rig_clip test_clip()
+	{
+		numarray<mat4> frame;
+		frame.resize(27);
+		for (int k = 0; k < frame.size(); ++k)
+			frame[k] = mat4::build_identity().set_block_translation({ 0.1f * k, -10.0f, 0.0f });
+		frame[0].set_block_translation({ 0.0f, 0.0f, 0.0f });   // hips
+		frame[10].set_block_translation({ 0.0f, 1.2f, 0.0f });  // neck
+		frame[11].set_block_translation({ -0.2f, 1.0f, 0.0f }); // shoulders
+		frame[12].set_block_translation({ 0.2f, 1.0f, 0.0f });
+		frame[16].set_block_translation({ -0.5f, 1.0f, 0.0f }); // arms
+		frame[17].set_block_translation({ 0.5f, 1.0f, 0.0f });
+
+		numarray<mat4> frame_moved = frame;
+		for (int k : { 0, 10, 11, 12, 16, 17 })
+			frame_moved[k].set_block_translation(frame[k].get_block_translation() + vec3{ 0.2f, 0.0f, 0.0f });
+
+		cape_rig_clip clip;
+		clip.name = "swing";
+		clip.frame_rate = 4.0f;
+		clip.frames = { frame, frame_moved };
+		return clip;
+	}
+
+	// The basis is orthonormal and survives a save/load, and the reduced cape follows the full simulation it was fitted on
+	void test_cloth_subspace()
+	{
+		int const N = 10;
+		cape_rig_clip const clip = test_clip();
+		simulation_parameters parameters;
+
+		cloth_subspace_record_settings settings;
+		settings.N_sample = N;
+		settings.duration = 2.0f;
+		settings.warmup = 1.0f;
+		std::vector<cloth_subspace_recording> recordings(1);
+		assert_cgp_no_msg(cloth_subspace_record(clip, parameters, settings, recordings[0]));
+		assert_cgp_no_msg(recordings[0].position.size() == 60 && recordings[0].input.size() == 60);
+
+		int const N_mode = 8;
+		cloth_subspace_basis const basis = cloth_subspace_build(recordings, 1.0f / settings.fps, N, N_mode);
+		assert_cgp_no_msg(basis.N_mode > 0 && basis.N_mode <= N_mode);
+		assert_cgp_no_msg(basis.dynamics.size() == basis.N_mode * basis.N_dynamics());
+		for (int i = 0; i < basis.N_mode; ++i) {
+			for (int j = 0; j < basis.N_mode; ++j) {
+				float d = 0.0f;
+				for (int k = 0; k < basis.mean.size(); ++k)
+					d += basis.mode_data(i)[k] * basis.mode_data(j)[k];
+				assert_cgp_no_msg(std::abs(d - (i == j ? 1.0f : 0.0f)) < 1e-4f);
+			}
+			if (i > 0)
+				assert_cgp_no_msg(basis.variance[i] <= basis.variance[i - 1]);
+		}
+
+		std::string const filename = "test_cloth_subspace.subspace";
+		assert_cgp_no_msg(cloth_subspace_save(filename, basis));
+		cloth_subspace_basis loaded;
+		assert_cgp_no_msg(cloth_subspace_load(filename, loaded));
+		std::remove(filename.c_str());
+		assert_cgp_no_msg(loaded.N_mode == basis.N_mode && loaded.N_sample == N && loaded.dt == basis.dt);
+		assert_cgp_no_msg(loaded.mode[5] == basis.mode[5] && loaded.dynamics[7] == basis.dynamics[7]);
+
+		// Same clip as the bake, one step per recorded frame. The reduced cape starts at rest on the first pose:
+		//  it is compared to the full simulation after the first swing (a few cm on a 1 m cape swinging by 20 cm).
+		numarray<mat4> joint_frames;
+		grid_2D<vec3> position;
+		clip.evaluate(0.0f, joint_frames);
+		cloth_subspace_state state;
+		state.initialize(loaded, joint_frames);
+
+		float error_max = 0.0f;
+		for (int k_frame = 0; k_frame < recordings[0].position.size(); ++k_frame) {
+			clip.evaluate(k_frame / settings.fps, joint_frames);
+			cloth_subspace_step(state, loaded, joint_frames);
+			cloth_subspace_reconstruct(state, loaded, joint_frames, position);
+			for (int k = 0; k < N * N; ++k)
+				assert_cgp_no_msg(std::isfinite(position.data[k].x));
+			if (k_frame < 30)
+				continue;
+
+			vec3 origin, e_x, e_y, e_z;
+			cape_rig_body_frame(joint_frames, origin, e_x, e_y, e_z);
+			numarray<float> const& full = recordings[0].position[k_frame];
+			for (int k = 0; k < N * N; ++k) {
+				vec3 const p_full = origin + full[3 * k] * e_x + full[3 * k + 1] * e_y + full[3 * k + 2] * e_z;
+				error_max = std::max(error_max, norm(position.data[k] - p_full));
+			}
+		}
+		assert_cgp_no_msg(error_max < 0.05f);
+	}
+
+}
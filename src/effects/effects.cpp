@@ -81,6 +81,7 @@ void effect_transition_compute(effect_transition_structure& effect_transition, c
 	}
 	model.skeleton.joint_matrix_local = joint_interpolated;
 	model.skeleton.update_joint_matrix_local_to_global();
+	model.pose_changed();
 
 	// Update the timers
 	transition.timer_source_anim.update();
@@ -132,14 +133,35 @@ void effect_walking(effect_walking_structure& effect_walking,  character_structu
 	}
 
 
-	mat4& root = character.animated_model.skeleton.joint_matrix_local[0];
+	animated_model_structure& model = character.animated_model;
+	mat4& root = model.skeleton.joint_matrix_local[0];
+
+	// The root is computed from the one of the animation: when the pose is not evaluated again (paused animation), the root still holds the previous effect
+	bool const pose_evaluated = &model != effect_walking.model || model.pose_version != effect_walking.pose_version;
+	if(pose_evaluated)
+		effect_walking.root_animation = root;
+	mat4 const& root_animation = effect_walking.root_animation;
+
 	mat3 R = rotation_axis_angle({0,1,0},effect_walking.root_angle).matrix();
+	mat4 root_walk = root_animation;
+	root_walk.set_block_translation( vec3(root_animation.get_block_translation().xy(),0.0f)+effect_walking.root_position );
+	root_walk.set_block_linear(B0.get_block_linear() * R * root_animation.get_block_linear());
 
-	root.set_block_translation( vec3(root.get_block_translation().xy(),0.0f)+effect_walking.root_position );
-	root.set_block_linear(B0.get_block_linear() * R * root.get_block_linear());
+	// Nothing changes when the animation is paused and no key moves the character: the skinning and the GPU upload are skipped
+	if(pose_evaluated==false && is_equal(root_walk, root))
+		return;
 
+	root = root_walk;
+	model.skeleton.update_joint_matrix_local_to_global();
 
-	character.animated_model.skeleton.update_joint_matrix_local_to_global();
+	// The animation pose under the root is unchanged: set_skeleton_from_animation can still skip it at the next frame
+	std::string const pose_animation_name = model.pose_animation_name;
+	float const pose_time = model.pose_time;
+	model.pose_changed();
+	model.pose_animation_name = pose_animation_name;
+	model.pose_time = pose_time;
+	effect_walking.model = &model;
+	effect_walking.pose_version = model.pose_version;
 }
 
 mat4 mat4_interpolate_quaternion(mat4 const& M1, mat4 const& M2, float t) {
@@ -23,6 +23,9 @@ struct effect_walking_structure {
 	float root_angle;        // stores the orientation of the character
 	bool active = false;    // Is the walk effect currently active
 	cgp::timer_basic timer;
+	cgp::mat4 root_animation; // local frame of the root set by the animation, before the walk effect is applied
+	animated_model_structure const* model = nullptr; // model, and its pose_version, after the last walk effect (the skeleton was not evaluated again since if they are unchanged)
+	int pose_version = -1;
 };
 
 // Update a transition_structure before starting a new transition
@@ -0,0 +1,73 @@
+#include "cgp/01_base/base.hpp"
+#include "../effects.hpp"
+
+#include <iostream>
+
+using namespace cgp;
+
+namespace cgp_test {
+
+	// The walk effect changes the pose only if the animation or the root of the character changed: a paused animation is not skinned again
+	void test_effect_walking()
+	{
+		character_structure character;
+		animated_model_structure& model = character.animated_model;
+		skeleton_animation_structure& animation = model.animation["Walk"];
+		int const N_joint = 3;
+		model.skeleton.joint_matrix_local.resize(N_joint);
+		for (int kj = 0; kj < N_joint; ++kj) {
+			model.skeleton.parent_index.push_back(kj - 1);
+			animation.joint_index.push_back(kj);
+			animation.times.push_back(numarray<float>{ 0.0f, 1.0f });
+			animation.matrix.push_back(numarray<mat4>{ mat4::build_identity(), mat4::build_translation(0.1f * kj, 0.2f, 0.5f) });
+		}
+		animation.update_time_max();
+
+		effect_walking_structure walk;
+		walk.root_position = { 0.5f, 0.0f, 1.0f };
+		walk.root_angle = 0.3f;
+		input_devices inputs;            // no key pressed
+		effect_transition_structure transition;
+
+		// One frame of the scene: pose of the animation, then walk effect
+		auto frame = [&](float t) {
+			model.set_skeleton_from_animation("Walk", t);
+			effect_walking(walk, character, inputs, transition);
+		};
+
+		character_structure const character_initial = character;
+		frame(0.25f);
+		int const version = model.pose_version;
+		mat4 const root = model.skeleton.joint_matrix_local[0];
+
+		// Paused animation and no key: the pose is unchanged, and the root is not transformed again
+		for (int k = 0; k < 3; ++k) {
+			frame(0.25f);
+			assert_cgp_no_msg(model.pose_version == version);
+			assert_cgp_no_msg(is_equal(model.skeleton.joint_matrix_local[0], root));
+		}
+
+		// The character turns: new pose, with the same root as a first frame with this angle
+		walk.root_angle = 0.6f;
+		frame(0.25f);
+		assert_cgp_no_msg(model.pose_version > version);
+		{
+			character_structure reference = character_initial;
+			effect_walking_structure walk_reference;
+			walk_reference.root_position = walk.root_position;
+			walk_reference.root_angle = walk.root_angle;
+			reference.animated_model.set_skeleton_from_animation("Walk", 0.25f);
+			effect_walking(walk_reference, reference, inputs, transition);
+			assert_cgp_no_msg(is_equal(model.skeleton.joint_matrix_local[0], reference.animated_model.skeleton.joint_matrix_local[0]));
+			assert_cgp_no_msg(is_equal(model.skeleton.joint_matrix_global, reference.animated_model.skeleton.joint_matrix_global));
+		}
+		int const version_turn = model.pose_version;
+		frame(0.25f);
+		assert_cgp_no_msg(model.pose_version == version_turn);
+
+		// The animation moves: new pose
+		frame(0.5f);
+		assert_cgp_no_msg(model.pose_version > version_turn);
+	}
+
+}
@@ -0,0 +1,101 @@
+#include "frame_governor.hpp"
+
+using namespace cgp;
+
+
+std::string frame_phase_name(frame_phase phase)
+{
+    switch (phase) {
+    case frame_phase::skinning: return "skinning";
+    case frame_phase::simulation: return "simulation";
+    case frame_phase::draw: return "draw";
+    }
+    return "unknown";
+}
+
+void frame_governor_structure::start_phase(frame_phase phase)
+{
+    phase_start[int(phase)] = std::chrono::steady_clock::now();
+}
+
+void frame_governor_structure::stop_phase(frame_phase phase)
+{
+    std::chrono::duration<float, std::milli> const duration = std::chrono::steady_clock::now() - phase_start[int(phase)];
+    phase_frame_ms[int(phase)] += duration.count();
+}
+
+float frame_governor_structure::total_ms() const
+{
+    float total = 0.0f;
+    for (int k = 0; k < frame_phase_count; ++k)
+        total += phase_ms[k];
+    return total;
+}
+
+void frame_governor_structure::record(std::string const& decision)
+{
+    std::string const message = "[governor] " + str(total_ms()) + "ms / " + str(budget_ms) + "ms: " + decision;
+    std::cout << message << std::endl;
+
+    log.push_back(message);
+    if (log.size() > size_t(log_size_max))
+        log.erase(log.begin());
+}
+
+bool frame_governor_structure::update()
+{
+    for (int k = 0; k < frame_phase_count; ++k) {
+        phase_ms[k] = (1.0f - smoothing) * phase_ms[k] + smoothing * phase_frame_ms[k];
+        phase_frame_ms[k] = 0.0f;
+    }
+
+    frames_since_decision++;
+    if (active == false || frames_since_decision < frames_between_decisions)
+        return false;
+
+    float const t = total_ms();
+
+    // Over budget: lower the cheapest-to-lose setting first
+    if (t > budget_ms * (1.0f + tolerance)) {
+        if (substeps > substeps_min) {
+            substeps--;
+            record("substeps reduced to " + str(substeps));
+        }
+        else if (collider_detail > collider_detail_min) {
+            collider_detail--;
+            record("collider detail reduced to " + str(collider_detail));
+        }
+        else if (N_sample > N_sample_min) {
+            N_sample = std::max(N_sample - N_sample_step, N_sample_min);
+            record("cloth resolution reduced to " + str(N_sample));
+        }
+        else
+            return false;
+
+        frames_since_decision = 0;
+        return true;
+    }
+
+    // Under budget: restore the settings in the reverse order
+    if (t < budget_ms * (1.0f - tolerance)) {
+        if (N_sample < N_sample_max) {
+            N_sample = std::min(N_sample + N_sample_step, N_sample_max);
+            record("cloth resolution increased to " + str(N_sample));
+        }
+        else if (collider_detail < collider_detail_max) {
+            collider_detail++;
+            record("collider detail increased to " + str(collider_detail));
+        }
+        else if (substeps < substeps_max) {
+            substeps++;
+            record("substeps increased to " + str(substeps));
+        }
+        else
+            return false;
+
+        frames_since_decision = 0;
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "cgp/cgp.hpp"
+#include <chrono>
+
+
+// Phases of a frame measured by the governor
+enum class frame_phase { skinning, simulation, draw };
+int const frame_phase_count = 3;
+
+// Measures the time spent in each phase of the frame, and adapts the quality of the simulation to hold a frame budget
+//  The quality settings are changed one notch at a time, in the order:
+//   - to save time:   substeps -> collider detail -> cloth resolution
+//   - to spend time:  cloth resolution -> collider detail -> substeps
+struct frame_governor_structure
+{
+    bool active = false;
+    float budget_ms = 16.6f;           // Target duration of the measured phases
+    float tolerance = 0.15f;           // Relative band around the budget where nothing is changed
+    int frames_between_decisions = 20; // Minimal number of frames between two changes (lets the timings settle)
+
+    // Bounds of the settings
+    int substeps_min = 1, substeps_max = 4;
+    int collider_detail_min = 0, collider_detail_max = 2;
+    int N_sample_min = 8, N_sample_max = 80;
+    int N_sample_step = 4;
+
+    // Current settings
+    int substeps = 1;        // Number of simulation steps per frame (each step integrates parameters.dt/substeps)
+    int collider_detail = 2; // 0: hips sphere only, 1: all spheres, 2: spheres and cylinders
+    int N_sample = 20;       // Maximal resolution of the cloth
+
+    // Smoothed duration of each phase (ms)
+    float phase_ms[frame_phase_count] = { 0,0,0 };
+    float smoothing = 0.1f;  // weight of the new measure in the exponential moving average
+    float phase_frame_ms[frame_phase_count] = { 0,0,0 }; // accumulated duration of each phase during the current frame
+
+    std::vector<std::string> log; // Last decisions (most recent at the end)
+    int log_size_max = 8;
+
+    std::chrono::steady_clock::time_point phase_start[frame_phase_count];
+    int frames_since_decision = 0;
+
+
+    // Measure a phase - a phase can be started and stopped several times during a frame
+    void start_phase(frame_phase phase);
+    void stop_phase(frame_phase phase);
+    float total_ms() const;
+
+    // Called once per frame after all phases are measured: average the timings and adapt the settings if needed
+    //  Return true if a setting changed
+    bool update();
+
+    // Print the decision and keep it in the log
+    void record(std::string const& decision);
+};
+
+std::string frame_phase_name(frame_phase phase);
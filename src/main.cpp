@@ -10,6 +10,19 @@
 // Custom scene of this code
 #include "scene.hpp"
 
+// Unit tests of the project (run with the argument --test)
+#include "simulation/test/test_simulation.hpp"
+#include "cloth_snapshot/test/test_cloth_snapshot.hpp"
+#include "cloth_batch/test/test_cloth_batch.hpp"
+#include "cloth_ensemble/test/test_cloth_ensemble.hpp"
+#include "parameter_sweep/test/test_parameter_sweep.hpp"
+#include "vertex_cache/test/test_vertex_cache.hpp"
+#include "cloth_subspace/test/test_cloth_subspace.hpp"
+#include "cloth/test/test_cloth_refinement.hpp"
+#include "cloth_distributed/test/test_cloth_distributed.hpp"
+#include "animated_character/test/test_skinning.hpp"
+#include "effects/test/test_effects.hpp"
+
 
 
 
@@ -32,10 +45,27 @@ void display_gui_default();
 
 timer_fps fps_record;
 
-int main(int, char* argv[])
+int main(int argc, char* argv[])
 {
 	std::cout << "Run " << argv[0] << std::endl;
 
+	if (argc > 1 && std::string(argv[1]) == "--test") {
+		cgp_test::test_simulation_determinism();
+		cgp_test::test_simulation_aerodynamics_toggle();
+		cgp_test::test_cloth_snapshot();
+		cgp_test::test_cloth_batch();
+		cgp_test::test_cloth_ensemble();
+		cgp_test::test_parameter_sweep();
+		cgp_test::test_parameter_sweep_load();
+		cgp_test::test_vertex_cache();
+		cgp_test::test_cloth_subspace();
+		cgp_test::test_cloth_refinement();
+		cgp_test::test_cloth_distributed();
+		cgp_test::test_skinning();
+		cgp_test::test_effect_walking();
+		std::cout << "All tests passed" << std::endl;
+		return 0;
+	}
 	
 
 	// ************************ //
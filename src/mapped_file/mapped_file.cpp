@@ -0,0 +1,110 @@
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+mapped_file_structure::~mapped_file_structure()
+{
+    close();
+}
+
+bool mapped_file_structure::is_open() const
+{
+    return data != nullptr;
+}
+
+#ifdef _WIN32
+
+bool mapped_file_structure::open(std::string const& filename)
+{
+    close();
+
+    HANDLE const file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size;
+    if (GetFileSizeEx(file, &file_size) == 0 || file_size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE const mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void const* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    file_handle = file;
+    mapping_handle = mapping;
+    data = static_cast<char const*>(view);
+    size = static_cast<size_t>(file_size.QuadPart);
+    return true;
+}
+
+void mapped_file_structure::close()
+{
+    if (data != nullptr)
+        UnmapViewOfFile(data);
+    if (mapping_handle != nullptr)
+        CloseHandle(mapping_handle);
+    if (file_handle != nullptr)
+        CloseHandle(file_handle);
+
+    data = nullptr;
+    size = 0;
+    file_handle = nullptr;
+    mapping_handle = nullptr;
+}
+
+#else
+
+bool mapped_file_structure::open(std::string const& filename)
+{
+    close();
+
+    int const file = ::open(filename.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat file_stat;
+    if (fstat(file, &file_stat) != 0 || file_stat.st_size == 0) {
+        ::close(file);
+        return false;
+    }
+
+    void* const view = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file); // The mapping remains valid once the file descriptor is closed
+    if (view == MAP_FAILED)
+        return false;
+
+    data = static_cast<char const*>(view);
+    size = static_cast<size_t>(file_stat.st_size);
+    return true;
+}
+
+void mapped_file_structure::close()
+{
+    if (data != nullptr)
+        munmap(const_cast<char*>(data), size);
+
+    data = nullptr;
+    size = 0;
+}
+
+#endif
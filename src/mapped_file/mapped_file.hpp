@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+
+// Read-only view of a file mapped in memory
+//  The content is paged in by the system on access: opening a large file is immediate and only the bytes that are read are loaded.
+//  The mapping is released when the structure is closed or destroyed.
+struct mapped_file_structure
+{
+    char const* data = nullptr; // First byte of the file (nullptr when no file is mapped)
+    size_t size = 0;            // Size of the file in bytes
+
+    mapped_file_structure() = default;
+    mapped_file_structure(mapped_file_structure const&) = delete;
+    mapped_file_structure& operator=(mapped_file_structure const&) = delete;
+    ~mapped_file_structure();
+
+    bool open(std::string const& filename); // Map the file, returns false if it cannot be opened
+    void close();                           // Release the mapping
+    bool is_open() const;
+
+private:
+#ifdef _WIN32
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#endif
+};
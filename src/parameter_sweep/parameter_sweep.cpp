@@ -0,0 +1,411 @@
+#include "parameter_sweep.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace cgp;
+
+
+std::vector<parameter_sweep_scenario> parameter_sweep_description::scenarios() const
+{
+    std::vector<parameter_sweep_scenario> result;
+    for (int N_sample : resolution)
+    for (int stencil_value : stencil)
+    for (int substeps_value : substeps)
+    for (float dt_value : dt)
+    for (float mass_value : mass_total)
+    for (float K_value : K)
+    for (float mu_value : mu)
+    for (float wind_value : wind_magnitude)
+    for (int aerodynamics_value : aerodynamics) {
+        parameter_sweep_scenario scenario;
+        scenario.N_sample = N_sample;
+        scenario.substeps = substeps_value;
+        scenario.parameters.stencil = stencil_value;
+        scenario.parameters.dt = dt_value;
+        scenario.parameters.mass_total = mass_value;
+        scenario.parameters.K = K_value;
+        scenario.parameters.mu = mu_value;
+        scenario.parameters.wind.magnitude = wind_value;
+        scenario.parameters.aerodynamics.active = aerodynamics_value != 0;
+        result.push_back(scenario);
+    }
+    return result;
+}
+
+
+// Reading of the description
+// ************************************************************ //
+
+// Values of a line: either "v1 v2 v3" or "min:max:count" (count values evenly spaced in [min,max])
+static bool parse_values(std::string const& text, std::vector<float>& values)
+{
+    values.clear();
+    std::istringstream stream(text);
+    std::string token;
+    while (stream >> token) {
+        std::replace(token.begin(), token.end(), ':', ' ');
+        std::istringstream token_stream(token);
+        float a = 0, b = 0; int count = 0;
+        if (!(token_stream >> a))
+            return false;
+        if (token_stream >> b) {
+            if (!(token_stream >> count) || count < 1)
+                return false;
+            for (int k = 0; k < count; ++k)
+                values.push_back(count == 1 ? a : a + (b - a) * k / (count - 1.0f));
+        }
+        else
+            values.push_back(a);
+    }
+    return values.size() > 0;
+}
+
+static std::vector<int> to_int(std::vector<float> const& values)
+{
+    std::vector<int> result;
+    for (float v : values)
+        result.push_back(static_cast<int>(std::round(v)));
+    return result;
+}
+
+static std::string trim(std::string const& s)
+{
+    size_t const a = s.find_first_not_of(" \t\r");
+    size_t const b = s.find_last_not_of(" \t\r");
+    return a == std::string::npos ? "" : s.substr(a, b - a + 1);
+}
+
+bool parameter_sweep_load(std::string const& filename, parameter_sweep_description& description)
+{
+    std::ifstream stream(filename);
+    if (!stream.is_open()) {
+        std::cout << "Error: cannot open the sweep description " << filename << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int k_line = 0;
+    while (std::getline(stream, line)) {
+        k_line++;
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty())
+            continue;
+
+        size_t const equal = line.find('=');
+        std::string const key = trim(line.substr(0, equal));
+        std::string const text = equal == std::string::npos ? "" : trim(line.substr(equal + 1));
+
+        std::vector<float> values;
+        bool valid = key == "animation" ? !text.empty() : parse_values(text, values);
+        if (valid) {
+            if (key == "animation") description.settings.animation = text;
+            else if (key == "resolution") description.resolution = to_int(values);
+            else if (key == "stencil") description.stencil = to_int(values);
+            else if (key == "substeps") description.substeps = to_int(values);
+            else if (key == "dt") description.dt = values;
+            else if (key == "mass_total") description.mass_total = values;
+            else if (key == "K") description.K = values;
+            else if (key == "mu") description.mu = values;
+            else if (key == "wind_magnitude") description.wind_magnitude = values;
+            else if (key == "aerodynamics") description.aerodynamics = to_int(values);
+            else if (key == "duration") description.settings.duration = values[0];
+            else if (key == "warmup") description.settings.warmup = values[0];
+            else if (key == "workers") description.settings.workers = to_int(values)[0];
+            else if (key == "threads_per_run") description.settings.threads_per_run = to_int(values)[0];
+            else if (key == "weight_stretch") description.settings.weight_stretch = values[0];
+            else if (key == "weight_runtime") description.settings.weight_runtime = values[0];
+            else valid = false;
+        }
+        if (!valid) {
+            std::cout << "Error: " << filename << " line " << k_line << ": cannot read \"" << line << "\"" << std::endl;
+            return false;
+        }
+    }
+
+    for (int N : description.resolution) {
+        if (N <= 3) {
+            std::cout << "Error: " << filename << ": the resolution " << N << " should be > 3" << std::endl;
+            return false;
+        }
+    }
+    for (int s : description.stencil) {
+        if (s != 4 && s != 8 && s != 12 && s != 24) {
+            std::cout << "Error: " << filename << ": the stencil " << s << " should be 4, 8, 12 or 24" << std::endl;
+            return false;
+        }
+    }
+    for (int s : description.substeps) {
+        if (s < 1) {
+            std::cout << "Error: " << filename << ": the number of substeps " << s << " should be >= 1" << std::endl;
+            return false;
+        }
+    }
+    // The number of steps of a run is duration/dt: a zero or negative time step would run no step, and report the flat cloth as stable
+    for (float dt : description.dt) {
+        if (!(dt > 0)) {
+            std::cout << "Error: " << filename << ": the time step " << dt << " should be > 0" << std::endl;
+            return false;
+        }
+    }
+    for (float m : description.mass_total) {
+        if (!(m > 0)) {
+            std::cout << "Error: " << filename << ": the mass " << m << " should be > 0" << std::endl;
+            return false;
+        }
+    }
+    for (float K : description.K) {
+        if (!(K >= 0)) {
+            std::cout << "Error: " << filename << ": the stiffness " << K << " should be >= 0" << std::endl;
+            return false;
+        }
+    }
+    for (float mu : description.mu) {
+        if (!(mu >= 0)) {
+            std::cout << "Error: " << filename << ": the damping " << mu << " should be >= 0" << std::endl;
+            return false;
+        }
+    }
+    if (!(description.settings.duration > 0)) {
+        std::cout << "Error: " << filename << ": the duration " << description.settings.duration << " should be > 0" << std::endl;
+        return false;
+    }
+    if (!(description.settings.warmup >= 0)) {
+        std::cout << "Error: " << filename << ": the warmup " << description.settings.warmup << " should be >= 0" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+
+// Run of the scenarios
+// ************************************************************ //
+
+// Relative elongation of the structural springs (direct neighbors along u and v)
+static void measure_stretch(cloth_structure const& cloth, float& stretch_max, float& stretch_mean)
+{
+    int const N = cloth.N_samples();
+    float const L0 = 1.0f / (N - 1.0f);
+    vec3 const* position = cloth.position.data.data.data();
+
+    stretch_max = 0.0f;
+    double sum = 0.0;
+    for (int kv = 0; kv < N; ++kv) {
+        for (int ku = 0; ku < N; ++ku) {
+            vec3 const& p = position[ku + N * kv];
+            if (ku + 1 < N) {
+                float const s = std::abs(norm(position[ku + 1 + N * kv] - p) - L0) / L0;
+                stretch_max = std::max(stretch_max, s);
+                sum += s;
+            }
+            if (kv + 1 < N) {
+                float const s = std::abs(norm(position[ku + N * (kv + 1)] - p) - L0) / L0;
+                stretch_max = std::max(stretch_max, s);
+                sum += s;
+            }
+        }
+    }
+    stretch_mean = static_cast<float>(sum / (2.0 * N * (N - 1)));
+}
+
+parameter_sweep_result parameter_sweep_run_scenario(parameter_sweep_scenario const& scenario, cape_rig_clip const& clip, parameter_sweep_settings const& settings)
+{
+    simulation_parameters const& parameters = scenario.parameters;
+    assert_cgp(parameters.dt > 0 && parameters.mass_total > 0 && settings.duration > 0 && settings.warmup >= 0,
+        "Invalid scenario: dt=" + str(parameters.dt) + ", mass_total=" + str(parameters.mass_total) + ", duration=" + str(settings.duration) + ", warmup=" + str(settings.warmup));
+    parameter_sweep_result result;
+
+    cloth_structure cloth;
+    cloth.initialize(scenario.N_sample);
+
+    // The cape starts hanging below the shoulders of the first pose
+    constraint_structure constraint;
+    numarray<mat4> joint_frames;
+    clip.evaluate(0.0f, joint_frames);
+    cape_rig_update_pins(constraint, joint_frames, scenario.N_sample);
+    cape_rig_drape(cloth, constraint);
+
+    // The velocity of a pinned vertex is not meaningful (its position is overwritten at each step): it is not measured
+    numarray<int> pinned;
+    pinned.resize_clear(scenario.N_sample * scenario.N_sample);
+    for (auto const& it : constraint.fixed_sample)
+        pinned[it.second.ku + scenario.N_sample * it.second.kv] = 1;
+
+    int const N_step = static_cast<int>(std::ceil(settings.duration / parameters.dt));
+    int const N_step_warmup = static_cast<int>(std::ceil(settings.warmup / parameters.dt));
+    float const dt_step = parameters.dt / scenario.substeps;
+    double stretch_sum = 0.0;
+
+    for (int k_step = 0; k_step < N_step && result.stable; ++k_step) {
+        clip.evaluate(k_step * parameters.dt, joint_frames);
+        cape_rig_update_pins(constraint, joint_frames, scenario.N_sample);
+        cape_rig_update_colliders(constraint, joint_frames);
+
+        auto const time_start = std::chrono::steady_clock::now();
+        for (int k_substep = 0; k_substep < scenario.substeps; ++k_substep) {
+            simulation_compute_force(cloth, parameters);
+            simulation_numerical_integration(cloth, parameters, dt_step);
+            simulation_apply_constraints(cloth, constraint);
+            if (simulation_detect_divergence(cloth)) {
+                result.stable = false;
+                result.step_diverged = k_step;
+                break;
+            }
+            simulation_update_normal(cloth, parameters);
+        }
+        result.runtime_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - time_start).count();
+        result.N_step = k_step + 1;
+
+        if (result.stable && k_step >= N_step_warmup) {
+            float stretch_max = 0.0f, stretch_mean = 0.0f;
+            measure_stretch(cloth, stretch_max, stretch_mean);
+            result.stretch_max = std::max(result.stretch_max, stretch_max);
+            stretch_sum += stretch_mean;
+
+            for (int k = 0; k < cloth.velocity.size(); ++k)
+                if (pinned[k] == 0)
+                    result.speed_max = std::max(result.speed_max, norm(cloth.velocity.data[k]));
+        }
+    }
+    result.stretch_mean = static_cast<float>(stretch_sum / std::max(result.N_step - N_step_warmup, 1));
+
+    return result;
+}
+
+// Restrict the calling thread to the cores [core_start, core_start+N_core[
+static void pin_current_thread(int core_start, int N_core)
+{
+#ifdef __linux__
+    cpu_set_t cores;
+    CPU_ZERO(&cores);
+    int const N_core_total = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    for (int k = 0; k < N_core; ++k)
+        CPU_SET((core_start + k) % N_core_total, &cores);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cores);
+#else
+    (void)core_start;
+    (void)N_core;
+#endif
+}
+
+std::vector<parameter_sweep_result> parameter_sweep_run(std::vector<parameter_sweep_scenario> const& scenarios, cape_rig_clip const& clip, parameter_sweep_settings const& settings)
+{
+    int const N_scenario = static_cast<int>(scenarios.size());
+    std::vector<parameter_sweep_result> results(N_scenario);
+
+    int const threads_per_run = std::max(settings.threads_per_run, 1);
+    int N_worker = settings.workers;
+    if (N_worker <= 0)
+        N_worker = std::max(static_cast<int>(std::thread::hardware_concurrency()) / threads_per_run, 1);
+    N_worker = std::min(N_worker, std::max(N_scenario, 1));
+
+    std::atomic<int> next_scenario(0);
+    std::mutex output_mutex;
+    int N_done = 0;
+
+    // Each worker takes the next scenario to run until all of them are done
+    //  The OpenMP threads of a run are created by the worker: they inherit its cores.
+    auto worker = [&](int k_worker) {
+        pin_current_thread(k_worker * threads_per_run, threads_per_run);
+#ifdef _OPENMP
+        omp_set_num_threads(threads_per_run);
+#endif
+        for (int k = next_scenario++; k < N_scenario; k = next_scenario++) {
+            results[k] = parameter_sweep_run_scenario(scenarios[k], clip, settings);
+
+            std::lock_guard<std::mutex> lock(output_mutex);
+            N_done++;
+            std::cout << "[" << N_done << "/" << N_scenario << "] run " << k << (results[k].stable ? " stable" : " diverged")
+                << ", stretch max " << results[k].stretch_max << ", " << results[k].runtime_ms << " ms" << std::endl;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int k_worker = 0; k_worker < N_worker; ++k_worker)
+        workers.push_back(std::thread(worker, k_worker));
+    for (std::thread& t : workers)
+        t.join();
+
+    return results;
+}
+
+
+// Ranking and output
+// ************************************************************ //
+
+std::vector<int> parameter_sweep_rank(std::vector<parameter_sweep_result>& results, parameter_sweep_settings const& settings)
+{
+    // Best measures among the stable runs (the scores are relative to them)
+    float stretch_best = std::numeric_limits<float>::max();
+    double runtime_best = std::numeric_limits<double>::max();
+    for (parameter_sweep_result const& r : results) {
+        if (r.stable) {
+            stretch_best = std::min(stretch_best, r.stretch_max);
+            runtime_best = std::min(runtime_best, r.runtime_ms);
+        }
+    }
+    stretch_best = std::max(stretch_best, 1e-6f);
+    runtime_best = std::max(runtime_best, 1e-6);
+
+    for (parameter_sweep_result& r : results) {
+        if (r.stable)
+            r.score = settings.weight_stretch * r.stretch_max / stretch_best + settings.weight_runtime * static_cast<float>(r.runtime_ms / runtime_best);
+        else
+            r.score = std::numeric_limits<float>::infinity();
+    }
+
+    std::vector<int> order(results.size());
+    for (int k = 0; k < order.size(); ++k)
+        order[k] = k;
+
+    // The diverged runs are ordered by how long they lasted
+    std::stable_sort(order.begin(), order.end(), [&results](int a, int b) {
+        parameter_sweep_result const& ra = results[a];
+        parameter_sweep_result const& rb = results[b];
+        if (ra.stable != rb.stable)
+            return ra.stable;
+        if (ra.stable)
+            return ra.score < rb.score;
+        return ra.step_diverged > rb.step_diverged;
+    });
+    return order;
+}
+
+bool parameter_sweep_write_csv(std::string const& filename, std::string const& animation, std::vector<parameter_sweep_scenario> const& scenarios, std::vector<parameter_sweep_result> const& results, std::vector<int> const& order)
+{
+    std::ofstream stream(filename);
+    if (!stream.is_open()) {
+        std::cout << "Error: cannot write the sweep results in " << filename << std::endl;
+        return false;
+    }
+
+    stream << "rank,run,score,stable,step_diverged,stretch_max,stretch_mean,speed_max,runtime_ms,ms_per_step,"
+        << "animation,resolution,stencil,substeps,dt,mass_total,K,mu,wind_magnitude,aerodynamics\n";
+    for (int rank = 0; rank < order.size(); ++rank) {
+        int const k = order[rank];
+        parameter_sweep_result const& r = results[k];
+        parameter_sweep_scenario const& s = scenarios[k];
+        stream << rank + 1 << "," << k << "," << r.score << "," << (r.stable ? 1 : 0) << "," << r.step_diverged << ","
+            << r.stretch_max << "," << r.stretch_mean << "," << r.speed_max << "," << r.runtime_ms << "," << r.runtime_ms / std::max(r.N_step, 1) << ","
+            << animation << "," << s.N_sample << "," << s.parameters.stencil << "," << s.substeps << "," << s.parameters.dt << ","
+            << s.parameters.mass_total << "," << s.parameters.K << "," << s.parameters.mu << "," << s.parameters.wind.magnitude << ","
+            << (s.parameters.aerodynamics.active ? 1 : 0) << "\n";
+    }
+    return true;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "cgp/cgp.hpp"
+#include "../simulation/simulation.hpp"
+#include "../cape_rig/cape_rig.hpp"
+
+#include <string>
+#include <vector>
+
+
+// Offline tuning of the cape simulation: the same animation clip is simulated for every combination of parameters of a sweep,
+//  and the runs are ranked on their stability, the stretch of the cloth and their runtime.
+
+
+// One run of a sweep
+struct parameter_sweep_scenario
+{
+    simulation_parameters parameters;
+    int N_sample = 20; // resolution of the cloth
+    int substeps = 1;  // number of integration steps of dt/substeps per time step dt
+};
+
+// Measures of a run
+struct parameter_sweep_result
+{
+    bool stable = true;       // no divergence detected during the run
+    int step_diverged = -1;   // time step at which the simulation diverged
+    float stretch_max = 0.0f; // maximal relative elongation |L-L0|/L0 of the structural springs after the warmup
+    float stretch_mean = 0.0f;// mean relative elongation of the structural springs, averaged over the time steps after the warmup
+    float speed_max = 0.0f;   // maximal speed of a vertex after the warmup (m/s)
+    double runtime_ms = 0.0;  // wall time spent in the simulation (the measures are not counted)
+    int N_step = 0;           // number of simulated time steps
+    float score = 0.0f;       // ranking score, lower is better (see parameter_sweep_rank)
+};
+
+// Settings shared by all the runs of a sweep
+struct parameter_sweep_settings
+{
+    std::string animation = "walk"; // directory of the clip in assets/lola/animation/
+    float duration = 4.0f;          // simulated time of each run (s)
+    float warmup = 1.0f;            // time left to the cape to settle on the character before the stretch and speed are measured (s)
+    int workers = 0;                // number of runs in parallel (0: as many as the cores allow)
+    int threads_per_run = 1;        // cores given to each run
+    float weight_stretch = 1.0f;    // weights of the stretch and of the runtime in the score
+    float weight_runtime = 1.0f;
+};
+
+// Description of a sweep read from a text file
+//  Each line "key = values" gives the values of a parameter, either as a list "v1 v2 v3" or as a range "min:max:count".
+//  The scenarios are the cartesian product of all the values. Lines starting with # are comments.
+struct parameter_sweep_description
+{
+    // Swept values
+    std::vector<int> resolution = { 20 };
+    std::vector<int> stencil = { 24 };
+    std::vector<int> substeps = { 1 };
+    std::vector<float> dt = { 0.005f };
+    std::vector<float> mass_total = { 0.5f };
+    std::vector<float> K = { 5.0f };
+    std::vector<float> mu = { 15.0f };
+    std::vector<float> wind_magnitude = { 0.0f };
+    std::vector<int> aerodynamics = { 0 };
+
+    parameter_sweep_settings settings;
+
+    std::vector<parameter_sweep_scenario> scenarios() const;
+};
+
+
+// Read a sweep description (returns false and prints the error if the file cannot be parsed, or if a value is out of its range:
+//  resolution > 3, stencil 4/8/12/24, substeps >= 1, dt > 0, mass_total > 0, K >= 0, mu >= 0, duration > 0, warmup >= 0)
+bool parameter_sweep_load(std::string const& filename, parameter_sweep_description& description);
+
+// Simulate the cape attached to the clip during the given duration, and measure the run
+parameter_sweep_result parameter_sweep_run_scenario(parameter_sweep_scenario const& scenario, cape_rig_clip const& clip, parameter_sweep_settings const& settings);
+
+// Run all the scenarios on a pool of settings.workers threads, each one pinned to its own settings.threads_per_run cores (on Linux)
+std::vector<parameter_sweep_result> parameter_sweep_run(std::vector<parameter_sweep_scenario> const& scenarios, cape_rig_clip const& clip, parameter_sweep_settings const& settings);
+
+// Fill the scores and return the indices of the runs from the best to the worst
+//  The stable runs come first, ordered by score = weight_stretch * stretch_max/best_stretch_max + weight_runtime * runtime/best_runtime
+std::vector<int> parameter_sweep_rank(std::vector<parameter_sweep_result>& results, parameter_sweep_settings const& settings);
+
+// Write the ranked runs as a CSV table (one line per run, best first)
+bool parameter_sweep_write_csv(std::string const& filename, std::string const& animation, std::vector<parameter_sweep_scenario> const& scenarios, std::vector<parameter_sweep_result> const& results, std::vector<int> const& order);
@@ -0,0 +1,91 @@
+#include "cgp/01_base/base.hpp"
+#include "../parameter_sweep.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+using namespace cgp;
+
+namespace cgp_test {
+
+	// Static clip holding the cape by the arms, the colliders being far below the cloth
+	static cape_rig_clip test_clip()
+	{
+		numarray<mat4> frame;
+		frame.resize(27);
+		for (int k = 0; k < frame.size(); ++k)
+			frame[k] = mat4::build_identity().set_block_translation({ 0.1f * k, -10.0f, 0.0f });
+		frame[16].set_block_translation({ -0.5f, 1.0f, 0.0f }); // arms at the corners of the top side of the cape, shoulders in the middle
+		frame[17].set_block_translation({ 0.5f, 1.0f, 0.0f });
+		frame[11].set_block_translation({ 0.0f, 1.0f, 0.0f });
+		frame[12].set_block_translation({ 0.0f, 1.0f, 0.0f });
+
+		cape_rig_clip clip;
+		clip.name = "static";
+		clip.frames = { frame, frame };
+		return clip;
+	}
+
+	// The sweep runs every combination of parameters, the runs in parallel give the same measures as a run alone,
+	//  and the diverged runs are ranked last
+	void test_parameter_sweep()
+	{
+		parameter_sweep_description description;
+		description.resolution = { 10, 12 };
+		description.K = { 5.0f, 1e4f };
+		description.dt = { 0.01f };
+		std::vector<parameter_sweep_scenario> const scenarios = description.scenarios();
+		assert_cgp_no_msg(scenarios.size() == 4);
+
+		parameter_sweep_settings settings;
+		settings.duration = 0.5f;
+		settings.warmup = 0.1f;
+		settings.workers = 2;
+		settings.weight_runtime = 0.0f;
+
+		cape_rig_clip const clip = test_clip();
+		std::vector<parameter_sweep_result> results = parameter_sweep_run(scenarios, clip, settings);
+		assert_cgp_no_msg(results.size() == scenarios.size());
+
+		for (int k = 0; k < scenarios.size(); ++k) {
+			parameter_sweep_result const alone = parameter_sweep_run_scenario(scenarios[k], clip, settings);
+			assert_cgp_no_msg(alone.stable == results[k].stable);
+			assert_cgp_no_msg(alone.stretch_max == results[k].stretch_max);
+			assert_cgp_no_msg(alone.N_step == results[k].N_step);
+		}
+
+		std::vector<int> const order = parameter_sweep_rank(results, settings);
+		assert_cgp_no_msg(order.size() == results.size());
+		for (int k = 0; k < scenarios.size(); ++k) {
+			bool const stiff = scenarios[k].parameters.K > 100.0f;
+			assert_cgp_no_msg(results[k].stable == !stiff);
+		}
+		for (int rank = 0; rank + 1 < order.size(); ++rank) {
+			parameter_sweep_result const& a = results[order[rank]];
+			parameter_sweep_result const& b = results[order[rank + 1]];
+			assert_cgp_no_msg(a.stable >= b.stable);
+			assert_cgp_no_msg(a.stable == false || b.stable == false || a.score <= b.score);
+		}
+	}
+
+	// A description with a value out of its range is rejected (ex. a zero time step would run no step, and rank the flat cloth first)
+	void test_parameter_sweep_load()
+	{
+		std::string const filename = "test_parameter_sweep.txt";
+		std::vector<std::string> const invalid_lines = { "dt = 0", "dt = -0.01", "mass_total = 0", "K = -1", "mu = 2 -3", "duration = 0", "warmup = -1" };
+		for (std::string const& invalid_line : invalid_lines) {
+			std::ofstream(filename) << "resolution = 10 12\n" << invalid_line << "\n";
+			parameter_sweep_description description;
+			assert_cgp(parameter_sweep_load(filename, description) == false, "The sweep description \"" + invalid_line + "\" should be rejected");
+		}
+
+		std::ofstream(filename) << "resolution = 10 12\ndt = 0.01\nmass_total = 0.2\nK = 0 5\nmu = 0\nduration = 1\nwarmup = 0\n";
+		parameter_sweep_description description;
+		assert_cgp_no_msg(parameter_sweep_load(filename, description));
+		assert_cgp_no_msg(description.scenarios().size() == 4);
+
+		std::remove(filename.c_str());
+	}
+
+}
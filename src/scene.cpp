@@ -12,6 +12,7 @@ using namespace cgp;
 
 
 void initialize_ground(mesh_drawable& ground);
+static constraint_structure constraint_with_collider_detail(constraint_structure const& constraint, int collider_detail);
 
 void scene_structure::initialize()
 {
@@ -32,6 +33,16 @@ void scene_structure::initialize()
 
 	current_active_character = "Lola";
 
+	// Compressed skinning data of the characters that ask for it: the bind pose is only kept in the format read by the skinning kernel
+	for(auto& entry : characters) {
+		if(entry.second.compressed_skinning==false)
+			continue;
+		animated_model_structure& model = entry.second.animated_model;
+		size_t const memory_size = model.memory_size_rigged_mesh();
+		model.compress_skinning();
+		std::cout<<"- Memory of the meshes of "<<entry.first<<": "<<memory_size/1024<<" kB -> "<<model.memory_size_rigged_mesh()/1024<<" kB (compressed skinning)"<<std::endl;
+	}
+
 	for(auto& entry : characters)
 		entry.second.timer.start();
   
@@ -94,149 +105,39 @@ void scene_structure::display_frame()
 	// ********************************** //
 	// Compute Skinning deformation
 	// ********************************** //
-	for(auto& entry_character : characters) {
-		animated_model_structure& animated_model = entry_character.second.animated_model;
-		for(auto& rigged_mesh_entry : animated_model.rigged_mesh) {
-			std::string mesh_name = rigged_mesh_entry.first;
-			animated_model.skinning_lbs(mesh_name);
-		}
+	//  Only the meshes that are displayed, and whose pose changed since their last skinning (the animation is not paused), are deformed.
+	governor.start_phase(frame_phase::skinning);
+	bool const display_mesh = gui.display_surface || gui.display_wireframe;
+	if(display_mesh) {
+		std::vector<animated_model_structure*> animated_models;
+		for(auto& entry_character : characters)
+			animated_models.push_back(&entry_character.second.animated_model);
+		skinning_lbs_parallel(animated_models);
 	}
-
-  // UPDATE POSITION CONSTRAINT FOR CAPE
-  character_structure ch = characters[current_active_character];
-  
-  /*
-   * Joint of index 11 name: mixamorig_LeftShoulder
-   * Joint of index 12 name: mixamorig_RightShoulder
-  */
-  cgp::numarray<mat4> joint_frames = ch.animated_model.skeleton.joint_matrix_global;
-  constraint.fixed_sample.clear();
-
-  const vec3& p_al = joint_frames[16].get_block_translation();
-  const vec3& p_sl = joint_frames[11].get_block_translation();
-  const vec3& p_l = 0.5f * (p_sl - p_al) + p_al;
-
-  const vec3& p_ar = joint_frames[17].get_block_translation();
-  const vec3& p_sr = joint_frames[12].get_block_translation();
-  const vec3& p_r = 0.5f * (p_sr - p_ar) + p_ar;
-
-  constraint.add_fixed_position(0, 0, p_al); 
-  constraint.add_fixed_position(0, (int) (gui.N_sample_edge/4), p_l);
-
-  constraint.add_fixed_position(0, gui.N_sample_edge - 1, p_ar); 
-  constraint.add_fixed_position(0, gui.N_sample_edge - 1 - (int) (gui.N_sample_edge/4), p_r);  
-
-  numarray<int> joint_spheres = {
-    0, // Hips
-    23, // Left elbow
-    24, // Right elbow
-    2, // Left hip
-    3, // Right hip
-    5, // Left knee
-    6 // Right knee
-  };
-
-  numarray<float> joint_radiuses = {
-    0.20, // Hips
-    0.08, // Left elbow
-    0.08, // Right elbow
-    0.15, // Left hip
-    0.15, //Right hip
-    0.12, // Left knee
-    0.12 // Right knee
-  };
-
-  for (int i = 0; i < joint_spheres.size(); i++) {
-    vec3 joint_position = joint_frames[joint_spheres[i]].get_block_translation();
-    float radius = joint_radiuses[i];
-
-    if (i >= constraint.spherical_constraints.size()) {
-      constraint.spherical_constraints.push_back({joint_position, radius}); 
-      continue;
-    }
-
-    constraint.spherical_constraints[i] = {joint_position, radius};
+	governor.stop_phase(frame_phase::skinning);
+
+  // Maximal resolution of the cape: set by the slider, or by the frame governor within the slider value
+  governor.N_sample_max = gui.N_sample_edge;
+  governor.N_sample = std::min(governor.N_sample, governor.N_sample_max);
+  int const N_cloth_max = governor.active ? governor.N_sample : gui.N_sample_edge;
+
+  // Adapt the resolution of the cape to its size on screen (a baked or reduced cape keeps the resolution of its cache or basis)
+  bool const baked = cloth_cache.is_open() || subspace_active;
+  if (lod.active && !baked) {
+    int const N_lod = lod.select_resolution(cloth, environment.camera_projection, environment.camera_view, window.width, window.height, N_cloth_max);
+    if (N_lod != cloth.N_samples())
+      change_cloth_resolution(N_lod);
   }
+  else if (governor.active && !baked && cloth.N_samples() != N_cloth_max)
+    change_cloth_resolution(N_cloth_max);
 
+  // UPDATE POSITION CONSTRAINT FOR CAPE
+  update_cloth_pins();
 
-  numarray<numarray<int>> cylinder_connections = {
-    {11, 23}, // Left arm upper
-    {12, 24}, // Right arm upper
-    {2, 5}, // Left leg upper
-    {3, 6}, // Right leg upper
-    {5, 8}, // Left leg lower
-    {6, 9}, // Right leg lower
-    {23, 25}, // Left arm lower
-    {24, 26}, // Right arm lower
-    {0, 7} // Body
-  };
-  numarray<float> cylinder_radiuses = {
-    0.06, // Left arm upper
-    0.06, // Right arm upper
-    0.12, // Left leg upper
-    0.12, // Right leg upper
-    0.10, // Left leg lower
-    0.10, // Right leg lower
-    0.06, // Left arm lower 
-    0.06, // Right arm lower
-    0.11 // Body 
-  };
-
-  for (int i = 0; i < cylinder_connections.size(); i++) {
-    vec3 start = joint_frames[cylinder_connections[i][0]].get_block_translation();
-    vec3 end = joint_frames[cylinder_connections[i][1]].get_block_translation();
-    float radius = cylinder_radiuses[i];
-
-    if (i >= constraint.cylindrical_constraints.size()) {
-      constraint.cylindrical_constraints.push_back({start, end, radius}); 
-      continue;
-    }
-    
-    constraint.cylindrical_constraints[i] = {start, end, radius};
-  }
-
-
-  /*
-   *Joint at index (0) with name: mixamorig_Hips
-    Joint at index (1) with name: mixamorig_Spine
-  Joint at index (2) with name: mixamorig_LeftUpLeg
-  Joint at index (3) with name: mixamorig_RightUpLeg
-   Joint at index (4) with name: mixamorig_Spine1
-  Joint at index (5) with name: mixamorig_LeftLeg
-  Joint at index (6) with name: mixamorig_RightLeg
-  Joint at index (7) with name: mixamorig_Spine2
-  Joint at index (8) with name: mixamorig_LeftFoot
-  Joint at index (9) with name: mixamorig_RightFoot
-  Joint at index (10) with name: mixamorig_Neck
-  Joint at index (11) with name: mixamorig_LeftShoulder
-  Joint at index (12) with name: mixamorig_RightShoulder
-  Joint at index (13) with name: mixamorig_LeftToeBase
-  Joint at index (14) with name: mixamorig_RightToeBase
-  Joint at index (15) with name: mixamorig_Head
-  Joint at index (16) with name: mixamorig_LeftArm
-  Joint at index (17) with name: mixamorig_RightArm
-  Joint at index (18) with name: mixamorig_LeftToe_End
-  Joint at index (19) with name: mixamorig_RightToe_End
-  Joint at index (20) with name: mixamorig_HeadTop_End
-  Joint at index (21) with name: mixamorig_LeftEye
-  Joint at index (22) with name: mixamorig_RightEye
-  Joint at index (23) with name: mixamorig_LeftForeArm
-  Joint at index (24) with name: mixamorig_RightForeArm
-  Joint at index (25) with name: mixamorig_LeftHand
-  Joint at index (26) with name: mixamorig_RightHan
-  */
-  /*
-   * circle with center at mixamorig_Hips
-   * cylinder from mixamorig_LeftUpLeg to mixamorig_LeftLeg
-   * -"- for right mixamorig_RightLeg
-   *  large cylinder for spine to spine 2
-   *  cylinder for shoulder left to shoulder right
-   *  Smaller cylinders for the arms and fore arms.
-   */
-  // for (int i = 0; i < ch.animated_model.skeleton.joint_name.size(); i++) {
-  //  std::cout << "Joint at index (" << i << ") with name: " << ch.animated_model.skeleton.joint_name[i] << std::endl;
-  //}
+  // Colliders following the body of the active character
+  cape_rig_update_colliders(constraint, characters[current_active_character].animated_model.skeleton.joint_matrix_global);
 
+  governor.start_phase(frame_phase::draw);
   if (constraint.spherical_constraints.size() != obstacle_spheres.size()) {
     for (int i = 0; i < constraint.spherical_constraints.size(); i ++) {
       cgp::mesh_drawable obstacle_sphere;
@@ -287,34 +188,109 @@ void scene_structure::display_frame()
     draw(cylinder_mesh, environment);
   }
 
+  governor.stop_phase(frame_phase::draw);
+
 	// ***************************************** //
-	int const N_step = 1; // Adapt here the number of intermediate simulation steps (ex. 5 intermediate steps per frame)
-	for (int k_step = 0; k_step < N_step; ++k_step)
-	{
-		// Update the forces on each particle
-		simulation_compute_force(cloth, parameters);
-
-		// One step of numerical integration
-		simulation_numerical_integration(cloth, parameters, parameters.dt);
-
-		// Apply the positional (and velocity) constraints
-		simulation_apply_constraints(cloth, constraint);
-
-		// Check if the simulation has not diverged - otherwise stop it
-		bool const simulation_diverged = simulation_detect_divergence(cloth);
-		if (simulation_diverged) {
-			std::cout << "\n *** Simulation has diverged ***" << std::endl;
-			std::cout << " > The simulation is stoped" << std::endl;
+	governor.start_phase(frame_phase::simulation);
+
+	// Colliders seen by the simulation (the frame governor may drop some of them)
+	constraint_structure const constraint_simulated = governor.active ? constraint_with_collider_detail(constraint, governor.collider_detail) : constraint;
+
+	// Turbulent wind: its coarse grid follows the current extent of the cloth
+	if (parameters.wind.field.active) {
+		bounding_box cloth_box;
+		cloth_box.initialize(cloth.position.data);
+		parameters.wind.field.update(inputs.time_interval, parameters.wind.magnitude * parameters.wind.direction, cloth_box.p_min, cloth_box.p_max);
+	}
+
+	int const N_step = governor.active ? governor.substeps : 1; // Number of intermediate simulation steps per frame, each one integrating dt/N_step
+
+	if (subspace_active) {
+		// Reduced-order cape: its dynamics runs at the fixed step of the basis
+		//  Each step sees the pose at its own time, interpolated between the previous and the current frame (as the body inputs of the training runs)
+		numarray<mat4> const& joint_frames = characters[current_active_character].animated_model.skeleton.joint_matrix_global;
+		if (subspace_joint_frames_previous.size() != joint_frames.size())
+			subspace_joint_frames_previous = joint_frames;
+		float const frame_interval = inputs.time_interval;
+		subspace_time += frame_interval;
+		for (int k_step = 0; subspace_time >= subspace_basis.dt && k_step < 4; ++k_step) {
+			subspace_time -= subspace_basis.dt; // the step ends subspace_time before the current frame
+			float const alpha = frame_interval > 0 ? std::min(std::max(1.0f - subspace_time / frame_interval, 0.0f), 1.0f) : 1.0f;
+			subspace_joint_frames_step.resize(joint_frames.size());
+			for (int kj = 0; kj < joint_frames.size(); ++kj)
+				subspace_joint_frames_step[kj] = (1 - alpha) * subspace_joint_frames_previous[kj] + alpha * joint_frames[kj]; // only the translations are used
+			cloth_subspace_step(subspace_state, subspace_basis, subspace_joint_frames_step);
 		}
+		subspace_time = std::min(subspace_time, subspace_basis.dt); // steps dropped after a long frame
+		subspace_joint_frames_previous = joint_frames;
+		governor.stop_phase(frame_phase::simulation);
+
+		governor.start_phase(frame_phase::draw);
+		cloth_subspace_reconstruct(subspace_state, subspace_basis, joint_frames, cloth.position);
+		int const N = subspace_basis.N_sample;
+		subspace_normal.resize(N, N);
+		normal_grid_rows(cloth.position.data.data.data(), subspace_normal.data.data.data(), N, 0, N);
+		cloth_drawable.update(cloth.position, subspace_normal);
+	}
+	else if (baked) {
+		// Playback of the baked cape: the cache holds one cycle relative to its start (see tools/bake), the frame is the one of the local time
+		//  of the animation, decoded in advance by the stream
+		governor.stop_phase(frame_phase::simulation);
+
+		governor.start_phase(frame_phase::draw);
+		int const k_frame = static_cast<int>(characters[current_active_character].timer.t_periodic * cloth_cache.frame_rate());
+		vertex_cache_stream_frame const* frame = cloth_cache.frame(k_frame);
+		if (frame != nullptr && frame->position.size() == cloth.position.size())
+			cloth_drawable.update(frame->position, frame->normal); // otherwise the previous frame remains displayed
 	}
+	else if (simulation_thread.is_running()) {
+		// Hand over the current pose, and display the last state completed by the simulation thread
+		simulation_thread.push_input(constraint_simulated, parameters, N_step);
+		governor.stop_phase(frame_phase::simulation);
+
+		governor.start_phase(frame_phase::draw);
+		simulation_output_structure const& state = simulation_thread.latest_output();
+		if (state.position.size() == cloth.position.size()) {
+			cloth_drawable.update(state.position, state.normal);
+			cloth.position = state.position; // keep the render-side copy up to date (used by the LOD)
+		}
+	}
+	else {
+		float const dt_step = parameters.dt / N_step;
+		for (int k_step = 0; k_step < N_step; ++k_step)
+		{
+			// Update the forces on each particle
+			simulation_compute_force(cloth, parameters, sleeping);
+
+			// One step of numerical integration
+			simulation_numerical_integration(cloth, parameters, dt_step, sleeping);
+
+			// Apply the positional (and velocity) constraints
+			simulation_apply_constraints(cloth, constraint_simulated, sleeping);
+
+			// Put to sleep the tiles at rest, and wake up the ones disturbed by this step
+			sleeping.update(cloth, constraint_simulated, parameters.mass_total / cloth.position.size(), parameters.wind.field.active);
+
+			// Check if the simulation has not diverged - otherwise stop it
+			bool const simulation_diverged = simulation_detect_divergence(cloth);
+			if (simulation_diverged) {
+				std::cout << "\n *** Simulation has diverged ***" << std::endl;
+				std::cout << " > The simulation is stoped" << std::endl;
+			}
 
+			// Compute the new normals (and the aerodynamic forces of the next step)
+			simulation_update_normal(cloth, parameters);
+		}
 
-	// Cloth display
-	// ***************************************** //
 
-	// Prepare to display the updated cloth
-	cloth.update_normal();        // compute the new normals
-	cloth_drawable.update(cloth); // update the positions on the GPU
+		// Cloth display
+		// ***************************************** //
+
+		governor.stop_phase(frame_phase::simulation);
+
+		governor.start_phase(frame_phase::draw);
+		cloth_drawable.update(cloth); // update the positions on the GPU
+	}
 
 	// Display the cloth
 	draw(cloth_drawable, environment);
@@ -329,11 +305,10 @@ void scene_structure::display_frame()
 		// Display meshes
 		for(auto& rigged_mesh_entry : animated_model.rigged_mesh) {
 			std::string mesh_name = rigged_mesh_entry.first;
-			rigged_mesh_structure& rigged_mesh = rigged_mesh_entry.second;
 			
 			mesh_drawable& drawable = character.drawable[mesh_name];
-			drawable.vbo_position.update(rigged_mesh.mesh_deformed.position);
-			drawable.vbo_normal.update(rigged_mesh.mesh_deformed.normal);
+			if(display_mesh)
+				character.update_drawable(mesh_name);
 
 			if(gui.display_surface) {
 				drawable.material.texture_settings.active = gui.display_texture;
@@ -346,14 +321,17 @@ void scene_structure::display_frame()
 
 		// Display skeleton
 		if(gui.display_skeleton) {
-			character.sk_drawable.update(animated_model.skeleton);
+			character.update_sk_drawable();
 			character.sk_drawable.display_joint_frame = gui.display_skeleton_joint_frame;
 			character.sk_drawable.display_joint_sphere = gui.display_skeleton_joint_sphere;
 			character.sk_drawable.display_segments = gui.display_skeleton_bone;
 			draw(character.sk_drawable, environment);
 		}
 	}
+	governor.stop_phase(frame_phase::draw);
 
+	// Adapt the quality settings to the measured frame time
+	governor.update();
 }
 
 
@@ -390,6 +368,9 @@ void scene_structure::display_gui()
 		characters[current_active_character].set_current_animation("Idle");
 		effect_walk.root_position = vec3(0,0,0);
 	}
+	// Handle end of walk in evaluating again the root of the animation (the skeleton of a paused animation is not evaluated at each frame)
+	if(is_walk_clicked && effect_walk.active==false)
+		characters[current_active_character].animated_model.pose_changed();
 
 	ImGui::Spacing(); ImGui::Spacing();
 
@@ -408,6 +389,8 @@ void scene_structure::display_gui()
 		ImVec4 current_color = name==current_active_character? ImVec4(1.0f, 0.0f, 0.0f, 0.5f):ImVec4(0.5f, 0.5f, 1.0f, 0.3f);
 		ImGui::PushStyleColor(ImGuiCol_Button, current_color);
 		if( ImGui::Button(name.c_str()) ) {
+			if(effect_walk.active)
+				characters[current_active_character].animated_model.pose_changed(); // the previous character goes back to its animation root
 			current_active_character = name;
 			// Update the values
 			if(effect_walk.active) {
@@ -428,7 +411,15 @@ void scene_structure::display_gui()
 
 		std::string local_time_txt = "Anim cycle time##"+name;
 		ImGui::SliderFloat(local_time_txt.c_str(), &character.timer.t_periodic, 0.0f, character.timer.event_period);
-				
+
+		// Skinning method of each mesh
+		for(auto& entry_mesh : character.animated_model.rigged_mesh) {
+			std::string dual_quaternion_txt = "Dual quaternion skinning ("+entry_mesh.first+")##"+name;
+			bool dual_quaternion = entry_mesh.second.method==skinning_method::dual_quaternion;
+			if(ImGui::Checkbox(dual_quaternion_txt.c_str(), &dual_quaternion))
+				entry_mesh.second.method = dual_quaternion ? skinning_method::dual_quaternion : skinning_method::linear_blend;
+		}
+
 		// List all possible animations
 		for(auto& entry_anim : character.animated_model.animation) {
 			std::string animation_name = entry_anim.first;
@@ -457,14 +448,116 @@ void scene_structure::display_gui()
 
 	ImGui::Text("Simulation parameters");
 	ImGui::SliderFloat("Time step", &parameters.dt, 0.0001f, 0.02f, "%.4f", 2.0f);
-	ImGui::SliderFloat("Stiffness", &parameters.K, 0.2f, 50.0f, "%.3f", 2.0f);
-	ImGui::SliderFloat("Wind magnitude", &parameters.wind.magnitude, 0, 60, "%.3f", 2.0f);
-	ImGui::SliderFloat("Damping", &parameters.mu, 1.0f, 30.0f);
-	ImGui::SliderFloat("Mass", &parameters.mass_total, 0.2f, 5.0f, "%.3f", 2.0f);
+	bool forces_changed = false; // the tiles at rest under the previous forces are woken up
+	forces_changed |= ImGui::SliderFloat("Stiffness", &parameters.K, 0.2f, 50.0f, "%.3f", 2.0f);
+	ImGui::Text("Springs per vertex"); ImGui::SameLine();
+	forces_changed |= ImGui::RadioButton("4", &parameters.stencil, 4); ImGui::SameLine();
+	forces_changed |= ImGui::RadioButton("8", &parameters.stencil, 8); ImGui::SameLine();
+	forces_changed |= ImGui::RadioButton("12", &parameters.stencil, 12); ImGui::SameLine();
+	forces_changed |= ImGui::RadioButton("24", &parameters.stencil, 24);
+	forces_changed |= ImGui::SliderFloat("Wind magnitude", &parameters.wind.magnitude, 0, 60, "%.3f", 2.0f);
+	forces_changed |= ImGui::Checkbox("Turbulent wind", &parameters.wind.field.active);
+	if (parameters.wind.field.active) {
+		ImGui::Indent();
+		forces_changed |= ImGui::SliderFloat("Turbulence", &parameters.wind.field.turbulence, 0.0f, 2.0f);
+		forces_changed |= ImGui::SliderFloat("Turbulence scale", &parameters.wind.field.scale, 0.05f, 2.0f, "%.3f", 2.0f);
+		ImGui::Unindent();
+	}
+	forces_changed |= ImGui::Checkbox("Aerodynamics", &parameters.aerodynamics.active);
+	if (parameters.aerodynamics.active) {
+		ImGui::Indent();
+		forces_changed |= ImGui::SliderFloat("Drag", &parameters.aerodynamics.drag, 0.0f, 3.0f);
+		forces_changed |= ImGui::SliderFloat("Lift", &parameters.aerodynamics.lift, 0.0f, 3.0f);
+		ImGui::Unindent();
+	}
+	forces_changed |= ImGui::SliderFloat("Damping", &parameters.mu, 1.0f, 30.0f);
+	forces_changed |= ImGui::SliderFloat("Mass", &parameters.mass_total, 0.2f, 5.0f, "%.3f", 2.0f);
+	if (forces_changed)
+		wake_cloth();
 
 	ImGui::Spacing(); ImGui::Spacing();
 
+	// The new resolution is applied when the slider is released (the LOD uses it as its maximal resolution)
 	ImGui::SliderInt("Cloth samples", &gui.N_sample_edge, 4, 80);
+	if (ImGui::IsItemDeactivatedAfterEdit() && lod.active == false)
+		change_cloth_resolution(gui.N_sample_edge);
+	ImGui::SameLine();
+	if (ImGui::Button("Reset cloth"))
+		initialize_cloth(gui.N_sample_edge);
+	ImGui::SliderInt("Render refinement", &gui.render_refinement, 1, 4);
+	if (ImGui::IsItemDeactivatedAfterEdit())
+		change_cloth_resolution(cloth.N_samples());
+	if (ImGui::Button("Save cloth state"))
+		save_cloth_snapshot();
+	ImGui::SameLine();
+	if (ImGui::Button("Load cloth state"))
+		load_cloth_snapshot();
+
+	bool baked = cloth_cache.is_open();
+	if (ImGui::Checkbox("Baked cape", &baked)) {
+		if (baked)
+			play_cloth_cache();
+		else
+			cloth_cache.close();
+	}
+	ImGui::SameLine();
+	bool reduced = subspace_active;
+	if (ImGui::Checkbox("Reduced cape", &reduced)) {
+		if (reduced)
+			play_cloth_subspace();
+		else
+			subspace_active = false;
+	}
+
+	ImGui::Spacing(); ImGui::Spacing();
+
+	bool asynchronous = simulation_thread.is_running();
+	if (ImGui::Checkbox("Asynchronous simulation", &asynchronous)) {
+		if (asynchronous)
+			simulation_thread.start(cloth, sleeping);
+		else
+			simulation_thread.stop(cloth, sleeping);
+	}
+	if (asynchronous) {
+		ImGui::Indent();
+		float rate_hz = simulation_thread.rate_hz.load();
+		if (ImGui::SliderFloat("Simulation rate (Hz)", &rate_hz, 10.0f, 240.0f))
+			simulation_thread.rate_hz.store(rate_hz);
+		std::string const tick_txt = "Tick " + str(simulation_thread.tick.load()) + ": " + str(simulation_thread.tick_ms.load()) + " ms";
+		ImGui::Text("%s", tick_txt.c_str());
+		ImGui::Unindent();
+	}
+
+	ImGui::Spacing(); ImGui::Spacing();
+
+	if (ImGui::Checkbox("Frame governor", &governor.active) && governor.active)
+		governor.N_sample = cloth.N_samples();
+	if (governor.active) {
+		ImGui::Indent();
+		ImGui::SliderFloat("Frame budget (ms)", &governor.budget_ms, 4.0f, 50.0f);
+		for (int k = 0; k < frame_phase_count; ++k) {
+			std::string const phase_txt = frame_phase_name(frame_phase(k)) + ": " + str(governor.phase_ms[k]) + " ms";
+			ImGui::Text("%s", phase_txt.c_str());
+		}
+		std::string const settings_txt = "Substeps: " + str(governor.substeps) + " - Collider detail: " + str(governor.collider_detail) + " - Cloth samples: " + str(governor.N_sample);
+		ImGui::Text("%s", settings_txt.c_str());
+		for (std::string const& decision : governor.log)
+			ImGui::Text("%s", decision.c_str());
+		ImGui::Unindent();
+	}
+
+	ImGui::Spacing(); ImGui::Spacing();
+
+	if (ImGui::Checkbox("Sleeping", &sleeping.active) && sleeping.active == false)
+		wake_cloth();
+	ImGui::SliderFloat("Sleep threshold", &sleeping.energy_threshold, 1e-9f, 1e-5f, "%.2e", 4.0f);
+	ImGui::Checkbox("Cloth LOD", &lod.active); ImGui::SameLine();
+	ImGui::SliderFloat("Pixels per sample", &lod.pixels_per_sample, 2.0f, 20.0f);
+	std::string const lod_txt = "Simulated samples: " + str(cloth.N_samples()) + " (" + str(int(lod.screen_size)) + "px on screen)";
+	ImGui::Text("%s", lod_txt.c_str());
+	float const active_fraction = simulation_thread.is_running() ? simulation_thread.output.read_buffer().active_fraction : sleeping.active_fraction();
+	std::string const active_tiles_txt = "Active tiles: " + str(int(100 * active_fraction)) + "%";
+	ImGui::Text("%s", active_tiles_txt.c_str());
 
 }
 
@@ -493,14 +586,176 @@ void scene_structure::idle_frame()
 // Compute a new cloth in its initial position (can be called multiple times)
 void scene_structure::initialize_cloth(int N_sample)
 {
+	bool const asynchronous = simulation_thread.is_running();
+	if (asynchronous)
+		simulation_thread.stop(cloth, sleeping);
+
 	cloth.initialize(N_sample);
-	cloth_drawable.initialize(N_sample);
+
+	// Warm start from the pre-settled drape of the current animation when one was saved (the current simulation parameters are kept)
+	std::string const snapshot = cloth_snapshot_filename();
+	if (check_file_exist(snapshot)) {
+		simulation_parameters snapshot_parameters;
+		if (cloth_snapshot_load(snapshot, cloth, constraint, snapshot_parameters))
+			std::cout << "Cloth warm-started from " << snapshot << std::endl;
+	}
+
+	change_cloth_resolution(N_sample); // allocate the structures depending on the resolution (resample the snapshot if needed)
+
+	if (asynchronous)
+		simulation_thread.start(cloth, sleeping);
+}
+
+// Change the resolution of the cloth while keeping its current shape (the state is resampled on the new grid)
+//  This is the single place where the structures depending on the cloth resolution are reallocated.
+void scene_structure::change_cloth_resolution(int N_sample)
+{
+	// The simulation thread owns the cloth while it runs: get the cloth back and restart the thread afterwards
+	bool const asynchronous = simulation_thread.is_running();
+	if (asynchronous)
+		simulation_thread.stop(cloth, sleeping);
+
+	cloth.resample(N_sample);
+	sleeping.initialize(N_sample);
+	cloth_drawable.initialize(N_sample, gui.render_refinement);
 	cloth_drawable.drawable.texture = cloth_texture;
 	cloth_drawable.drawable.material.texture_settings.two_sided = true;
+	cloth_drawable.update(cloth);
+
+	// The pins refer to (ku,kv) coordinates of the previous grid
+	update_cloth_pins();
+
+	if (asynchronous)
+		simulation_thread.start(cloth, sleeping);
+}
+
+void scene_structure::wake_cloth()
+{
+	// The simulation thread owns its own copy of the sleeping tiles while it runs
+	if (simulation_thread.is_running())
+		simulation_thread.wake_request.store(true);
+	else
+		sleeping.wake_all();
+}
+
+std::string scene_structure::cloth_snapshot_filename() const
+{
+	std::string animation_name;
+	auto const it = characters.find(current_active_character);
+	if (it != characters.end())
+		animation_name = it->second.current_animation_name;
+	return project::path + "assets/cloth_" + current_active_character + "_" + animation_name + ".cape";
+}
+
+void scene_structure::save_cloth_snapshot()
+{
+	// The simulation thread owns the up-to-date cloth while it runs
+	bool const asynchronous = simulation_thread.is_running();
+	if (asynchronous)
+		simulation_thread.stop(cloth, sleeping);
+
+	std::string const snapshot = cloth_snapshot_filename();
+	if (cloth_snapshot_save(snapshot, cloth, constraint, parameters))
+		std::cout << "Cloth state saved in " << snapshot << std::endl;
 
-	constraint.fixed_sample.clear();
-  //constraint.add_fixed_position(0, 0, cloth);
-  //constraint.add_fixed_position(0, N_sample - 1, cloth);
+	if (asynchronous)
+		simulation_thread.start(cloth, sleeping);
+}
+
+void scene_structure::load_cloth_snapshot()
+{
+	bool const asynchronous = simulation_thread.is_running();
+	if (asynchronous)
+		simulation_thread.stop(cloth, sleeping);
+
+	std::string const snapshot = cloth_snapshot_filename();
+	if (cloth_snapshot_load(snapshot, cloth, constraint, parameters)) {
+		gui.N_sample_edge = cloth.N_samples();
+		change_cloth_resolution(cloth.N_samples()); // reallocate the structures depending on the resolution
+	}
+	else
+		std::cout << "Warning: no cloth state could be loaded from " << snapshot << std::endl;
+
+	if (asynchronous)
+		simulation_thread.start(cloth, sleeping);
+}
+
+std::string scene_structure::cloth_cache_filename() const
+{
+	std::string animation_name;
+	auto const it = characters.find(current_active_character);
+	if (it != characters.end())
+		animation_name = it->second.current_animation_name;
+	return project::path + "assets/cloth_" + current_active_character + "_" + animation_name + ".vtxc";
+}
+
+void scene_structure::play_cloth_cache()
+{
+	// The simulation is not run during the playback
+	if (simulation_thread.is_running())
+		simulation_thread.stop(cloth, sleeping);
+
+	subspace_active = false;
+
+	std::string const filename = cloth_cache_filename();
+	if (!check_file_exist(filename)) {
+		std::cout << "Warning: no baked cape " << filename << " (see tools/bake)" << std::endl;
+		return;
+	}
+	if (!cloth_cache.open(filename))
+		return;
+
+	// The drawable takes the resolution of the cache
+	gui.N_sample_edge = cloth_cache.reader.N_u;
+	if (cloth.N_samples() != gui.N_sample_edge)
+		change_cloth_resolution(gui.N_sample_edge);
+	std::cout << "Play the baked cape " << filename << " (" << cloth_cache.N_frame() << " frames)" << std::endl;
+}
+
+void scene_structure::play_cloth_subspace()
+{
+	// The simulation is not run while the reduced cape is displayed
+	if (simulation_thread.is_running())
+		simulation_thread.stop(cloth, sleeping);
+	cloth_cache.close();
+
+	std::string const filename = project::path + "assets/cloth_Lola.subspace";
+	if (subspace_basis.N_mode == 0 && !cloth_subspace_load(filename, subspace_basis)) {
+		std::cout << "Warning: no reduced cape " << filename << " (see tools/subspace)" << std::endl;
+		return;
+	}
+
+	// The cape takes the resolution of the basis, and starts at rest on the current pose
+	gui.N_sample_edge = subspace_basis.N_sample;
+	if (cloth.N_samples() != gui.N_sample_edge)
+		change_cloth_resolution(gui.N_sample_edge);
+	subspace_state.initialize(subspace_basis, characters[current_active_character].animated_model.skeleton.joint_matrix_global);
+	subspace_joint_frames_previous = characters[current_active_character].animated_model.skeleton.joint_matrix_global;
+	subspace_time = 0.0f;
+	subspace_active = true;
+	std::cout << "Play the reduced cape " << filename << " (" << subspace_basis.N_mode << " modes)" << std::endl;
+}
+
+// Attach the cape to the shoulders and arms of the active character
+void scene_structure::update_cloth_pins()
+{
+  constraint.fixed_sample.clear();
+  if (characters.count(current_active_character) == 0)
+    return;
+
+  cape_rig_update_pins(constraint, characters[current_active_character].animated_model.skeleton.joint_matrix_global, cloth.N_samples());
+}
+
+// Copy of the constraints keeping only the colliders of the requested level of detail
+//  0: hips sphere only, 1: all the spheres, 2: spheres and cylinders
+static constraint_structure constraint_with_collider_detail(constraint_structure const& constraint, int collider_detail)
+{
+	constraint_structure reduced = constraint;
+	if (collider_detail < 2)
+		reduced.cylindrical_constraints.clear();
+	if (collider_detail < 1 && reduced.spherical_constraints.size() > 1)
+		reduced.spherical_constraints.resize(1);
+	return reduced;
 }
 
 void initialize_ground(mesh_drawable& ground) {
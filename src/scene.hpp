@@ -9,6 +9,14 @@
 #include "cloth/cloth.hpp"
 #include "constraint/constraint.hpp"
 #include "simulation/simulation.hpp"
+#include "cloth_sleeping/cloth_sleeping.hpp"
+#include "cloth_lod/cloth_lod.hpp"
+#include "frame_governor/frame_governor.hpp"
+#include "simulation_thread/simulation_thread.hpp"
+#include "cloth_snapshot/cloth_snapshot.hpp"
+#include "cape_rig/cape_rig.hpp"
+#include "vertex_cache/vertex_cache.hpp"
+#include "cloth_subspace/cloth_subspace.hpp"
 #include <vector>
 
 using cgp::mesh_drawable;
@@ -26,6 +34,7 @@ struct gui_parameters {
 	bool display_skeleton_bone = true;
 	bool rotate_head_effect_active = false;
 	int N_sample_edge = 20;
+	int render_refinement = 2; // The cape is drawn with (N_sample_edge-1) x render_refinement cells per edge (see cloth_refinement_structure)
 };
 
 
@@ -36,6 +45,18 @@ struct scene_structure : cgp::scene_inputs_generic {
   cloth_structure cloth;                     // The values of the position, velocity, forces, etc, stored as a 2D grid
 	cloth_structure_drawable cloth_drawable;   // Helper structure to display the cloth as a mesh
   constraint_structure constraint;
+  cloth_sleeping_structure sleeping;         // Tiles of the cloth that are at rest are not simulated
+  cloth_lod_structure lod;                   // Resolution of the cloth simulation depending on its size on screen
+  frame_governor_structure governor;         // Adapts the simulation quality to hold the frame budget
+  simulation_thread_structure simulation_thread; // Optional asynchronous simulation of the cloth
+  vertex_cache_stream_structure cloth_cache;  // Playback of a baked cape (replaces the simulation while it is open)
+  cloth_subspace_basis subspace_basis;        // Reduced-order cape (replaces the simulation while subspace_active)
+  cloth_subspace_state subspace_state;
+  cgp::grid_2D<cgp::vec3> subspace_normal;
+  float subspace_time = 0.0f;                 // time not integrated yet by the reduced dynamics
+  cgp::numarray<cgp::mat4> subspace_joint_frames_previous; // pose of the previous frame (the steps of a frame use the pose interpolated at their time)
+  cgp::numarray<cgp::mat4> subspace_joint_frames_step;
+  bool subspace_active = false;
   
   std::vector<cgp::mesh_drawable> obstacle_cylinders;
   std::vector<cgp::mesh_drawable> obstacle_spheres;
@@ -85,6 +106,17 @@ struct scene_structure : cgp::scene_inputs_generic {
 	void idle_frame();
 
   void initialize_cloth(int N_sample); // Recompute the cloth from scratch
+  void change_cloth_resolution(int N_sample); // Resample the current cloth to a new resolution
+  void update_cloth_pins();            // Attach the cloth to the current skeleton of the active character
+  void wake_cloth();                   // Wake up all the sleeping tiles of the cloth (on the simulation thread when it runs)
+
+  std::string cloth_snapshot_filename() const; // Snapshot of the settled cloth for the active character and animation
+  void save_cloth_snapshot();          // Store the current cloth state (position, velocity, pins, parameters)
+  void load_cloth_snapshot();          // Resume the simulation from the stored cloth state
+
+  std::string cloth_cache_filename() const; // Baked cape of the active character and animation (see tools/bake)
+  void play_cloth_cache();             // Display the baked cape instead of the simulation
+  void play_cloth_subspace();          // Display the reduced-order cape of assets/cloth_Lola.subspace instead of the simulation (see tools/subspace)
 };
 
 
@@ -1,6 +1,9 @@
 #include "simulation.hpp"
+#include "spring_stencil.hpp"
 #include "constraint/constraint.hpp"
 
+#include <algorithm>
+
 using namespace cgp;
 
 #ifdef SOLUTION
@@ -13,6 +16,144 @@ static vec3 spring_force(const vec3& p_i, const vec3& p_j, float L0, float K)
     vec3 const F = -K * (L - L0) * u;
     return F;
 }
+
+// Definitions of the arrays of the stencils (see spring_stencil.hpp)
+int constexpr spring_stencil_4::offset_u[4];
+int constexpr spring_stencil_4::offset_v[4];
+float constexpr spring_stencil_4::alpha[4];
+int constexpr spring_stencil_8::offset_u[8];
+int constexpr spring_stencil_8::offset_v[8];
+float constexpr spring_stencil_8::alpha[8];
+int constexpr spring_stencil_12::offset_u[12];
+int constexpr spring_stencil_12::offset_v[12];
+float constexpr spring_stencil_12::alpha[12];
+int constexpr spring_stencil_24::offset_u[24];
+int constexpr spring_stencil_24::offset_v[24];
+float constexpr spring_stencil_24::alpha[24];
+
+// Values shared by the forces of all the vertices of a call, the springs of the stencil being precomputed:
+//  index offset of each neighbor in the buffers, rest length and stiffness
+template <typename stencil>
+struct force_kernel
+{
+    cloth_block_view cloth;
+    simulation_parameters const* parameters;
+    float m;
+    float mu;
+    float L0;
+    int neighbor_offset[stencil::N_neighbor];
+    float rest_length[stencil::N_neighbor];
+    float stiffness[stencil::N_neighbor];
+
+    force_kernel(cloth_block_view const& cloth_arg, simulation_parameters const& parameters_arg)
+        : cloth(cloth_arg), parameters(&parameters_arg)
+    {
+        int const N = cloth.N;
+        int const N_total = N * N;
+        m = parameters_arg.mass_total / N_total;
+        mu = parameters_arg.mu;
+        L0 = 1.0f / (N - 1.0f);
+        for (int kn = 0; kn < stencil::N_neighbor; ++kn) {
+            float const a = stencil::alpha[kn];
+            neighbor_offset[kn] = stencil::offset_u[kn] + cloth.stride * stencil::offset_v[kn];
+            rest_length[kn] = a * L0;
+            stiffness[kn] = parameters_arg.K / a;
+        }
+    }
+
+    // Force of the vertex (ku,kv). With check_border, the neighbors outside the grid are skipped (vertices closer than
+    //  spring_stencil_reach to the border of the grid), otherwise all the neighbors exist and the loop over them is branch-free.
+    template <bool check_border>
+    void vertex(int ku, int kv) const
+    {
+        int const N = cloth.N;
+        int const offset = cloth.index(ku, kv);
+
+        vec3& f = cloth.force[offset];
+        vec3 const& p = cloth.position[offset];
+        vec3 const& n = cloth.normal[offset];
+
+        // gravity
+        const vec3 g = { 0,-9.81f,0 };
+        f = m * g;
+
+        // damping
+        f += -mu * m * cloth.velocity[offset];
+
+        //wind
+        if (parameters->aerodynamics.active && cloth.aerodynamic_force != nullptr) {
+            f += cloth.aerodynamic_force[offset];
+        }
+        else if (parameters->wind.field.active) {
+            vec3 const wind = parameters->wind.field.sample(p);
+            f += dot(wind, n) * n * L0 * L0;
+        }
+        else {
+            float const coeff = dot(parameters->wind.direction, n);
+            f += parameters->wind.magnitude * coeff * n * L0 * L0;
+        }
+
+        // Spring
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC unroll 24
+#endif
+        for (int kn = 0; kn < stencil::N_neighbor; ++kn) {
+            if (check_border) {
+                int const ku_n = ku + stencil::offset_u[kn];
+                int const kv_n = kv + stencil::offset_v[kn];
+                if (ku_n < 0 || ku_n >= N || kv_n < 0 || kv_n >= N)
+                    continue;
+            }
+            vec3 const& pn = cloth.position[offset + neighbor_offset[kn]];
+            f += spring_force(p, pn, rest_length[kn], stiffness[kn]);
+        }
+    }
+};
+
+// Fill the forces of the vertices in the range [ku_min,ku_max[ x [kv_min,kv_max[ (coordinates in the whole grid)
+//  The force of a vertex only reads the positions of its neighbors (gather only): ranges can be processed in parallel.
+//  The vertices at least spring_stencil_reach away from the borders of the grid take the branch-free path.
+template <typename stencil>
+static void compute_force_range_stencil(cloth_block_view const& cloth, simulation_parameters const& parameters, int ku_min, int ku_max, int kv_min, int kv_max)
+{
+    force_kernel<stencil> const kernel(cloth, parameters);
+
+    int const N = cloth.N;
+    int const inner_min = std::min(std::max(ku_min, spring_stencil_reach), ku_max);
+    int const inner_max = std::max(std::min(ku_max, N - spring_stencil_reach), inner_min);
+    for (int kv = kv_min; kv < kv_max; ++kv) {
+        if (kv < spring_stencil_reach || kv >= N - spring_stencil_reach) {
+            for (int ku = ku_min; ku < ku_max; ++ku)
+                kernel.template vertex<true>(ku, kv);
+            continue;
+        }
+        for (int ku = ku_min; ku < inner_min; ++ku)
+            kernel.template vertex<true>(ku, kv);
+        for (int ku = inner_min; ku < inner_max; ++ku)
+            kernel.template vertex<false>(ku, kv);
+        for (int ku = inner_max; ku < ku_max; ++ku)
+            kernel.template vertex<true>(ku, kv);
+    }
+}
+
+// Kernel of simulation_parameters::stencil (any other value than 4, 8 or 12 uses the 24 neighbors)
+static void compute_force_range(cloth_block_view const& cloth, simulation_parameters const& parameters, int ku_min, int ku_max, int kv_min, int kv_max)
+{
+    switch (parameters.stencil) {
+    case 4: compute_force_range_stencil<spring_stencil_4>(cloth, parameters, ku_min, ku_max, kv_min, kv_max); break;
+    case 8: compute_force_range_stencil<spring_stencil_8>(cloth, parameters, ku_min, ku_max, kv_min, kv_max); break;
+    case 12: compute_force_range_stencil<spring_stencil_12>(cloth, parameters, ku_min, ku_max, kv_min, kv_max); break;
+    default: compute_force_range_stencil<spring_stencil_24>(cloth, parameters, ku_min, ku_max, kv_min, kv_max); break;
+    }
+}
+
+// The aerodynamic forces are computed at the end of each step with the normals: compute them on the current state
+//  when the previous step did not (aerodynamics just enabled, new or resampled cloth), instead of using outdated forces
+static void update_aerodynamic_force_if_needed(cloth_structure& cloth, simulation_parameters const& parameters)
+{
+    if (parameters.aerodynamics.active && cloth.aerodynamic_force_valid == false)
+        simulation_update_normal(cloth, parameters);
+}
 #endif
 
 
@@ -23,6 +164,17 @@ static vec3 spring_force(const vec3& p_i, const vec3& p_j, float L0, float K)
 // - Wind force
 void simulation_compute_force(cloth_structure& cloth, simulation_parameters const& parameters)
 {
+#ifdef SOLUTION
+    update_aerodynamic_force_if_needed(cloth, parameters);
+    int const N = cloth.N_samples(); // number of vertices in one dimension of the grid
+    cloth_block_view const view = block_view(cloth.grid_view());
+
+// Use #prgam omp parallel for - for parallel loops
+#pragma omp parallel for
+    for (int kv = 0; kv < N; ++kv)
+        compute_force_range(view, parameters, 0, N, kv, kv + 1);
+
+#else
     // Direct access to the variables
     //  Note: A grid_2D is a structure you can access using its 2d-local index coordinates as grid_2d(k1,k2)
     //   The index corresponding to grid_2d(k1,k2) is k1 + N1*k2, with N1 the first dimension of the grid.
@@ -44,72 +196,6 @@ void simulation_compute_force(cloth_structure& cloth, simulation_parameters cons
     float const mu = parameters.mu;            // damping/friction coefficient
     float const	L0 = 1.0f / (N - 1.0f);        // rest length between two direct neighboring particle
 
-#ifdef SOLUTION
-//#define N_neighbor 4
-//    static const int offset_u[N_neighbor] = { -1,1,0,0 };
-//    static const int offset_v[N_neighbor] = { 0,0,-1,1 };
-//    static const float alpha[N_neighbor] = { 1,1,1,1 };
-
-//#define N_neighbor 8
-//    static const int offset_u[N_neighbor] = { -1,1,0,0, -1,-1,1,1 };
-//    static const int offset_v[N_neighbor] = { 0,0,-1,1, -1,1,-1,1 };
-//    static const float alpha[N_neighbor] = { 1,1,1,1, sqrtf(2),sqrtf(2),sqrtf(2),sqrtf(2) };
-
-//#define N_neighbor 12
-//    static const int offset_u[N_neighbor] = { -1,1,0,0, -1,-1,1,1, 2,-2,0,0 };
-//    static const int offset_v[N_neighbor] = { 0,0,-1,1, -1,1,-1,1, 0,0,2,-2 };
-//    static const float alpha[N_neighbor] = { 1,1,1,1, sqrtf(2),sqrtf(2),sqrtf(2),sqrtf(2), 2,2,2,2 };
-
-#define N_neighbor 24
-    static const int offset_u[24] = { 2,2,2,2,2, 1,1,1,1,1, 0,0,0,0, -1,-1,-1,-1,-1, -2,-2,-2,-2,-2 };
-    static const int offset_v[24] = { 2,1,0,-1,-2, 2,1,0,-1,-2, 2,1,-1,-2, 2,1,0,-1,-2, 2,1,0,-1,-2 };
-    static const float alpha[24] = { sqrtf(8.0f), sqrtf(5),2,sqrtf(5),sqrtf(8), sqrtf(5),sqrtf(2),1,sqrtf(2),sqrtf(5), 2,1,1,2, sqrtf(5),sqrtf(2),1,sqrtf(2),sqrtf(5), sqrtf(8),sqrtf(5),2,sqrtf(5),sqrtf(8) };
-
-    const vec3 g = { 0,-9.81f,0 };
-
-// Use #prgam omp parallel for - for parallel loops
-#pragma omp parallel for
-    for (int k = 0; k < N_total; ++k)
-    {
-        vec3& f = force.at(k);
-        vec3 const& n = cloth.normal.at(k);
-
-        // gravity
-        f = m * g; 
-
-        // damping
-        f += -mu * m * velocity.at(k);
-
-        //wind
-        float const coeff = dot(parameters.wind.direction, n);
-        f += parameters.wind.magnitude * coeff * n * L0 * L0;
-    }
-
-    // Spring
-#pragma omp parallel for
-    for (int kv = 0; kv < N; ++kv){
-        for (int ku = 0; ku < N; ++ku){
-            int const offset = ku + N * kv;
-
-            vec3& f = force.at(offset);
-            vec3 const& p = position.at(offset);
-
-            for (int kn = 0; kn < N_neighbor; ++kn) {
-                int const ku_n = ku + offset_u[kn];
-                int const kv_n = kv + offset_v[kn];
-                if (ku_n >= 0 && ku_n < N && kv_n >= 0 && kv_n < N)
-                {
-                    float const a = alpha[kn];
-                    int const offset_neighbor = ku_n + N * kv_n;
-                    vec3 const& pn = position.at(offset_neighbor);
-
-                    f += spring_force(p, pn, a * L0, K / a);
-                }
-            }
-        }
-    }
-
-#else
 
     // Gravity
     const vec3 g = { 0,0,-9.81f };
@@ -141,137 +227,372 @@ void simulation_compute_force(cloth_structure& cloth, simulation_parameters cons
 #endif
 }
 
+// Semi-implicit integration of the vertices in the range [ku_min,ku_max[ x [kv_min,kv_max[
+static void numerical_integration_range(cloth_block_view const& cloth, float m, float dt, int ku_min, int ku_max, int kv_min, int kv_max)
+{
+    for (int kv = kv_min; kv < kv_max; ++kv) {
+        for (int ku = ku_min; ku < ku_max; ++ku) {
+            int const offset = cloth.index(ku, kv);
+            vec3& v = cloth.velocity[offset];
+            vec3& p = cloth.position[offset];
+            vec3 const& f = cloth.force[offset];
+
+            // Standard semi-implicit numerical integration
+            v = v + dt * f / m;
+            p = p + dt * v;
+        }
+    }
+}
+
 void simulation_numerical_integration(cloth_structure& cloth, simulation_parameters const& parameters, float dt)
 {
     int const N = cloth.N_samples();
     int const N_total = cloth.position.size();
     float const m = parameters.mass_total/ static_cast<float>(N_total);
 
-    for (int ku = 0; ku < N; ++ku) {
-        for (int kv = 0; kv < N; ++kv) {
-            vec3& v = cloth.velocity(ku, kv);
-            vec3& p = cloth.position(ku, kv);
-            vec3 const& f = cloth.force(ku, kv);
+    numerical_integration_range(block_view(cloth.grid_view()), m, dt, 0, N, 0, N);
+}
 
-            // Standard semi-implicit numerical integration
-            v = v + dt * f / m;
-            p = p + dt * v;
+
+#ifdef SOLUTION
+// Collision of a vertex with the ground, the spheres and the cylinders
+static void apply_collision_vertex(vec3& p, vec3& v, constraint_structure const& constraint)
+{
+    const float epsilon = 1e-2f;
+
+    // Ground constraint
+    {
+      if (p.y <= constraint.ground_y + epsilon) {
+        p.y = constraint.ground_y + epsilon;
+        v.y = 0.0f;
+      }
+    }
+
+    // Sphere constraint
+    {
+      for (sphere_parameter sphere : constraint.spherical_constraints) {
+        vec3 const& p0 = sphere.center;
+        float const r = sphere.radius;
+        if (norm(p - p0) < (r + epsilon))
+        {
+            const vec3 u = normalize(p - p0);
+            p = (r + epsilon) * u + p0;
+            v = v - dot(v, u) * u;
         }
+      }
+    }
+
+    // Cylinder constraints
+    {
+      for (cylinder_parameter cylinder : constraint.cylindrical_constraints) {
+        vec3 const& p0 = cylinder.positionStart;
+        vec3 const& p1 = cylinder.positionEnd;
+        float const r = cylinder.radius;
+
+        vec3 const p0_to_cape = p - p0;
+        vec3 const p1_to_cape = p - p1;
+        vec3 const p01 = p1 - p0;
+        vec3 const p10 = -1.0 * p01;
+
+        float const d = norm(p01);
+
+        vec3 const p0cape_proj = (dot(p0_to_cape, p01) / dot(p01, p01)) * p01;
+        vec3 const p1cape_proj = (dot(p1_to_cape, p10) / dot(p10, p10)) * p10;
+        
+
+        if (norm(p0cape_proj) > d || norm(p1cape_proj) > d) {
+          continue;
+        }
+
+        vec3 const norm_proj = p0_to_cape - p0cape_proj;
+        
+        if (norm(norm_proj) < (r + epsilon)) {
+          const vec3 u = normalize(norm_proj);
+          p = (r + epsilon) * u + (p0cape_proj + p0);
+          v = v - dot(v, u) * u;
+        }
+      }
     }
-    
 }
+#endif
 
-void simulation_apply_constraints(cloth_structure& cloth, constraint_structure const& constraint)
+// Fixed positions of the cloth
+static void apply_fixed_positions(cloth_structure& cloth, constraint_structure const& constraint)
 {
-
-    // Fixed positions of the cloth
     for (auto const& it : constraint.fixed_sample) {
         position_contraint c = it.second;
         cloth.position(c.ku, c.kv) = c.position; // set the position to the fixed one
     }
+}
+
+void simulation_apply_constraints(cloth_structure& cloth, constraint_structure const& constraint)
+{
+    apply_fixed_positions(cloth, constraint);
 
 #ifdef SOLUTION
     const int N = cloth.position.size();
-    const float epsilon = 1e-2f;
 #pragma omp parallel for
     for (int k = 0; k < N; ++k)
     {
         vec3& p = cloth.position.data.at_unsafe(k);
         vec3& v = cloth.velocity.data.at_unsafe(k);
+        apply_collision_vertex(p, v, constraint);
+    }
 
-        // Ground constraint
-        {
-          if (p.y <= constraint.ground_y + epsilon) {
-            p.y = constraint.ground_y + epsilon;
-            v.y = 0.0f;
-          }
-        }
+#else
+    // To do: apply external constraints
+    // For all vertex:
+    //   If vertex is below floor level ...
+    //   If vertex is inside collision sphere ...
+#endif
+}
 
-        // Sphere constraint
-        {
-          for (sphere_parameter sphere : constraint.spherical_constraints) {
-            vec3 const& p0 = sphere.center;
-            float const r = sphere.radius;
-            if (norm(p - p0) < (r + epsilon))
-            {
-                const vec3 u = normalize(p - p0);
-                p = (r + epsilon) * u + p0;
-                v = v - dot(v, u) * u;
-            }
-          }
-        }
 
-        // Cylinder constraints
-        {
-          for (cylinder_parameter cylinder : constraint.cylindrical_constraints) {
-            vec3 const& p0 = cylinder.positionStart;
-            vec3 const& p1 = cylinder.positionEnd;
-            float const r = cylinder.radius;
+void simulation_compute_force(cloth_structure& cloth, simulation_parameters const& parameters, cloth_sleeping_structure const& sleeping)
+{
+#ifdef SOLUTION
+    update_aerodynamic_force_if_needed(cloth, parameters);
+    int const N_awake = sleeping.awake_tiles.size();
+    cloth_block_view const view = block_view(cloth.grid_view());
+#pragma omp parallel for
+    for (int k = 0; k < N_awake; ++k) {
+        int ku_min, ku_max, kv_min, kv_max;
+        sleeping.tile_range(sleeping.awake_tiles[k], ku_min, ku_max, kv_min, kv_max);
+        compute_force_range(view, parameters, ku_min, ku_max, kv_min, kv_max);
+    }
+#else
+    (void)sleeping;
+    simulation_compute_force(cloth, parameters);
+#endif
+}
 
-            vec3 const p0_to_cape = p - p0;
-            vec3 const p1_to_cape = p - p1;
-            vec3 const p01 = p1 - p0;
-            vec3 const p10 = -1.0 * p01;
+void simulation_numerical_integration(cloth_structure& cloth, simulation_parameters const& parameters, float dt, cloth_sleeping_structure const& sleeping)
+{
+    int const N_total = cloth.position.size();
+    float const m = parameters.mass_total / static_cast<float>(N_total);
 
-            float const d = norm(p01);
+    int const N_awake = sleeping.awake_tiles.size();
+    cloth_block_view const view = block_view(cloth.grid_view());
+#pragma omp parallel for
+    for (int k = 0; k < N_awake; ++k) {
+        int ku_min, ku_max, kv_min, kv_max;
+        sleeping.tile_range(sleeping.awake_tiles[k], ku_min, ku_max, kv_min, kv_max);
+        numerical_integration_range(view, m, dt, ku_min, ku_max, kv_min, kv_max);
+    }
+}
 
-            vec3 const p0cape_proj = (dot(p0_to_cape, p01) / dot(p01, p01)) * p01;
-            vec3 const p1cape_proj = (dot(p1_to_cape, p10) / dot(p10, p10)) * p10;
-            
+void simulation_apply_constraints(cloth_structure& cloth, constraint_structure const& constraint, cloth_sleeping_structure const& sleeping)
+{
+    apply_fixed_positions(cloth, constraint);
 
-            if (norm(p0cape_proj) > d || norm(p1cape_proj) > d) {
-              continue;
-            }
+#ifdef SOLUTION
+    int const N_awake = sleeping.awake_tiles.size();
+#pragma omp parallel for
+    for (int k = 0; k < N_awake; ++k) {
+        int ku_min, ku_max, kv_min, kv_max;
+        sleeping.tile_range(sleeping.awake_tiles[k], ku_min, ku_max, kv_min, kv_max);
+        for (int kv = kv_min; kv < kv_max; ++kv)
+            for (int ku = ku_min; ku < ku_max; ++ku)
+                apply_collision_vertex(cloth.position(ku, kv), cloth.velocity(ku, kv), constraint);
+    }
+#else
+    (void)sleeping;
+#endif
+}
 
-            vec3 const norm_proj = p0_to_cape - p0cape_proj;
-            
-            if (norm(norm_proj) < (r + epsilon)) {
-              const vec3 u = normalize(norm_proj);
-              p = (r + epsilon) * u + (p0cape_proj + p0);
-              v = v - dot(v, u) * u;
-            }
-          }
+
+
+void simulation_compute_force(cloth_grid_view const& cloth, simulation_parameters const& parameters, int kv_min, int kv_max)
+{
+#ifdef SOLUTION
+    compute_force_range(block_view(cloth), parameters, 0, cloth.N, kv_min, kv_max);
+#else
+    (void)cloth; (void)parameters; (void)kv_min; (void)kv_max;
+#endif
+}
+
+void simulation_numerical_integration(cloth_grid_view const& cloth, simulation_parameters const& parameters, float dt, int kv_min, int kv_max)
+{
+    float const m = parameters.mass_total / static_cast<float>(cloth.N * cloth.N);
+    numerical_integration_range(block_view(cloth), m, dt, 0, cloth.N, kv_min, kv_max);
+}
+
+void simulation_apply_collisions(cloth_grid_view const& cloth, constraint_structure const& constraint, int kv_min, int kv_max)
+{
+#ifdef SOLUTION
+    for (int k = cloth.N * kv_min; k < cloth.N * kv_max; ++k)
+        apply_collision_vertex(cloth.position[k], cloth.velocity[k], constraint);
+#else
+    (void)cloth; (void)constraint; (void)kv_min; (void)kv_max;
+#endif
+}
+
+
+void simulation_compute_force(cloth_block_view const& block, simulation_parameters const& parameters, int ku_min, int ku_max, int kv_min, int kv_max)
+{
+#ifdef SOLUTION
+    compute_force_range(block, parameters, ku_min, ku_max, kv_min, kv_max);
+#else
+    (void)block; (void)parameters; (void)ku_min; (void)ku_max; (void)kv_min; (void)kv_max;
+#endif
+}
+
+void simulation_numerical_integration(cloth_block_view const& block, simulation_parameters const& parameters, float dt, int ku_min, int ku_max, int kv_min, int kv_max)
+{
+    float const m = parameters.mass_total / static_cast<float>(block.N * block.N);
+    numerical_integration_range(block, m, dt, ku_min, ku_max, kv_min, kv_max);
+}
+
+void simulation_apply_collisions(cloth_block_view const& block, constraint_structure const& constraint, int ku_min, int ku_max, int kv_min, int kv_max)
+{
+#ifdef SOLUTION
+    for (int kv = kv_min; kv < kv_max; ++kv) {
+        for (int ku = ku_min; ku < ku_max; ++ku) {
+            int const offset = block.index(ku, kv);
+            apply_collision_vertex(block.position[offset], block.velocity[offset], constraint);
         }
     }
-
 #else
-    // To do: apply external constraints
-    // For all vertex:
-    //   If vertex is below floor level ...
-    //   If vertex is inside collision sphere ...
+    (void)block; (void)constraint; (void)ku_min; (void)ku_max; (void)kv_min; (void)kv_max;
 #endif
 }
 
+// Drag and lift exerted on a triangle of area A and unit normal n by the relative air velocity u
+//  The drag is along u, the lift is orthogonal to u in the plane (u,n). Both vanish for a triangle aligned with the flow.
+static vec3 aerodynamic_force_triangle(vec3 const& u, vec3 const& n, float A, simulation_parameters const& parameters)
+{
+    float const speed = norm(u);
+    if (speed < 1e-6f)
+        return { 0,0,0 };
+
+    vec3 const u_unit = u / speed;
+    float const cos_theta = std::abs(dot(n, u_unit));
+    vec3 const n_flow = dot(n, u_unit) >= 0 ? n : -n; // normal oriented along the flow
+
+    float const pressure = 0.5f * parameters.aerodynamics.air_density * speed * speed * A * cos_theta;
+    vec3 const drag = parameters.aerodynamics.drag * pressure * u_unit;
+    vec3 const lift = parameters.aerodynamics.lift * pressure * (n_flow - cos_theta * u_unit); // norm of (n_flow - cos u) is sin(theta)
+    return drag + lift;
+}
 
+void simulation_update_normal(cloth_structure& cloth, simulation_parameters const& parameters)
+{
+    // Without aerodynamics, the triangles are not needed: use the grid normals from central differences
+    if (parameters.aerodynamics.active == false) {
+        cloth.update_normal_grid();
+        cloth.aerodynamic_force_valid = false;
+        return;
+    }
 
-bool simulation_detect_divergence(cloth_structure const& cloth)
+    int const N_triangle = cloth.triangle_connectivity.size();
+    int const N_vertex = cloth.position.size();
+    vec3 const wind_uniform = parameters.wind.magnitude * parameters.wind.direction;
+
+    // Per-triangle normal (same computation as normal_per_vertex), and aerodynamic force
+#pragma omp parallel for
+    for (int k_tri = 0; k_tri < N_triangle; ++k_tri) {
+        uint3 const& face = cloth.triangle_connectivity[k_tri];
+        vec3 const& p0 = cloth.position.data[face[0]];
+        vec3 const& p1 = cloth.position.data[face[1]];
+        vec3 const& p2 = cloth.position.data[face[2]];
+
+        vec3 const p10 = p1 - p0;
+        vec3 const p20 = p2 - p0;
+        float const L10 = norm(p10);
+        float const L20 = norm(p20);
+
+        vec3 n_unit = { 0,0,0 };
+        float area = 0.0f;
+        if (L10 > 1e-6f && L20 > 1e-6f) {
+            vec3 const n = cross(p10 / L10, p20 / L20);
+            float const Ln = norm(n);
+            if (Ln > 1e-6f) {
+                n_unit = n / Ln;
+                area = 0.5f * Ln * L10 * L20;
+            }
+        }
+        cloth.triangle_normal[k_tri] = n_unit;
+
+        vec3 const center = (p0 + p1 + p2) / 3.0f;
+        vec3 const v = (cloth.velocity.data[face[0]] + cloth.velocity.data[face[1]] + cloth.velocity.data[face[2]]) / 3.0f;
+        vec3 const wind = parameters.wind.field.active ? parameters.wind.field.sample(center) : wind_uniform;
+        cloth.triangle_aerodynamic_force[k_tri] = aerodynamic_force_triangle(wind - v, n_unit, area, parameters);
+    }
+
+    // Gather on the vertices: each vertex only writes its own values
+#pragma omp parallel for
+    for (int k = 0; k < N_vertex; ++k) {
+        vec3 n = { 0,0,0 };
+        vec3 f = { 0,0,0 };
+        for (int i = cloth.vertex_triangle_offset[k]; i < cloth.vertex_triangle_offset[k + 1]; ++i) {
+            int const k_tri = cloth.vertex_triangle[i];
+            n += cloth.triangle_normal[k_tri];
+            f += cloth.triangle_aerodynamic_force[k_tri];
+        }
+
+        float const L = norm(n);
+        if (L > 1e-6f)
+            n /= L;
+        cloth.normal.data[k] = n;
+        cloth.aerodynamic_force.data[k] = f / 3.0f;
+    }
+    cloth.aerodynamic_force_valid = true;
+}
+
+
+// Check the force and position of the vertex of index k, and print the reason of the divergence when verbose is set
+static bool detect_divergence_vertex(cloth_structure const& cloth, int k, bool verbose)
 {
     bool simulation_diverged = false;
-    const size_t N = cloth.position.size();
-    for (size_t k = 0; simulation_diverged == false && k < N; ++k)
-    {
-        const float f = norm(cloth.force.data.at_unsafe(k));
-        const vec3& p = cloth.position.data.at_unsafe(k);
+    const float f = norm(cloth.force.data.at_unsafe(k));
+    const vec3& p = cloth.position.data.at_unsafe(k);
 
-        if (std::isnan(f)) // detect NaN in force
-        {
+    if (std::isnan(f)) // detect NaN in force
+    {
+        if (verbose)
             std::cout << "\n **** NaN detected in forces" << std::endl;
-            simulation_diverged = true;
-        }
+        simulation_diverged = true;
+    }
 
-        if (f > 600.0f) // detect strong force magnitude
-        {
+    if (f > 600.0f) // detect strong force magnitude
+    {
+        if (verbose)
             std::cout << "\n **** Warning : Strong force magnitude detected " << f << " at vertex " << k << " ****" << std::endl;
-            simulation_diverged = true;
-        }
+        simulation_diverged = true;
+    }
 
-        if (std::isnan(p.x) || std::isnan(p.y) || std::isnan(p.z)) // detect NaN in position
-        {
+    if (std::isnan(p.x) || std::isnan(p.y) || std::isnan(p.z)) // detect NaN in position
+    {
+        if (verbose)
             std::cout << "\n **** NaN detected in positions" << std::endl;
-            simulation_diverged = true;
-        }
+        simulation_diverged = true;
     }
 
     return simulation_diverged;
 }
 
+bool simulation_detect_divergence(cloth_structure const& cloth)
+{
+    int const N = cloth.N_samples();
+
+    // Each row looks for its first diverging vertex, the rows are then combined in index order:
+    //  the reported vertex is the first one of the grid whatever the number of threads.
+    numarray<int> first_diverged;
+    first_diverged.resize(N);
+    first_diverged.fill(-1);
+
+#pragma omp parallel for
+    for (int kv = 0; kv < N; ++kv) {
+        for (int ku = 0; first_diverged[kv] == -1 && ku < N; ++ku) {
+            int const k = ku + N * kv;
+            if (detect_divergence_vertex(cloth, k, false))
+                first_diverged[kv] = k;
+        }
+    }
+
+    for (int kv = 0; kv < N; ++kv) {
+        if (first_diverged[kv] != -1)
+            return detect_divergence_vertex(cloth, first_diverged[kv], true);
+    }
+    return false;
+}
@@ -3,6 +3,8 @@
 #include "cgp/cgp.hpp"
 #include "../cloth/cloth.hpp"
 #include "../constraint/constraint.hpp"
+#include "../cloth_sleeping/cloth_sleeping.hpp"
+#include "../wind_field/wind_field.hpp"
 
 
 struct simulation_parameters
@@ -11,15 +13,32 @@ struct simulation_parameters
     float mass_total = 0.5f; // total mass of the cloth
     float K = 5.0f;         // stiffness parameter
     float mu = 15.0f;        // damping parameter
+    int stencil = 24;        // number of neighbors linked by a spring to each vertex: 4 (structural), 8 (+shear), 12 (+bending) or 24
 
     //  Wind magnitude and direction
     struct {
         float magnitude = 0.0f;
         cgp::vec3 direction = { 0,-1,0 };
+        wind_field_structure field; // Optional turbulent wind around magnitude*direction (updated by the caller)
     } wind;
+
+    // Aerodynamic model: drag and lift of each triangle in the air flow relative to the cloth
+    //  When active, it replaces the wind force along the vertex normals (the wind magnitude is then the air speed in m/s).
+    struct {
+        bool active = false;
+        float air_density = 1.2f; // kg/m^3
+        float drag = 1.0f;        // drag coefficient
+        float lift = 0.5f;        // lift coefficient
+    } aerodynamics;
 };
 
 
+// Determinism
+//  The parallel loops split the grid in a fixed decomposition (rows of the grid, or the tiles of cloth_sleeping_structure)
+//  that does not depend on the number of threads. Each vertex only writes its own force/velocity/position (gather only),
+//  and the reductions are combined in index order: the results are bitwise identical for any number of threads.
+
+
 // Fill the forces in the cloth given the position and velocity
 void simulation_compute_force(cloth_structure& cloth, simulation_parameters const& parameters);
 
@@ -29,5 +48,35 @@ void simulation_numerical_integration(cloth_structure& cloth, simulation_paramet
 // Apply the constraints (fixed position, obstacles) on the cloth position and velocity
 void simulation_apply_constraints(cloth_structure& cloth, constraint_structure const& constraint);
 
+// Update the normals of the cloth
+//  - Without aerodynamics: grid normals from central differences (cloth_structure::update_normal_grid)
+//  - With aerodynamics: parallel pass over the triangles that computes their normal, and their drag and lift (true area and normal,
+//    air velocity relative to the triangle). Both are gathered on the vertices, the forces in cloth.aerodynamic_force used by the next force computation.
+//  The force computation of a cloth_structure calls it first when the aerodynamic forces were not computed by the previous step (ex. aerodynamics just enabled).
+void simulation_update_normal(cloth_structure& cloth, simulation_parameters const& parameters);
+
 // Helper function that tries to detect if the simulation diverged 
-bool simulation_detect_divergence(cloth_structure const& cloth);
\ No newline at end of file
+//  The reported vertex is the first diverging one in index order.
+bool simulation_detect_divergence(cloth_structure const& cloth);
+
+
+// Same steps restricted to the tiles of the cloth that are awake (see cloth_sleeping_structure)
+//  The vertices of the sleeping tiles keep their position, and a zero velocity and force.
+void simulation_compute_force(cloth_structure& cloth, simulation_parameters const& parameters, cloth_sleeping_structure const& sleeping);
+void simulation_numerical_integration(cloth_structure& cloth, simulation_parameters const& parameters, float dt, cloth_sleeping_structure const& sleeping);
+void simulation_apply_constraints(cloth_structure& cloth, constraint_structure const& constraint, cloth_sleeping_structure const& sleeping);
+
+
+// Same steps on the rows [kv_min,kv_max[ of a cloth given as a view on its buffers (building blocks of the batched simulation, see cloth_batch_structure)
+//  The fixed positions are not applied by simulation_apply_collisions, and the wind uses the vertex normals when no aerodynamic force is given.
+void simulation_compute_force(cloth_grid_view const& cloth, simulation_parameters const& parameters, int kv_min, int kv_max);
+void simulation_numerical_integration(cloth_grid_view const& cloth, simulation_parameters const& parameters, float dt, int kv_min, int kv_max);
+void simulation_apply_collisions(cloth_grid_view const& cloth, constraint_structure const& constraint, int kv_min, int kv_max);
+
+
+// Same steps on the vertices [ku_min,ku_max[ x [kv_min,kv_max[ (coordinates in the whole grid) of a block of a larger grid (building blocks of
+//  the distributed simulation, see cloth_distributed_block). The force of a vertex reads the positions of its neighbors up to 2 vertices away,
+//  the block must store them.
+void simulation_compute_force(cloth_block_view const& block, simulation_parameters const& parameters, int ku_min, int ku_max, int kv_min, int kv_max);
+void simulation_numerical_integration(cloth_block_view const& block, simulation_parameters const& parameters, float dt, int ku_min, int ku_max, int kv_min, int kv_max);
+void simulation_apply_collisions(cloth_block_view const& block, constraint_structure const& constraint, int ku_min, int ku_max, int kv_min, int kv_max);
@@ -0,0 +1,44 @@
+#pragma once
+
+
+// Spring stencils of the cloth: offsets (offset_u,offset_v) of the neighbors of a vertex, and ratio alpha between their rest length and L0
+//  4: structural springs, 8: + shear springs, 12: + bending springs, 24: all the neighbors at distance at most 2 along u and v
+// Each stencil is a type: the force kernels are instantiated for each of them, with a constant number of neighbors (fully unrolled loop).
+//  The arrays are defined in simulation.cpp.
+
+// Maximal distance along u or v between a vertex and its neighbors: the vertices closer to the border of the grid have missing neighbors
+int constexpr spring_stencil_reach = 2;
+
+struct spring_stencil_4
+{
+    static int constexpr N_neighbor = 4;
+    static int constexpr offset_u[4] = { -1,1,0,0 };
+    static int constexpr offset_v[4] = { 0,0,-1,1 };
+    static float constexpr alpha[4] = { 1,1,1,1 };
+};
+
+struct spring_stencil_8
+{
+    static int constexpr N_neighbor = 8;
+    static int constexpr offset_u[8] = { -1,1,0,0, -1,-1,1,1 };
+    static int constexpr offset_v[8] = { 0,0,-1,1, -1,1,-1,1 };
+    static float constexpr alpha[8] = { 1,1,1,1, 1.41421356f,1.41421356f,1.41421356f,1.41421356f };
+};
+
+struct spring_stencil_12
+{
+    static int constexpr N_neighbor = 12;
+    static int constexpr offset_u[12] = { -1,1,0,0, -1,-1,1,1, 2,-2,0,0 };
+    static int constexpr offset_v[12] = { 0,0,-1,1, -1,1,-1,1, 0,0,2,-2 };
+    static float constexpr alpha[12] = { 1,1,1,1, 1.41421356f,1.41421356f,1.41421356f,1.41421356f, 2,2,2,2 };
+};
+
+// The sqrt(2), sqrt(5) and sqrt(8) literals are the correctly rounded float values (same as sqrtf)
+struct spring_stencil_24
+{
+    static int constexpr N_neighbor = 24;
+    static int constexpr offset_u[24] = { 2,2,2,2,2, 1,1,1,1,1, 0,0,0,0, -1,-1,-1,-1,-1, -2,-2,-2,-2,-2 };
+    static int constexpr offset_v[24] = { 2,1,0,-1,-2, 2,1,0,-1,-2, 2,1,-1,-2, 2,1,0,-1,-2, 2,1,0,-1,-2 };
+    static float constexpr alpha[24] = { 2.82842712f,2.23606798f,2,2.23606798f,2.82842712f, 2.23606798f,1.41421356f,1,1.41421356f,2.23606798f, 2,1,1,2,
+        2.23606798f,1.41421356f,1,1.41421356f,2.23606798f, 2.82842712f,2.23606798f,2,2.23606798f,2.82842712f };
+};
@@ -0,0 +1,127 @@
+#include "cgp/01_base/base.hpp"
+#include "../simulation.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace cgp;
+
+// Hash of the bit patterns of the positions and velocities of the cloth (FNV-1a)
+static unsigned int hash_cloth_state(cloth_structure const& cloth)
+{
+	unsigned int h = 2166136261u;
+	auto hash_grid = [&h](grid_2D<vec3> const& grid) {
+		for (vec3 const& p : grid.data) {
+			unsigned char bytes[sizeof(vec3)];
+			std::memcpy(bytes, &p, sizeof(vec3));
+			for (unsigned char b : bytes) {
+				h ^= b;
+				h *= 16777619u;
+			}
+		}
+	};
+	hash_grid(cloth.position);
+	hash_grid(cloth.velocity);
+	return h;
+}
+
+// Run the recorded scenario: a pinned cloth falling on a sphere under wind, half of the steps with the sleeping tiles
+static unsigned int run_recorded_scenario()
+{
+	int const N = 20;
+	cloth_structure cloth;
+	cloth.initialize(N);
+
+	simulation_parameters parameters;
+	parameters.wind.magnitude = 5.0f;
+	parameters.wind.direction = { 0,0,1 };
+
+	constraint_structure constraint;
+	constraint.add_fixed_position(0, 0, cloth.position(0, 0));
+	constraint.add_fixed_position(N - 1, 0, cloth.position(N - 1, 0));
+	constraint.spherical_constraints.push_back({ {0.5f,-0.3f,-0.6f}, 0.2f });
+
+	cloth_sleeping_structure sleeping;
+	sleeping.initialize(N);
+	float const mass_vertex = parameters.mass_total / cloth.position.size();
+
+	for (int k_step = 0; k_step < 200; ++k_step) {
+		simulation_compute_force(cloth, parameters);
+		simulation_numerical_integration(cloth, parameters, parameters.dt);
+		simulation_apply_constraints(cloth, constraint);
+		assert_cgp_no_msg(simulation_detect_divergence(cloth) == false);
+		cloth.update_normal();
+	}
+	for (int k_step = 0; k_step < 200; ++k_step) {
+		simulation_compute_force(cloth, parameters, sleeping);
+		simulation_numerical_integration(cloth, parameters, parameters.dt, sleeping);
+		simulation_apply_constraints(cloth, constraint, sleeping);
+		sleeping.update(cloth, constraint, mass_vertex);
+		cloth.update_normal();
+	}
+
+	return hash_cloth_state(cloth);
+}
+
+namespace cgp_test {
+
+	void test_simulation_determinism()
+	{
+#ifdef _OPENMP
+		// Reference state obtained with a single thread in this process: the result depends on the compiler and its flags
+		//  (e.g. fused multiply-add contraction), but must not depend on the number of threads
+		int const N_thread_default = omp_get_max_threads();
+		omp_set_num_threads(1);
+		unsigned int const hash_reference = run_recorded_scenario();
+
+		int const N_thread_max = std::max(N_thread_default, 8);
+		for (int N_thread = 2; N_thread <= N_thread_max; ++N_thread) {
+			omp_set_num_threads(N_thread);
+			unsigned int const hash_thread = run_recorded_scenario();
+			assert_cgp(hash_thread == hash_reference, "Simulation with " + str(N_thread) + " threads differs from the single thread run (hash " + str(hash_thread) + " instead of " + str(hash_reference) + ")");
+		}
+		omp_set_num_threads(N_thread_default);
+#else
+		// Without OpenMP the simulation always runs on a single thread: there is no thread count to compare
+		std::cout << "test_simulation_determinism skipped: the project is compiled without OpenMP" << std::endl;
+#endif
+	}
+
+	// The first force computation after the aerodynamics is enabled uses the aerodynamic forces of the current state
+	void test_simulation_aerodynamics_toggle()
+	{
+		int const N = 12;
+		cloth_structure cloth;
+		cloth.initialize(N);
+		constraint_structure constraint;
+		constraint.add_fixed_position(0, 0, cloth.position(0, 0));
+		constraint.add_fixed_position(N - 1, 0, cloth.position(N - 1, 0));
+
+		simulation_parameters parameters;
+		parameters.wind.magnitude = 10.0f;
+		parameters.wind.direction = { 0,0,1 };
+
+		// A few steps with aerodynamics, then without it: the aerodynamic forces kept in the cloth are outdated
+		for (int k_step = 0; k_step < 40; ++k_step) {
+			parameters.aerodynamics.active = k_step < 20;
+			simulation_compute_force(cloth, parameters);
+			simulation_numerical_integration(cloth, parameters, parameters.dt);
+			simulation_apply_constraints(cloth, constraint);
+			simulation_update_normal(cloth, parameters);
+		}
+
+		parameters.aerodynamics.active = true;
+		cloth_structure expected = cloth;
+		simulation_update_normal(expected, parameters);
+		simulation_compute_force(expected, parameters);
+		simulation_compute_force(cloth, parameters);
+		for (int k = 0; k < cloth.force.size(); ++k)
+			assert_cgp(norm(cloth.force.data[k] - expected.force.data[k]) < 1e-6f, "Outdated aerodynamic force at vertex " + str(k));
+	}
+
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+namespace cgp_test
+{
+	void test_simulation_determinism();
+	void test_simulation_aerodynamics_toggle();
+}
@@ -0,0 +1,123 @@
+#include "simulation_thread.hpp"
+
+#include <chrono>
+
+using namespace cgp;
+
+
+void simulation_thread_structure::start(cloth_structure const& cloth_initial, cloth_sleeping_structure const& sleeping_initial)
+{
+    if (is_running())
+        return;
+
+    cloth = cloth_initial;
+    sleeping = sleeping_initial;
+
+    input.reset();
+    output.reset();
+    for (simulation_output_structure& state : output.buffer) {
+        state.position.clear();
+        state.normal.clear();
+    }
+
+    running = true;
+    thread = std::thread(&simulation_thread_structure::loop, this);
+}
+
+void simulation_thread_structure::stop(cloth_structure& cloth_final, cloth_sleeping_structure& sleeping_final)
+{
+    if (!is_running())
+        return;
+
+    running = false;
+    thread.join();
+
+    cloth_final = cloth;
+    sleeping_final = sleeping;
+}
+
+bool simulation_thread_structure::is_running() const
+{
+    return running;
+}
+
+simulation_thread_structure::~simulation_thread_structure()
+{
+    running = false;
+    if (thread.joinable())
+        thread.join();
+}
+
+void simulation_thread_structure::push_input(constraint_structure const& constraint, simulation_parameters const& parameters, int N_step)
+{
+    simulation_input_structure& in = input.write_buffer();
+    in.constraint = constraint;
+    in.parameters = parameters;
+    in.N_step = N_step;
+    input.publish();
+}
+
+simulation_output_structure const& simulation_thread_structure::latest_output()
+{
+    output.acquire();
+    return output.read_buffer();
+}
+
+void simulation_thread_structure::loop()
+{
+    using clock = std::chrono::steady_clock;
+    clock::time_point next_tick = clock::now();
+
+    bool has_input = false;
+    while (running)
+    {
+        // Wait for the first pose sent by the render thread
+        has_input = input.acquire() || has_input;
+        if (!has_input) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        simulation_input_structure const& in = input.read_buffer();
+
+        clock::time_point const t0 = clock::now();
+
+        if (wake_request.exchange(false))
+            sleeping.wake_all();
+
+        int const N_step = std::max(in.N_step, 1);
+        float const dt_step = in.parameters.dt / N_step;
+        for (int k_step = 0; k_step < N_step; ++k_step)
+        {
+            simulation_compute_force(cloth, in.parameters, sleeping);
+            simulation_numerical_integration(cloth, in.parameters, dt_step, sleeping);
+            simulation_apply_constraints(cloth, in.constraint, sleeping);
+            sleeping.update(cloth, in.constraint, in.parameters.mass_total / cloth.position.size(), in.parameters.wind.field.active);
+
+            bool const simulation_diverged = simulation_detect_divergence(cloth);
+            if (simulation_diverged) {
+                std::cout << "\n *** Simulation has diverged ***" << std::endl;
+                std::cout << " > The simulation is stoped" << std::endl;
+            }
+
+            simulation_update_normal(cloth, in.parameters); // normals and aerodynamic forces of the next step
+        }
+
+        // Publish the new state for the display
+        simulation_output_structure& out = output.write_buffer();
+        out.position = cloth.position;
+        out.normal = cloth.normal;
+        out.tick = tick;
+        out.active_fraction = sleeping.active_fraction();
+        output.publish();
+
+        tick++;
+        std::chrono::duration<float, std::milli> const duration = clock::now() - t0;
+        tick_ms = duration.count();
+
+        // Fixed simulation rate (skip the waiting if the tick took longer than its period)
+        next_tick += std::chrono::microseconds(int(1e6f / std::max(rate_hz.load(), 1.0f)));
+        if (next_tick < clock::now())
+            next_tick = clock::now();
+        std::this_thread::sleep_until(next_tick);
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "cgp/cgp.hpp"
+#include "../cloth/cloth.hpp"
+#include "../cloth_sleeping/cloth_sleeping.hpp"
+#include "../constraint/constraint.hpp"
+#include "../simulation/simulation.hpp"
+#include "triple_buffer.hpp"
+
+#include <thread>
+
+
+// Data sent by the render thread to the simulation thread: the latest pose of the character (as pins and colliders) and the parameters
+struct simulation_input_structure {
+    constraint_structure constraint;
+    simulation_parameters parameters;
+    int N_step = 1; // number of steps per simulation tick, each one integrating parameters.dt/N_step
+};
+
+// Cloth state published by the simulation thread for the display
+struct simulation_output_structure {
+    cgp::grid_2D<cgp::vec3> position;
+    cgp::grid_2D<cgp::vec3> normal;
+    long tick = 0;                // index of the simulation tick that produced this state
+    float active_fraction = 1.0f; // ratio of awake tiles of the cloth
+};
+
+
+// Runs the cloth simulation on its own thread at a fixed rate, decoupled from the render frame rate
+//  The render thread pushes the latest pose and reads the latest completed cloth state without blocking.
+//  While the thread is running, it owns the cloth and sleeping structures given to start(); they are given back by stop().
+struct simulation_thread_structure
+{
+    std::atomic<float> rate_hz{ 60.0f }; // Number of simulation ticks per second (can be changed by the render thread while running)
+
+    triple_buffer_structure<simulation_input_structure> input;   // render thread -> simulation thread
+    triple_buffer_structure<simulation_output_structure> output; // simulation thread -> render thread
+
+    cloth_structure cloth;
+    cloth_sleeping_structure sleeping;
+
+    std::thread thread;
+    std::atomic<bool> running{ false };
+    std::atomic<long> tick{ 0 };
+    std::atomic<float> tick_ms{ 0.0f }; // duration of the last tick
+    std::atomic<bool> wake_request{ false }; // set by the render thread to wake up all the tiles of the cloth at the next tick
+
+
+    void start(cloth_structure const& cloth_initial, cloth_sleeping_structure const& sleeping_initial);
+    void stop(cloth_structure& cloth_final, cloth_sleeping_structure& sleeping_final);
+    bool is_running() const;
+
+    // Render thread: hand over the latest pose/parameters (never blocks)
+    void push_input(constraint_structure const& constraint, simulation_parameters const& parameters, int N_step);
+    // Render thread: latest published cloth state (empty grids until the first tick completed)
+    simulation_output_structure const& latest_output();
+
+    ~simulation_thread_structure();
+
+    void loop(); // body of the simulation thread
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+
+
+// Lock-free triple buffer between a single producer thread and a single consumer thread
+//  - The producer fills write_buffer(), then publish() swaps it with the shared middle buffer.
+//  - The consumer calls acquire() to swap its read buffer with the middle one when a new value was published.
+//  Neither side ever waits: the producer always has a buffer to write in, and the consumer always reads the latest complete value.
+template <typename T>
+struct triple_buffer_structure
+{
+    T buffer[3];
+
+    T& write_buffer() { return buffer[write_index]; }
+    T const& read_buffer() const { return buffer[read_index]; }
+
+    // Producer side: make the content of write_buffer() available to the consumer
+    void publish()
+    {
+        write_index = middle.exchange(write_index | fresh_bit) & index_mask;
+    }
+
+    // Consumer side: fetch the last published value if it was not read yet
+    //  Return false (and keep the current read_buffer()) if nothing new was published
+    bool acquire()
+    {
+        if ((middle.load() & fresh_bit) == 0)
+            return false;
+        read_index = middle.exchange(read_index) & index_mask;
+        return true;
+    }
+
+    // Forget all the published values (both threads must be stopped)
+    void reset()
+    {
+        write_index = 0;
+        middle = 1;
+        read_index = 2;
+    }
+
+    static int const fresh_bit = 4;  // set in middle when it holds a value the consumer has not read
+    static int const index_mask = 3;
+
+    int write_index = 0;          // owned by the producer
+    std::atomic<int> middle{ 1 }; // shared: index of the middle buffer + fresh_bit
+    int read_index = 2;           // owned by the consumer
+};
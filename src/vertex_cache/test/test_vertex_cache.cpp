@@ -0,0 +1,94 @@
+#include "cgp/01_base/base.hpp"
+#include "../vertex_cache.hpp"
+#include "../../cloth/cloth.hpp"
+
+#include <cstdio>
+#include <iostream>
+
+using namespace cgp;
+
+namespace cgp_test {
+
+	// The frames written by the background writer are read back within the quantization step of their bounding box,
+	//  in order, after a seek in another chunk, and through the streaming playback
+	void test_vertex_cache()
+	{
+		int const N = 12;
+		int const N_frame = 7;
+		std::string const filename = "test_vertex_cache.vtxc";
+
+		cloth_structure cloth;
+		cloth.initialize(N);
+
+		std::vector<numarray<vec3>> frames;
+		vertex_cache_writer_thread_structure writer;
+		writer.writer.chunk_size = 3;
+		assert_cgp_no_msg(writer.start(filename, N, N, 30.0f));
+		for (int k_frame = 0; k_frame < N_frame; ++k_frame) {
+			numarray<vec3> position = cloth.position.data;
+			for (int k = 0; k < position.size(); ++k)
+				position[k] += vec3{ 0.1f * k_frame, 0.05f * std::sin(0.3f * k + k_frame), 0.0f };
+			frames.push_back(position);
+			writer.push_frame(position);
+		}
+		assert_cgp_no_msg(writer.stop());
+
+		vertex_cache_reader_structure reader;
+		assert_cgp_no_msg(reader.open(filename));
+		assert_cgp_no_msg(reader.N_frame == N_frame);
+		assert_cgp_no_msg(reader.N_u == N && reader.N_v == N);
+		assert_cgp_no_msg(reader.chunk_offset.size() == 3);
+
+		// Smaller than the quantized positions stored without the deltas
+		assert_cgp_no_msg(reader.file.size < N_frame * N * N * 3 * sizeof(uint16_t));
+
+		auto check_frame = [&](numarray<vec3> const& position, int k_frame) {
+			assert_cgp_no_msg(position.size() == frames[k_frame].size());
+			for (int k = 0; k < position.size(); ++k)
+				assert_cgp_no_msg(norm(position[k] - frames[k_frame][k]) < 1e-4f);
+		};
+
+		numarray<vec3> position;
+		for (int k_frame = 0; k_frame < N_frame; ++k_frame) {
+			assert_cgp_no_msg(reader.read_frame(k_frame, position));
+			check_frame(position, k_frame);
+		}
+		for (int k_frame : { 4, 1, 5, 5, 0, 6 }) {
+			assert_cgp_no_msg(reader.read_frame(k_frame, position));
+			check_frame(position, k_frame);
+		}
+		reader.close();
+
+		// Playback with a jump backward and a loop over the end of the cache
+		vertex_cache_stream_structure stream;
+		assert_cgp_no_msg(stream.open(filename));
+		for (int k_frame : { 0, 1, 2, 5, 6, 7, 8, 3 }) {
+			vertex_cache_stream_frame const* frame = stream.frame(k_frame, true);
+			assert_cgp_no_msg(frame != nullptr);
+			assert_cgp_no_msg(frame->k_frame == k_frame % N_frame);
+			check_frame(frame->position.data, k_frame % N_frame);
+			assert_cgp_no_msg(std::abs(norm(frame->normal.data[0]) - 1.0f) < 1e-3f);
+		}
+		stream.close();
+
+		// Display faster than the frame rate of the cache: each frame is asked several times, and stays available without a new decoding
+		assert_cgp_no_msg(stream.open(filename));
+		long seek_generation = -1;
+		vertex_cache_stream_frame const* previous = nullptr;
+		for (int k_frame : { 0, 0, 1, 1, 2, 2, 2, 3 }) {
+			vertex_cache_stream_frame const* frame = stream.frame(k_frame, previous == nullptr || previous->k_frame != k_frame);
+			assert_cgp_no_msg(frame != nullptr && frame->k_frame == k_frame);
+			check_frame(frame->position.data, k_frame);
+			previous = frame;
+
+			std::lock_guard<std::mutex> lock(stream.mutex);
+			if (seek_generation == -1)
+				seek_generation = stream.seek_generation;
+			assert_cgp(stream.seek_generation == seek_generation, "Repeated frame " + str(k_frame) + " restarted the decoding");
+		}
+		stream.close();
+
+		std::remove(filename.c_str());
+	}
+
+}
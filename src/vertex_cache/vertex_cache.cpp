@@ -0,0 +1,550 @@
+#include "vertex_cache.hpp"
+#include "../cloth/cloth.hpp"
+
+#include <cstring>
+
+using namespace cgp;
+
+
+// Fixed-size header at the beginning of the file
+struct vertex_cache_header
+{
+    char magic[4];
+    uint32_t version;
+    int32_t N_u;
+    int32_t N_v;
+    int32_t N_frame;
+    float frame_rate;
+    int32_t chunk_size;
+    int32_t N_chunk;
+    uint64_t index_offset;
+};
+
+static char const vertex_cache_magic[4] = { 'V','T','X','C' };
+static float const quantization_max = 65535.0f;
+
+
+// Deltas of the quantized values as zigzag varints: small deltas of either sign take a single byte
+static void encode_delta(int delta, std::vector<uint8_t>& payload)
+{
+    uint32_t value = delta >= 0 ? 2u * uint32_t(delta) : 2u * uint32_t(-delta) - 1u;
+    while (value >= 0x80) {
+        payload.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    payload.push_back(static_cast<uint8_t>(value));
+}
+
+// Returns false if the payload ends before the value
+static bool decode_delta(uint8_t const*& cursor, uint8_t const* end, int& delta)
+{
+    uint32_t value = 0;
+    for (int shift = 0; shift < 32; shift += 7) {
+        if (cursor == end)
+            return false;
+        uint8_t const byte = *cursor++;
+        value |= uint32_t(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            delta = (value & 1u) ? -int((value + 1u) >> 1) : int(value >> 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void vertex_cache_frame::encode(numarray<vec3> const& position)
+{
+    int const N = static_cast<int>(position.size());
+    quantized.resize(3 * size_t(N));
+    if (N == 0) {
+        p_min = { 0,0,0 };
+        p_max = { 0,0,0 };
+        return;
+    }
+
+    vec3 const* p = position.data.data();
+    p_min = p[0];
+    p_max = p[0];
+    for (int k = 1; k < N; ++k) {
+        for (int c = 0; c < 3; ++c) {
+            p_min[c] = std::min(p_min[c], p[k][c]);
+            p_max[c] = std::max(p_max[c], p[k][c]);
+        }
+    }
+
+    float scale[3];
+    for (int c = 0; c < 3; ++c)
+        scale[c] = p_max[c] > p_min[c] ? quantization_max / (p_max[c] - p_min[c]) : 0.0f;
+
+    uint16_t* q = quantized.data();
+    for (int k = 0; k < N; ++k)
+        for (int c = 0; c < 3; ++c)
+            q[3 * k + c] = static_cast<uint16_t>(std::min((p[k][c] - p_min[c]) * scale[c] + 0.5f, quantization_max));
+}
+
+void vertex_cache_frame::decode(numarray<vec3>& position) const
+{
+    int const N = static_cast<int>(quantized.size() / 3);
+    position.resize(N);
+
+    vec3 const step = (p_max - p_min) / quantization_max;
+    vec3* p = position.data.data();
+    uint16_t const* q = quantized.data();
+    for (int k = 0; k < N; ++k)
+        for (int c = 0; c < 3; ++c)
+            p[k][c] = p_min[c] + q[3 * k + c] * step[c];
+}
+
+
+// Writer
+// ************************************************************ //
+
+bool vertex_cache_writer_structure::open(std::string const& filename, int N_u_arg, int N_v_arg, float frame_rate_arg)
+{
+    N_u = N_u_arg;
+    N_v = N_v_arg;
+    frame_rate = frame_rate_arg;
+    N_frame = 0;
+    chunk_offset.clear();
+    previous.clear();
+
+    stream.open(filename, std::ios::binary | std::ios::trunc);
+    if (!stream.is_open()) {
+        std::cout << "Warning: cannot write the vertex cache " << filename << std::endl;
+        return false;
+    }
+
+    // Placeholder for the header, written when the cache is closed
+    vertex_cache_header header = {};
+    stream.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    return stream.good();
+}
+
+bool vertex_cache_writer_structure::write_frame(vertex_cache_frame const& frame)
+{
+    assert_cgp(frame.quantized.size() == 3 * size_t(N_u) * size_t(N_v), "The frame has " + str(frame.quantized.size() / 3) + " vertices, the cache expects " + str(N_u * N_v));
+    assert_cgp(chunk_size > 0, "chunk_size=" + str(chunk_size) + " should be > 0");
+
+    bool const key_frame = N_frame % chunk_size == 0;
+    if (key_frame)
+        chunk_offset.push_back(static_cast<uint64_t>(stream.tellp()));
+
+    // Deltas against the previous vertex (key frame) or against the same vertex in the previous frame
+    payload.clear();
+    uint16_t const* q = frame.quantized.data();
+    size_t const N_value = frame.quantized.size();
+    if (key_frame) {
+        for (size_t k = 0; k < N_value; ++k)
+            encode_delta(int(q[k]) - (k >= 3 ? int(q[k - 3]) : 0), payload);
+    }
+    else {
+        for (size_t k = 0; k < N_value; ++k)
+            encode_delta(int(q[k]) - int(previous[k]), payload);
+    }
+    previous = frame.quantized;
+
+    float const box[6] = { frame.p_min.x, frame.p_min.y, frame.p_min.z, frame.p_max.x, frame.p_max.y, frame.p_max.z };
+    uint32_t const payload_size = static_cast<uint32_t>(payload.size());
+    stream.write(reinterpret_cast<char const*>(box), sizeof(box));
+    stream.write(reinterpret_cast<char const*>(&payload_size), sizeof(payload_size));
+    stream.write(reinterpret_cast<char const*>(payload.data()), payload.size());
+    N_frame++;
+    return stream.good();
+}
+
+bool vertex_cache_writer_structure::close()
+{
+    if (!stream.is_open())
+        return false;
+
+    vertex_cache_header header;
+    std::memcpy(header.magic, vertex_cache_magic, 4);
+    header.version = vertex_cache_version;
+    header.N_u = N_u;
+    header.N_v = N_v;
+    header.N_frame = N_frame;
+    header.frame_rate = frame_rate;
+    header.chunk_size = chunk_size;
+    header.N_chunk = static_cast<int32_t>(chunk_offset.size());
+    header.index_offset = static_cast<uint64_t>(stream.tellp());
+
+    stream.write(reinterpret_cast<char const*>(chunk_offset.data()), chunk_offset.size() * sizeof(uint64_t));
+    stream.seekp(0);
+    stream.write(reinterpret_cast<char const*>(&header), sizeof(header));
+
+    bool const success = stream.good();
+    stream.close();
+    return success;
+}
+
+
+// Writer on a background thread
+// ************************************************************ //
+
+bool vertex_cache_writer_thread_structure::start(std::string const& filename, int N_u, int N_v, float frame_rate)
+{
+    if (thread.joinable())
+        stop();
+
+    if (!writer.open(filename, N_u, N_v, frame_rate))
+        return false;
+
+    has_pending = false;
+    stopping = false;
+    failed = false;
+    thread = std::thread(&vertex_cache_writer_thread_structure::loop, this);
+    return true;
+}
+
+void vertex_cache_writer_thread_structure::push_frame(numarray<vec3> const& position)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [this] { return !has_pending; });
+    pending = position;
+    has_pending = true;
+    condition.notify_all();
+}
+
+bool vertex_cache_writer_thread_structure::stop()
+{
+    if (!thread.joinable())
+        return false;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+    thread.join();
+
+    bool const closed = writer.close();
+    return closed && !failed;
+}
+
+vertex_cache_writer_thread_structure::~vertex_cache_writer_thread_structure()
+{
+    if (thread.joinable())
+        stop();
+}
+
+void vertex_cache_writer_thread_structure::loop()
+{
+    numarray<vec3> position;
+    vertex_cache_frame frame;
+
+    while (true)
+    {
+        // Take the pending frame, and let the simulation push the next one while this one is encoded and written
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] { return has_pending || stopping; });
+            if (!has_pending)
+                return;
+            std::swap(position, pending);
+            has_pending = false;
+        }
+        condition.notify_all();
+
+        frame.encode(position);
+        if (!writer.write_frame(frame))
+            failed = true;
+    }
+}
+
+
+
+
+// Reader
+// ************************************************************ //
+
+bool vertex_cache_reader_structure::open(std::string const& filename)
+{
+    close();
+    if (file.open(filename) == false)
+        return false;
+
+    vertex_cache_header header;
+    if (file.size < sizeof(header)) {
+        std::cout << "Warning: " << filename << " is not a vertex cache" << std::endl;
+        file.close();
+        return false;
+    }
+    std::memcpy(&header, file.data, sizeof(header));
+    if (std::memcmp(header.magic, vertex_cache_magic, 4) != 0 || header.N_u <= 0 || header.N_v <= 0 || header.N_frame < 0 || header.chunk_size <= 0) {
+        std::cout << "Warning: " << filename << " is not a vertex cache (or it was not closed)" << std::endl;
+        file.close();
+        return false;
+    }
+    if (header.version != vertex_cache_version) {
+        std::cout << "Warning: vertex cache " << filename << " has version " << header.version << " (expected " << vertex_cache_version << ")" << std::endl;
+        file.close();
+        return false;
+    }
+    int const N_chunk_expected = (header.N_frame + header.chunk_size - 1) / header.chunk_size;
+    if (header.N_chunk != N_chunk_expected || header.index_offset + header.N_chunk * sizeof(uint64_t) > file.size) {
+        std::cout << "Warning: vertex cache " << filename << " is truncated" << std::endl;
+        file.close();
+        return false;
+    }
+
+    chunk_offset.resize(header.N_chunk);
+    std::memcpy(chunk_offset.data(), file.data + header.index_offset, header.N_chunk * sizeof(uint64_t));
+    for (uint64_t offset : chunk_offset) {
+        if (offset < sizeof(header) || offset >= header.index_offset) {
+            std::cout << "Warning: vertex cache " << filename << " has an invalid chunk index" << std::endl;
+            file.close();
+            return false;
+        }
+    }
+
+    N_u = header.N_u;
+    N_v = header.N_v;
+    N_frame = header.N_frame;
+    frame_rate = header.frame_rate;
+    chunk_size = header.chunk_size;
+    index_offset = header.index_offset;
+    decoded.quantized.assign(3 * size_t(N_u) * size_t(N_v), 0);
+    return true;
+}
+
+void vertex_cache_reader_structure::close()
+{
+    file.close();
+    N_frame = 0;
+    chunk_offset.clear();
+    k_decoded = -1;
+}
+
+bool vertex_cache_reader_structure::read_frame(int k_frame, numarray<vec3>& position)
+{
+    assert_cgp(k_frame >= 0 && k_frame < N_frame, "Frame " + str(k_frame) + " is not in the vertex cache of " + str(N_frame) + " frames");
+
+    // Restart from the key frame of the chunk, unless k_frame follows the last decoded frame of the same chunk
+    int const k_key = (k_frame / chunk_size) * chunk_size;
+    if (k_decoded < k_key || k_decoded >= k_frame) {
+        k_decoded = k_key - 1;
+        next_offset = chunk_offset[k_frame / chunk_size];
+    }
+
+    uint16_t* q = decoded.quantized.data();
+    size_t const N_value = decoded.quantized.size();
+    while (k_decoded < k_frame)
+    {
+        float box[6];
+        uint32_t payload_size = 0;
+        if (next_offset + sizeof(box) + sizeof(payload_size) > index_offset) {
+            k_decoded = -1;
+            return false;
+        }
+        char const* cursor = file.data + next_offset;
+        std::memcpy(box, cursor, sizeof(box));
+        std::memcpy(&payload_size, cursor + sizeof(box), sizeof(payload_size));
+        cursor += sizeof(box) + sizeof(payload_size);
+        if (next_offset + sizeof(box) + sizeof(payload_size) + payload_size > index_offset) {
+            k_decoded = -1;
+            return false;
+        }
+
+        uint8_t const* payload = reinterpret_cast<uint8_t const*>(cursor);
+        uint8_t const* payload_end = payload + payload_size;
+        bool const key_frame = (k_decoded + 1) % chunk_size == 0;
+        for (size_t k = 0; k < N_value; ++k) {
+            int delta = 0;
+            if (!decode_delta(payload, payload_end, delta)) {
+                k_decoded = -1;
+                return false;
+            }
+            int const reference = key_frame ? (k >= 3 ? int(q[k - 3]) : 0) : int(q[k]);
+            q[k] = static_cast<uint16_t>(reference + delta);
+        }
+
+        decoded.p_min = { box[0], box[1], box[2] };
+        decoded.p_max = { box[3], box[4], box[5] };
+        next_offset += sizeof(box) + sizeof(payload_size) + payload_size;
+        k_decoded++;
+    }
+
+    decoded.decode(position);
+    return true;
+}
+
+
+// Streaming playback
+// ************************************************************ //
+
+bool vertex_cache_stream_structure::open(std::string const& filename)
+{
+    close();
+    if (!reader.open(filename))
+        return false;
+    if (reader.N_u != reader.N_v || reader.N_frame == 0) {
+        std::cout << "Warning: the vertex cache " << filename << " cannot be played (" << reader.N_frame << " frames of " << reader.N_u << "x" << reader.N_v << " vertices)" << std::endl;
+        reader.close();
+        return false;
+    }
+
+    slot.resize(N_slot + 1);
+    free_slots.clear();
+    for (int k = 0; k < slot.size(); ++k) {
+        slot[k].position.resize(reader.N_u, reader.N_v);
+        slot[k].normal.resize(reader.N_u, reader.N_v);
+        slot[k].k_frame = -1;
+        free_slots.push_back(k);
+    }
+    ready.clear();
+    current = -1;
+    next_decode = 0;
+    k_decoding = -1;
+    seek_request = -1;
+    stopping = false;
+    failed = false;
+
+    thread = std::thread(&vertex_cache_stream_structure::loop, this);
+    return true;
+}
+
+void vertex_cache_stream_structure::close()
+{
+    if (thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        condition.notify_all();
+        thread.join();
+    }
+    reader.close();
+    ready.clear();
+    free_slots.clear();
+    current = -1;
+}
+
+bool vertex_cache_stream_structure::is_open() const
+{
+    return reader.N_frame > 0;
+}
+
+int vertex_cache_stream_structure::N_frame() const
+{
+    return reader.N_frame;
+}
+
+float vertex_cache_stream_structure::frame_rate() const
+{
+    return reader.frame_rate;
+}
+
+vertex_cache_stream_structure::~vertex_cache_stream_structure()
+{
+    close();
+}
+
+vertex_cache_stream_frame const* vertex_cache_stream_structure::frame(int k_frame, bool wait)
+{
+    if (!is_open())
+        return nullptr;
+    int const N = N_frame();
+    k_frame = ((k_frame % N) + N) % N;
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // The display asks again for the frame it holds (ex. display faster than the frame rate of the cache): it keeps it
+    if (current != -1 && slot[current].k_frame == k_frame)
+        return &slot[current];
+
+    // The display releases the frame it held
+    if (current != -1) {
+        free_slots.push_back(current);
+        current = -1;
+    }
+
+    // Number of frames from a to b in the playback order
+    auto ahead = [N](int a, int b) { return ((b - a) % N + N) % N; };
+
+    while (true)
+    {
+        // Drop the decoded frames that are already past
+        while (!ready.empty() && slot[ready.front()].k_frame != k_frame && ahead(slot[ready.front()].k_frame, k_frame) < N / 2) {
+            free_slots.push_back(ready.front());
+            ready.pop_front();
+        }
+
+        if (!ready.empty() && slot[ready.front()].k_frame == k_frame) {
+            current = ready.front();
+            ready.pop_front();
+            condition.notify_all();
+            return &slot[current];
+        }
+
+        // The frame will be reached by the decoding soon, otherwise restart the decoding from it
+        bool const upcoming = ready.empty() && seek_request == -1 && (k_decoding == k_frame || ahead(next_decode, k_frame) <= N_slot);
+        if (!upcoming && seek_request != k_frame) {
+            for (int k : ready)
+                free_slots.push_back(k);
+            ready.clear();
+            seek_request = k_frame;
+            seek_generation++;
+            k_decoding = -1;
+        }
+        condition.notify_all();
+
+        if (!wait || failed)
+            return nullptr;
+        condition.wait(lock);
+    }
+}
+
+void vertex_cache_stream_structure::loop()
+{
+    numarray<vec3> position;
+    while (true)
+    {
+        int k_slot = -1;
+        int k_frame = -1;
+        long generation = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] { return stopping || seek_request != -1 || !free_slots.empty(); });
+            if (stopping)
+                return;
+            if (seek_request != -1) {
+                next_decode = seek_request;
+                seek_request = -1;
+            }
+            if (free_slots.empty())
+                continue;
+
+            k_slot = free_slots.back();
+            free_slots.pop_back();
+            k_frame = next_decode;
+            next_decode = (next_decode + 1) % reader.N_frame;
+            generation = seek_generation;
+            k_decoding = k_frame;
+        }
+
+        // Decode directly in the buffers of the slot (not accessed by the display until it is ready)
+        vertex_cache_stream_frame& frame = slot[k_slot];
+        bool const success = reader.read_frame(k_frame, frame.position.data);
+        if (success) {
+            int const N = reader.N_u;
+            normal_grid_rows(frame.position.data.data.data(), frame.normal.data.data.data(), N, 0, N);
+            frame.k_frame = k_frame;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (generation == seek_generation)
+                k_decoding = -1;
+            if (!success)
+                failed = true;
+            if (success && generation == seek_generation)
+                ready.push_back(k_slot);
+            else
+                free_slots.push_back(k_slot);
+        }
+        condition.notify_all();
+        if (!success)
+            return;
+    }
+}
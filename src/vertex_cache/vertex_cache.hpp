@@ -0,0 +1,153 @@
+#pragma once
+
+#include "cgp/cgp.hpp"
+#include "../mapped_file/mapped_file.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// Frame-indexed cache of the vertex positions of a baked cloth, compressed for streaming playback
+//
+// File layout (little endian)
+//  - header: "VTXC", version, N_u x N_v vertices (grid_2D storage order), number of frames, frame rate, frames per chunk, number of chunks, byte offset of the chunk index
+//  - chunks of chunk_size consecutive frames. Each frame stores
+//     - its bounding box (p_min, p_max): the 3 coordinates of each vertex are quantized on 16 bits in this box
+//     - the byte size of its payload, and the payload: one delta per quantized value, as a zigzag varint
+//       The first frame of a chunk (key frame) is delta-coded against the previous vertex, the other ones against the same vertex in the previous frame.
+//  - chunk index: byte offset of each chunk (uint64). Seeking to a frame only decodes its chunk from the key frame.
+//  The header and the index are written when the cache is closed: a file that was not closed is not a valid cache.
+int const vertex_cache_version = 2;
+
+// Positions of a frame quantized in their bounding box
+struct vertex_cache_frame
+{
+    cgp::vec3 p_min;
+    cgp::vec3 p_max;
+    std::vector<uint16_t> quantized; // 3 values per vertex
+
+    void encode(cgp::numarray<cgp::vec3> const& position);
+    void decode(cgp::numarray<cgp::vec3>& position) const;
+};
+
+
+// Sequential writer of a vertex cache
+struct vertex_cache_writer_structure
+{
+    int N_u = 0;
+    int N_v = 0;
+    float frame_rate = 30.0f;
+    int chunk_size = 16; // number of frames per chunk (a seek decodes at most chunk_size frames)
+
+    std::ofstream stream;
+    int N_frame = 0;
+    std::vector<uint64_t> chunk_offset;
+    std::vector<uint16_t> previous; // quantized values of the previous frame (reference of the deltas)
+    std::vector<uint8_t> payload;
+
+    bool open(std::string const& filename, int N_u, int N_v, float frame_rate); // Returns false if the file cannot be written
+    bool write_frame(vertex_cache_frame const& frame);
+    bool close(); // Write the chunk index and the header
+};
+
+// Writer encoding and writing each frame on a background thread
+//  push_frame() copies the positions and returns immediately: the next frame can be simulated while the previous one is written.
+//  It only waits when the previous frame has not been taken by the writing thread yet (no frame is ever dropped).
+struct vertex_cache_writer_thread_structure
+{
+    vertex_cache_writer_structure writer;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable condition;
+    cgp::numarray<cgp::vec3> pending; // frame waiting to be written
+    bool has_pending = false;
+    bool stopping = false;
+    bool failed = false;
+
+    bool start(std::string const& filename, int N_u, int N_v, float frame_rate);
+    void push_frame(cgp::numarray<cgp::vec3> const& position);
+    bool stop(); // Write the remaining frame and close the cache, returns false if a write failed
+
+    ~vertex_cache_writer_thread_structure();
+
+    void loop(); // body of the writing thread
+};
+
+
+// Read access to the frames of a vertex cache (the file is memory-mapped)
+//  Consecutive frames are decoded incrementally, any other frame is reached from the key frame of its chunk.
+struct vertex_cache_reader_structure
+{
+    int N_u = 0;
+    int N_v = 0;
+    float frame_rate = 30.0f;
+    int N_frame = 0;
+    int chunk_size = 0;
+
+    mapped_file_structure file;
+    std::vector<uint64_t> chunk_offset;
+    uint64_t index_offset = 0;
+
+    // Decoding state: last decoded frame, its quantized values, and the position of the next frame in the file
+    int k_decoded = -1;
+    vertex_cache_frame decoded;
+    uint64_t next_offset = 0;
+
+    bool open(std::string const& filename); // Returns false if the file is missing or is not a valid vertex cache
+    void close();
+
+    // Decode the frame k_frame in position (resized to N_u*N_v). Returns false if the file is corrupted.
+    bool read_frame(int k_frame, cgp::numarray<cgp::vec3>& position);
+};
+
+
+// Frame of a vertex cache ready to be displayed (see cloth_structure_drawable::update)
+struct vertex_cache_stream_frame
+{
+    cgp::grid_2D<cgp::vec3> position;
+    cgp::grid_2D<cgp::vec3> normal;
+    int k_frame = -1;
+};
+
+// Playback of a vertex cache of a square grid: a background thread decodes the frames following the displayed one,
+//  and computes their normals, directly in the buffers given to the display. The playback loops at the end of the cache.
+struct vertex_cache_stream_structure
+{
+    int N_slot = 4; // number of frames decoded in advance (+1 held by the display)
+
+    vertex_cache_reader_structure reader;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::vector<vertex_cache_stream_frame> slot;
+    std::deque<int> ready;       // decoded slots, in playback order
+    std::vector<int> free_slots; // slots available for decoding
+    int current = -1;            // slot held by the display
+    int next_decode = 0;         // next frame decoded by the thread
+    int k_decoding = -1;         // frame being decoded by the thread (-1: none)
+    int seek_request = -1;       // frame from which the thread restarts (-1: no request)
+    long seek_generation = 0;    // incremented at each seek, the frames decoded before it are dropped
+    bool stopping = false;
+    bool failed = false;
+
+    bool open(std::string const& filename); // Open the cache and start decoding from its first frame
+    void close();
+    bool is_open() const;
+    int N_frame() const;
+    float frame_rate() const;
+
+    // Frame k_frame of the cache, valid until the next call (nullptr if it is not decoded yet, the previous frame can be displayed)
+    //  A frame that is not the next ones of the playback restarts the decoding from it. With wait=true, the call blocks until the frame is decoded.
+    vertex_cache_stream_frame const* frame(int k_frame, bool wait = false);
+
+    ~vertex_cache_stream_structure();
+
+    void loop(); // body of the decoding thread
+};
@@ -0,0 +1,113 @@
+#include "wind_field.hpp"
+
+using namespace cgp;
+
+
+// Offsets decorrelating the three components of the turbulence
+static vec3 const noise_offset[3] = { {0,0,0}, {31.4f,-12.7f,5.3f}, {-7.1f,23.9f,-17.2f} };
+static int const noise_octave = 3;
+static float const noise_persistency = 0.4f;
+
+// Value of the turbulence, centered in [-1,1], at the noise coordinates q
+static vec3 turbulence_at(vec3 const& q)
+{
+    // Sum of the amplitudes of the octaves of noise_perlin (each octave is in [0,amplitude])
+    float const amplitude_sum = (1.0f - std::pow(noise_persistency, float(noise_octave))) / (1.0f - noise_persistency);
+
+    vec3 t;
+    for (int k = 0; k < 3; ++k)
+        t[k] = 2.0f * noise_perlin(q + noise_offset[k], noise_octave, noise_persistency) / amplitude_sum - 1.0f;
+    return t;
+}
+
+// Evaluate the whole grid of a keyframe
+//  The nodes are independent: the evaluation is spread over the z-slices of the grid.
+static void evaluate_keyframe(wind_field_structure::keyframe& key, wind_field_structure const& field, vec3 const& mean_wind)
+{
+    int const N = field.N_cell;
+    key.value.resize(N, N, N);
+
+    float const magnitude = norm(mean_wind);
+    vec3 const scroll = field.scroll_speed * key.time * mean_wind; // The turbulence is carried along by the mean wind
+    vec3 const cell = (key.p_max - key.p_min) / (N - 1.0f);
+
+#pragma omp parallel for
+    for (int kz = 0; kz < N; ++kz) {
+        for (int ky = 0; ky < N; ++ky) {
+            for (int kx = 0; kx < N; ++kx) {
+                vec3 const p = key.p_min + vec3{ kx * cell.x, ky * cell.y, kz * cell.z };
+                vec3 const q = (p - scroll) / field.scale;
+                key.value(kx, ky, kz) = mean_wind + field.turbulence * magnitude * turbulence_at(q);
+            }
+        }
+    }
+}
+
+// Trilinear interpolation of the keyframe at position p (clamped to the grid)
+static vec3 sample_keyframe(wind_field_structure::keyframe const& key, vec3 const& p)
+{
+    int const N = key.value.dimension.x;
+    vec3 const u = (p - key.p_min) / (key.p_max - key.p_min) * (N - 1.0f);
+
+    int k0[3];
+    float d[3];
+    for (int c = 0; c < 3; ++c) {
+        float const x = std::min(std::max(u[c], 0.0f), N - 1.0f);
+        k0[c] = std::min(int(x), N - 2);
+        d[c] = x - k0[c];
+    }
+
+    grid_3D<vec3> const& v = key.value;
+    int const x0 = k0[0], y0 = k0[1], z0 = k0[2];
+    vec3 const v00 = interpolation_linear(d[0], v(x0, y0, z0), v(x0 + 1, y0, z0));
+    vec3 const v10 = interpolation_linear(d[0], v(x0, y0 + 1, z0), v(x0 + 1, y0 + 1, z0));
+    vec3 const v01 = interpolation_linear(d[0], v(x0, y0, z0 + 1), v(x0 + 1, y0, z0 + 1));
+    vec3 const v11 = interpolation_linear(d[0], v(x0, y0 + 1, z0 + 1), v(x0 + 1, y0 + 1, z0 + 1));
+    vec3 const v0 = interpolation_linear(d[1], v00, v10);
+    vec3 const v1 = interpolation_linear(d[1], v01, v11);
+    return interpolation_linear(d[2], v0, v1);
+}
+
+
+void wind_field_structure::update(float time_interval, vec3 const& mean_wind, vec3 const& p_min, vec3 const& p_max)
+{
+    assert_cgp(N_cell >= 2, "N_cell=" + str(N_cell) + " should be >= 2");
+    time += time_interval;
+
+    float const period = 1.0f / update_rate_hz;
+    vec3 const m = { margin, margin, margin };
+
+    // First call, or resolution change: start with two keyframes around the current time
+    if (next.value.dimension.x != N_cell) {
+        previous.p_min = p_min - m;
+        previous.p_max = p_max + m;
+        previous.time = time;
+        evaluate_keyframe(previous, *this, mean_wind);
+        next = previous;
+        next.time = time + period;
+        evaluate_keyframe(next, *this, mean_wind);
+    }
+
+    // Evaluate a new keyframe each time the current one is exceeded (only one per call after a long frame)
+    if (time >= next.time) {
+        std::swap(previous, next);
+        next.p_min = p_min - m;
+        next.p_max = p_max + m;
+        next.time = std::max(previous.time + period, time);
+        evaluate_keyframe(next, *this, mean_wind);
+    }
+
+    alpha = std::min(std::max((time - previous.time) / (next.time - previous.time), 0.0f), 1.0f);
+}
+
+void wind_field_structure::evaluate_keyframes(vec3 const& mean_wind)
+{
+    assert_cgp(N_cell >= 2, "N_cell=" + str(N_cell) + " should be >= 2");
+    evaluate_keyframe(previous, *this, mean_wind);
+    evaluate_keyframe(next, *this, mean_wind);
+}
+
+vec3 wind_field_structure::sample(vec3 const& p) const
+{
+    return interpolation_linear(alpha, sample_keyframe(previous, p), sample_keyframe(next, p));
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "cgp/cgp.hpp"
+
+
+// Spatially varying wind: a mean wind plus a turbulent part given by 3D Perlin noise
+//  The noise is only evaluated on a coarse grid around the cloth, a few times per second (keyframes).
+//  The turbulence is scrolled along the mean wind over time, and the particles sample the field by trilinear interpolation
+//  in space and linear interpolation between the two last keyframes in time.
+struct wind_field_structure
+{
+    bool active = false;          // Use the wind field (the uniform wind of simulation_parameters is used otherwise)
+    float turbulence = 0.6f;      // Magnitude of the turbulent part relative to the mean wind
+    float scale = 0.4f;           // Size of the turbulent structures (in meters)
+    float scroll_speed = 0.8f;    // Speed at which the turbulence is carried along the mean wind direction (relative to the magnitude)
+    float update_rate_hz = 5.0f;  // Number of keyframes evaluated per second
+    int N_cell = 8;               // Number of grid nodes along each dimension
+    float margin = 0.5f;          // Extension of the grid around the box given to update()
+
+    // Wind velocity evaluated on a grid covering the box [p_min,p_max] at a given time
+    struct keyframe {
+        cgp::grid_3D<cgp::vec3> value;
+        cgp::vec3 p_min;
+        cgp::vec3 p_max;
+        float time = 0.0f;
+    };
+    keyframe previous;    // Keyframe before the current time
+    keyframe next;        // Keyframe after the current time
+    float time = 0.0f;    // Current time of the field
+    float alpha = 0.0f;   // Interpolation coefficient between previous and next at the current time
+
+    // Advance the time of the field, and evaluate a new keyframe covering [p_min,p_max] when the current one is exceeded
+    //  mean_wind is the wind velocity around which the turbulence is generated (wind.magnitude * wind.direction).
+    void update(float time_interval, cgp::vec3 const& mean_wind, cgp::vec3 const& p_min, cgp::vec3 const& p_max);
+
+    // Evaluate again the values of the two keyframes from their box and time (ex. keyframes restored from a file)
+    void evaluate_keyframes(cgp::vec3 const& mean_wind);
+
+    // Wind velocity at position p at the current time
+    cgp::vec3 sample(cgp::vec3 const& p) const;
+};
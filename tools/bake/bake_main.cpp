@@ -0,0 +1,165 @@
+#include "cgp/cgp.hpp"
+#include "environment.hpp"
+#include "cape_rig/cape_rig.hpp"
+#include "simulation/simulation.hpp"
+#include "vertex_cache/vertex_cache.hpp"
+
+#include <chrono>
+#include <iostream>
+
+// Offline bake of the cape on an animation of Lola in a vertex cache (no window is opened)
+//  Usage: bake <animation> <output.vtxc> [--N 80] [--substeps 4] [--fps 30] [--cycles 1] [--warmup 1] [--dt 0.005] [--K 5] [--mu 15] [--stencil 24]
+//  The cape is simulated at a fixed rate of dt/substeps. It settles on the first pose (warmup, in seconds), then follows the animation
+//  over whole cycles before one cycle is recorded: the cache holds exactly one settled cycle, and loops with the animation.
+//  The frames are relative to the start of the recorded cycle (the root motion of the previous cycles is removed): frame k is displayed
+//  at the local time k/frame_rate of the animation. The frame rate is adjusted so that the cycle is an integer number of frames.
+//  A frame is compressed and written on a background thread while the next one is simulated.
+//  The scene plays the cache assets/cloth_Lola_<Animation>.vtxc (ex. bake walk assets/cloth_Lola_Walk.vtxc)
+
+static void print_usage(std::string const& executable)
+{
+	std::cout << "Usage: " << executable << " <animation> <output.vtxc> [--N 80] [--substeps 4] [--fps 30] [--cycles 1] [--warmup 1] [--dt 0.005] [--K 5] [--mu 15] [--stencil 24]" << std::endl;
+	std::cout << " <animation>: directory in assets/lola/animation/ (ex. walk, idle, dance_1)" << std::endl;
+	std::cout << " --cycles: number of animation cycles simulated before the recorded one, --warmup: seconds of rest on the first pose" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3) {
+		print_usage(argv[0]);
+		return 1;
+	}
+	std::string const animation = argv[1];
+	std::string const filename_output = argv[2];
+
+	int N_sample = 80;
+	int substeps = 4;
+	float fps = 30.0f;
+	int N_cycle_warmup = 1;
+	float warmup = 1.0f;
+	simulation_parameters parameters;
+	for (int k = 3; k < argc; k += 2) {
+		std::string const option = argv[k];
+		if (k + 1 == argc) {
+			std::cout << "Missing value for the option " << option << std::endl;
+			print_usage(argv[0]);
+			return 1;
+		}
+		float const value = static_cast<float>(std::atof(argv[k + 1]));
+		if (option == "--N") N_sample = static_cast<int>(value);
+		else if (option == "--substeps") substeps = static_cast<int>(value);
+		else if (option == "--fps") fps = value;
+		else if (option == "--cycles") N_cycle_warmup = static_cast<int>(value);
+		else if (option == "--warmup") warmup = value;
+		else if (option == "--dt") parameters.dt = value;
+		else if (option == "--K") parameters.K = value;
+		else if (option == "--mu") parameters.mu = value;
+		else if (option == "--stencil") parameters.stencil = static_cast<int>(value);
+		else {
+			std::cout << "Unknown option " << option << std::endl;
+			print_usage(argv[0]);
+			return 1;
+		}
+	}
+	bool const valid_stencil = parameters.stencil == 4 || parameters.stencil == 8 || parameters.stencil == 12 || parameters.stencil == 24;
+	if (N_sample <= 3 || substeps < 1 || fps <= 0 || N_cycle_warmup < 0 || parameters.dt <= 0 || !valid_stencil) {
+		std::cout << "Invalid options: N=" << N_sample << " substeps=" << substeps << " fps=" << fps << " cycles=" << N_cycle_warmup << " dt=" << parameters.dt << " stencil=" << parameters.stencil << " (4, 8, 12 or 24)" << std::endl;
+		return 1;
+	}
+
+	project::path = cgp::project_path_find(argv[0], "shaders/");
+
+	std::cout << "Load the animation " << animation << std::endl;
+	cape_rig_clip const clip = cape_rig_load_clip(project::path + "assets/lola/", animation);
+
+	// Frames of the recorded cycle (the frame rate is adjusted so that the cycle is an integer number of frames)
+	float const cycle = clip.duration();
+	int const N_frame = std::max(static_cast<int>(std::round(cycle * fps)), 1);
+	fps = N_frame / cycle;
+
+	// Time steps per output frame (the time step is adjusted so that a frame is an integer number of steps)
+	int const N_step_frame = std::max(static_cast<int>(std::round(1.0f / (fps * parameters.dt))), 1);
+	float const dt = 1.0f / (fps * N_step_frame);
+	float const dt_substep = dt / substeps;
+	int const N_step_warmup = static_cast<int>(std::ceil(warmup / dt));
+
+	cloth_structure cloth;
+	cloth.initialize(N_sample);
+	constraint_structure constraint;
+	cgp::numarray<cgp::mat4> joint_frames;
+
+	// Simulate the cape on the clip from the time t_start, n steps of dt
+	auto simulate = [&](float t_start, int N_step) {
+		for (int k_step = 0; k_step < N_step; ++k_step) {
+			clip.evaluate(t_start + k_step * dt, joint_frames);
+			cape_rig_update_pins(constraint, joint_frames, N_sample);
+			cape_rig_update_colliders(constraint, joint_frames);
+			for (int k_substep = 0; k_substep < substeps; ++k_substep) {
+				simulation_compute_force(cloth, parameters);
+				simulation_numerical_integration(cloth, parameters, dt_substep);
+				simulation_apply_constraints(cloth, constraint);
+				if (simulation_detect_divergence(cloth))
+					return false;
+				simulation_update_normal(cloth, parameters);
+			}
+		}
+		return true;
+	};
+
+	// The cape settles on the first pose before following the animation
+	clip.evaluate(0.0f, joint_frames);
+	cape_rig_update_pins(constraint, joint_frames, N_sample);
+	cape_rig_drape(cloth, constraint);
+	for (int k_step = 0; k_step < N_step_warmup; ++k_step) {
+		if (!simulate(0.0f, 1)) {
+			std::cout << "The simulation diverged during the warmup: reduce --dt or increase --substeps" << std::endl;
+			return 1;
+		}
+	}
+
+	// The cape follows the animation over whole cycles, so that the recorded cycle starts from its periodic motion
+	std::cout << "Warmup over " << N_cycle_warmup << " cycle(s) of " << cycle << "s" << std::endl;
+	for (int k_frame = 0; k_frame < N_cycle_warmup * N_frame; ++k_frame) {
+		if (!simulate(k_frame / fps, N_step_frame)) {
+			std::cout << "The simulation diverged during the warmup: reduce --dt or increase --substeps" << std::endl;
+			return 1;
+		}
+	}
+	float const t_record = N_cycle_warmup * cycle;
+	cgp::vec3 const record_offset = -static_cast<float>(N_cycle_warmup) * clip.cycle_translation; // root motion of the warmup cycles
+	cgp::numarray<cgp::vec3> position_record;
+
+	vertex_cache_writer_thread_structure writer;
+	if (!writer.start(filename_output, N_sample, N_sample, fps))
+		return 1;
+
+	std::cout << "Bake " << N_frame << " frames of " << N_sample << "x" << N_sample << " vertices (" << N_step_frame * substeps << " steps per frame)" << std::endl;
+	auto const time_start = std::chrono::steady_clock::now();
+	bool diverged = false;
+	for (int k_frame = 0; k_frame < N_frame && !diverged; ++k_frame) {
+		position_record = cloth.position.data;
+		for (cgp::vec3& p : position_record)
+			p += record_offset;
+		writer.push_frame(position_record); // frame k is written while frame k+1 is simulated
+		if (k_frame + 1 < N_frame)
+			diverged = !simulate(t_record + k_frame / fps, N_step_frame);
+
+		if ((k_frame + 1) % 10 == 0 || k_frame + 1 == N_frame)
+			std::cout << "\r  frame " << k_frame + 1 << "/" << N_frame << std::flush;
+	}
+	std::cout << std::endl;
+
+	bool const written = writer.stop();
+	double const time_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - time_start).count();
+
+	if (diverged) {
+		std::cout << "The simulation diverged: the cache is incomplete (reduce --dt or increase --substeps)" << std::endl;
+		return 1;
+	}
+	if (!written) {
+		std::cout << "Error while writing " << filename_output << std::endl;
+		return 1;
+	}
+	std::cout << "Vertex cache written in " << filename_output << " (" << time_ms / N_frame << " ms per frame)" << std::endl;
+	return 0;
+}
@@ -0,0 +1,136 @@
+#include "cgp/cgp.hpp"
+#include "cloth_distributed/cloth_distributed.hpp"
+
+#include <mpi.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+// Distributed simulation of a large cloth, one block of the grid per process (no window is opened)
+//  Usage: mpirun -np <processes> distributed [--N 200] [--steps 200] [--dt 0.0005] [--K 5] [--mu 15] [--check 1]
+//  The cloth is pinned along its top edge and blown by the wind against a sphere. The time per step is the slowest process.
+//  With --check 1, the process 0 also runs the single process solver and compares the gathered cloth to it (bitwise).
+
+static void print_usage(std::string const& executable)
+{
+	std::cout << "Usage: mpirun -np <processes> " << executable << " [--N 200] [--steps 200] [--dt 0.0005] [--K 5] [--mu 15] [--check 1]" << std::endl;
+}
+
+static void initialize_scenario(int N, cloth_structure& cloth, simulation_parameters& parameters, constraint_structure& constraint)
+{
+	cloth.initialize(N);
+	parameters.wind.magnitude = 5.0f;
+	parameters.wind.direction = { 0,0,1 };
+	for (int ku = 0; ku < N; ku += std::max(N / 8, 1))
+		constraint.add_fixed_position(ku, N - 1, cloth.position(ku, N - 1));
+	constraint.add_fixed_position(N - 1, N - 1, cloth.position(N - 1, N - 1));
+	constraint.spherical_constraints.push_back({ {0.0f,0.4f,-0.3f}, 0.15f });
+	constraint.ground_y = -1.0f;
+}
+
+int main(int argc, char* argv[])
+{
+	MPI_Init(&argc, &argv);
+	int rank = 0, N_process = 1;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &N_process);
+
+	int N = 200;
+	int N_step = 200;
+	bool check = false;
+	simulation_parameters parameters;
+	parameters.dt = 0.0005f;
+	for (int k = 1; k < argc; k += 2) {
+		std::string const option = argv[k];
+		if (k + 1 == argc) {
+			if (rank == 0) {
+				std::cout << "Missing value for the option " << option << std::endl;
+				print_usage(argv[0]);
+			}
+			MPI_Finalize();
+			return 1;
+		}
+		float const value = static_cast<float>(std::atof(argv[k + 1]));
+		if (option == "--N") N = static_cast<int>(value);
+		else if (option == "--steps") N_step = static_cast<int>(value);
+		else if (option == "--dt") parameters.dt = value;
+		else if (option == "--K") parameters.K = value;
+		else if (option == "--mu") parameters.mu = value;
+		else if (option == "--check") check = value != 0;
+		else {
+			if (rank == 0) {
+				std::cout << "Unknown option " << option << std::endl;
+				print_usage(argv[0]);
+			}
+			MPI_Finalize();
+			return 1;
+		}
+	}
+	if (N < 2 * N_process || N_step < 1 || parameters.dt <= 0) {
+		if (rank == 0) {
+			std::cout << "Invalid options" << std::endl;
+			print_usage(argv[0]);
+		}
+		MPI_Finalize();
+		return 1;
+	}
+
+	// Every process builds the same initial cloth, and keeps its block
+	cloth_structure cloth;
+	constraint_structure constraint;
+	initialize_scenario(N, cloth, parameters, constraint);
+
+	cloth_distributed_decomposition decomposition;
+	decomposition.initialize(N, N_process);
+	cloth_distributed_block block;
+	block.initialize(decomposition, rank, cloth);
+	cloth_distributed_exchange exchange;
+
+	if (rank == 0)
+		std::cout << "Cloth of " << N << "x" << N << " vertices in " << decomposition.N_block_u << "x" << decomposition.N_block_v << " blocks" << std::endl;
+
+	MPI_Barrier(MPI_COMM_WORLD);
+	auto const t0 = std::chrono::steady_clock::now();
+	for (int k_step = 0; k_step < N_step; ++k_step)
+		cloth_distributed_step(block, exchange, MPI_COMM_WORLD, parameters, constraint, parameters.dt);
+	double const time_local = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+	double time = 0.0;
+	MPI_Reduce(&time_local, &time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+	bool const diverged = cloth_distributed_detect_divergence(block, MPI_COMM_WORLD);
+	cloth_distributed_gather(block, MPI_COMM_WORLD, 0, cloth);
+
+	int status = diverged ? 1 : 0;
+	if (rank == 0) {
+		int halo_size = 0;
+		for (cloth_distributed_halo const& h : block.halo)
+			halo_size += h.receive_buffer.size();
+		std::cout << N_step << " steps: " << time / N_step << " ms per step" << (diverged ? " (the simulation diverged)" : "") << ", halo of the process 0: " << halo_size << " vertices" << std::endl;
+
+		if (check) {
+			cloth_structure reference;
+			constraint_structure constraint_reference;
+			initialize_scenario(N, reference, parameters, constraint_reference);
+			auto const t1 = std::chrono::steady_clock::now();
+			for (int k_step = 0; k_step < N_step; ++k_step) {
+				reference.update_normal_grid();
+				simulation_compute_force(reference, parameters);
+				simulation_numerical_integration(reference, parameters, parameters.dt);
+				simulation_apply_constraints(reference, constraint_reference);
+			}
+			double const time_reference = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t1).count();
+
+			size_t const size = reference.position.size() * sizeof(cgp::vec3);
+			bool const identical = std::memcmp(cloth.position.data.data.data(), reference.position.data.data.data(), size) == 0
+				&& std::memcmp(cloth.velocity.data.data.data(), reference.velocity.data.data.data(), size) == 0;
+			std::cout << "Single process solver: " << time_reference / N_step << " ms per step, " << (identical ? "identical" : "DIFFERENT") << " cloth" << std::endl;
+			if (!identical)
+				status = 1;
+		}
+	}
+
+	MPI_Bcast(&status, 1, MPI_INT, 0, MPI_COMM_WORLD);
+	MPI_Finalize();
+	return status;
+}
@@ -0,0 +1,39 @@
+#include "cgp/cgp.hpp"
+#include "environment.hpp"
+#include "parameter_sweep/parameter_sweep.hpp"
+
+#include <iostream>
+
+// Headless parameter sweep of the cape simulation (no window is opened)
+//  Usage: parameter_sweep <sweep description> [output.csv]
+//  See tools/parameter_sweep/example_sweep.txt for the format of the description.
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2) {
+		std::cout << "Usage: " << argv[0] << " <sweep description> [output.csv]" << std::endl;
+		return 1;
+	}
+	std::string const filename_description = argv[1];
+	std::string const filename_output = argc > 2 ? argv[2] : "parameter_sweep.csv";
+
+	project::path = cgp::project_path_find(argv[0], "shaders/");
+
+	parameter_sweep_description description;
+	if (!parameter_sweep_load(filename_description, description))
+		return 1;
+
+	std::cout << "Load the animation " << description.settings.animation << std::endl;
+	cape_rig_clip const clip = cape_rig_load_clip(project::path + "assets/lola/", description.settings.animation);
+
+	std::vector<parameter_sweep_scenario> const scenarios = description.scenarios();
+	std::cout << "Run " << scenarios.size() << " scenarios of " << description.settings.duration << "s" << std::endl;
+	std::vector<parameter_sweep_result> results = parameter_sweep_run(scenarios, clip, description.settings);
+
+	std::vector<int> const order = parameter_sweep_rank(results, description.settings);
+	if (!parameter_sweep_write_csv(filename_output, description.settings.animation, scenarios, results, order))
+		return 1;
+
+	std::cout << "Ranked results written in " << filename_output << std::endl;
+	return 0;
+}
@@ -0,0 +1,143 @@
+#include "cgp/cgp.hpp"
+#include "environment.hpp"
+#include "cape_rig/cape_rig.hpp"
+#include "cloth_subspace/cloth_subspace.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+// Offline bake of the reduced-order cape of Lola (no window is opened)
+//  Usage: subspace <output.subspace> [--N 30] [--modes 24] [--regularization 1e-4] [--animations idle,walk,...] [--fps 30] [--duration 4] [--warmup 1] [--substeps 4] [--max_snapshots 600]
+//  The full simulation is run over each animation (all the animations of assets/lola/animation/ by default), the PCA basis and the reduced
+//  dynamics are fitted on the recorded frames, then the reduced cape is replayed on each animation and compared to the full simulation.
+//  The scene plays the basis assets/cloth_Lola.subspace (ex. subspace assets/cloth_Lola.subspace)
+
+static void print_usage(std::string const& executable)
+{
+	std::cout << "Usage: " << executable << " <output.subspace> [--N 30] [--modes 24] [--regularization 1e-4] [--animations idle,walk,...] [--fps 30] [--duration 4] [--warmup 1] [--substeps 4] [--max_snapshots 600]" << std::endl;
+}
+
+static std::vector<std::string> split(std::string const& text, char separator)
+{
+	std::vector<std::string> value;
+	std::stringstream stream(text);
+	std::string item;
+	while (std::getline(stream, item, separator))
+		if (!item.empty())
+			value.push_back(item);
+	return value;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2) {
+		print_usage(argv[0]);
+		return 1;
+	}
+	std::string const filename_output = argv[1];
+
+	cloth_subspace_record_settings settings;
+	int N_mode = 24;
+	float regularization = 1e-4f;
+	int max_snapshots = 600;
+	std::vector<std::string> animations = { "idle", "walk", "walk_style", "dance_1", "dance_2", "dance_3", "dance_4" };
+	simulation_parameters parameters;
+	for (int k = 2; k < argc; k += 2) {
+		std::string const option = argv[k];
+		if (k + 1 == argc) {
+			std::cout << "Missing value for the option " << option << std::endl;
+			print_usage(argv[0]);
+			return 1;
+		}
+		float const value = static_cast<float>(std::atof(argv[k + 1]));
+		if (option == "--N") settings.N_sample = static_cast<int>(value);
+		else if (option == "--modes") N_mode = static_cast<int>(value);
+		else if (option == "--regularization") regularization = value;
+		else if (option == "--animations") animations = split(argv[k + 1], ',');
+		else if (option == "--fps") settings.fps = value;
+		else if (option == "--duration") settings.duration = value;
+		else if (option == "--warmup") settings.warmup = value;
+		else if (option == "--substeps") settings.substeps = static_cast<int>(value);
+		else if (option == "--max_snapshots") max_snapshots = static_cast<int>(value);
+		else {
+			std::cout << "Unknown option " << option << std::endl;
+			print_usage(argv[0]);
+			return 1;
+		}
+	}
+	if (settings.N_sample <= 3 || N_mode < 1 || settings.fps <= 0 || settings.substeps < 1 || animations.empty() || max_snapshots < 2) {
+		std::cout << "Invalid options" << std::endl;
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	project::path = cgp::project_path_find(argv[0], "shaders/");
+
+	// Full simulation over the animations
+	std::vector<cape_rig_clip> clips;
+	std::vector<cloth_subspace_recording> recordings;
+	for (std::string const& animation : animations) {
+		std::cout << "Simulate the cape on " << animation << std::endl;
+		clips.push_back(cape_rig_load_clip(project::path + "assets/lola/", animation));
+		recordings.push_back({});
+		if (!cloth_subspace_record(clips.back(), parameters, settings, recordings.back())) {
+			std::cout << "The simulation diverged on " << animation << ": increase --substeps" << std::endl;
+			return 1;
+		}
+	}
+
+	std::cout << "Fit the reduced model" << std::endl;
+	cloth_subspace_basis const basis = cloth_subspace_build(recordings, 1.0f / settings.fps, settings.N_sample, N_mode, regularization, max_snapshots);
+	float variance_total = 0.0f;
+	for (int k = 0; k < basis.variance.size(); ++k)
+		variance_total += basis.variance[k];
+	std::cout << basis.N_mode << " modes, variance of the first one: " << 100 * basis.variance[0] / variance_total << "% of the kept variance" << std::endl;
+
+	if (!cloth_subspace_save(filename_output, basis)) {
+		std::cout << "Error while writing " << filename_output << std::endl;
+		return 1;
+	}
+
+	// Replay of each animation with the reduced cape, compared to the full simulation
+	cgp::numarray<cgp::mat4> joint_frames;
+	cgp::grid_2D<cgp::vec3> position;
+	for (size_t k_clip = 0; k_clip < clips.size(); ++k_clip) {
+		// The reduced cape starts at rest on the first pose, and settles on it as the full simulation did
+		clips[k_clip].evaluate(0.0f, joint_frames);
+		cloth_subspace_state state;
+		state.initialize(basis, joint_frames);
+		for (int k_step = 0; k_step * basis.dt < settings.warmup; ++k_step)
+			cloth_subspace_step(state, basis, joint_frames);
+
+		double error_max = 0.0, error_sum = 0.0, time_step_us = 0.0, time_reconstruct_us = 0.0;
+		int N_error = 0;
+		int const N_frame = static_cast<int>(recordings[k_clip].position.size());
+		for (int k_frame = 0; k_frame < N_frame; ++k_frame) {
+			clips[k_clip].evaluate(k_frame / settings.fps, joint_frames);
+			auto const t0 = std::chrono::steady_clock::now();
+			cloth_subspace_step(state, basis, joint_frames);
+			auto const t1 = std::chrono::steady_clock::now();
+			cloth_subspace_reconstruct(state, basis, joint_frames, position);
+			auto const t2 = std::chrono::steady_clock::now();
+			time_step_us += std::chrono::duration<double, std::micro>(t1 - t0).count();
+			time_reconstruct_us += std::chrono::duration<double, std::micro>(t2 - t1).count();
+
+			cgp::vec3 origin, e_x, e_y, e_z;
+			cape_rig_body_frame(joint_frames, origin, e_x, e_y, e_z);
+			cgp::numarray<float> const& full = recordings[k_clip].position[k_frame];
+			for (int k = 0; k < position.size(); ++k) {
+				cgp::vec3 const p_full = origin + full[3 * k] * e_x + full[3 * k + 1] * e_y + full[3 * k + 2] * e_z;
+				double const error = cgp::norm(position.data[k] - p_full);
+				error_max = std::max(error_max, error);
+				error_sum += error;
+				N_error++;
+			}
+		}
+		std::cout << "  " << clips[k_clip].name << ": error mean " << error_sum / std::max(N_error, 1) << " m, max " << error_max << " m - "
+			<< time_step_us / N_frame << " us per step, " << time_reconstruct_us / N_frame << " us per reconstruction" << std::endl;
+	}
+
+	std::cout << "Reduced cape written in " << filename_output << std::endl;
+	return 0;
+}